@@ -0,0 +1,64 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <kernel/ally.h>
+#include <kernel/faction.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Measures alliedfaction in a synthetic world: every faction has HELP
+ * set for many others, as in a game with big alliances. */
+
+#define NUMFACTIONS 3000
+#define NUMALLIES 200
+#define LOOKUPS 10000000
+
+static double seconds(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+    static faction *factions[NUMFACTIONS];
+    int i, lookups = LOOKUPS;
+    long long found = 0;
+    clock_t start;
+
+    if (argc > 1) {
+        lookups = atoi(argv[1]);
+    }
+    srand(2024);
+    for (i = 0; i != NUMFACTIONS; ++i) {
+        factions[i] = faction_create(i + 1);
+    }
+    start = clock();
+    for (i = 0; i != NUMFACTIONS; ++i) {
+        int a;
+        for (a = 0; a != NUMALLIES; ++a) {
+            faction *f2 = factions[rand() % NUMFACTIONS];
+            if (f2 != factions[i]) {
+                ally_set(&factions[i]->allies, f2, HELP_ALL);
+            }
+        }
+    }
+    printf("ally_set: %d factions with %d allies in %.3fs\n",
+        NUMFACTIONS, NUMALLIES, seconds(start));
+
+    start = clock();
+    for (i = 0; i != lookups; ++i) {
+        const faction *f1 = factions[rand() % NUMFACTIONS];
+        const faction *f2 = factions[rand() % NUMFACTIONS];
+        if (alliedfaction(f1, f2, HELP_FIGHT)) {
+            ++found;
+        }
+    }
+    printf("alliedfaction: %d lookups, %lld allied, in %.3fs\n",
+        lookups, found, seconds(start));
+
+    free_factions();
+    return 0;
+}
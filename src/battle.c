@@ -56,6 +56,7 @@
 #include "util/stats.h"
 #include "util/rand.h"
 #include "util/rng.h"
+#include "util/workers.h"
 
 #include <strings.h>
 #include <selist.h>
@@ -70,6 +71,7 @@
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #define BASE_CHANCE    70       /* 70% Basis-Ueberlebenschance */
@@ -86,6 +88,8 @@ typedef enum combatmagic {
 #define MINSPELLRANGE 1
 #define MAXSPELLRANGE 7
 
+#define BATTLE_RNG_STEP -1      /* rng stream step id for battles */
+
 #define ROW_FACTOR 3            /* factor for combat row advancement rule */
 #define EFFECT_PANIC_SPELL 25
 #define TROLL_REGENERATION 0.10
@@ -108,6 +112,20 @@ const troop no_troop = { 0, 0 };
 #define DAMAGE_SKILL_BONUS   (1<<4)
 
 static int max_turns;
+
+battle_timing *battle_timer;
+
+static double timer_lap(double *total, double start)
+{
+    double now = (double)clock() / CLOCKS_PER_SEC;
+    *total += now - start;
+    return now;
+}
+
+static double timer_start(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
 static int rule_damage;
 static int rule_loot;
 static double loot_divisor;
@@ -126,12 +144,17 @@ static int rule_nat_armor;
 static int rule_cavalry_mode;
 static int rule_vampire;
 static const item_type *it_mistletoe;
+static const race *rc_halfling, *rc_goblin;
 
 /** initialize rules from configuration.
+ * anything the combat rounds look up lazily belongs here, since the
+ * rounds of different battles may run on different threads.
  */
 static void init_rules(void)
 {
     it_mistletoe = it_find("mistletoe");
+    rc_halfling = get_race(RC_HALFLING);
+    rc_goblin = get_race(RC_GOBLIN);
 
     flee_chance_skill_bonus = config_get_int("rules.combat.flee_chance_bonus", 5);
     flee_chance_base = config_get_int("rules.combat.flee_chance_base", 20);
@@ -171,8 +194,8 @@ static int army_index(const side * s)
 const char *sidename(const side * s)
 {
 #define SIDENAMEBUFLEN 256
-    static int bufno;             /* STATIC_XCALL: used across calls */
-    static char sidename_buf[4][SIDENAMEBUFLEN];  /* STATIC_RESULT: used for return, not across calls */
+    static THREAD_LOCAL int bufno;             /* STATIC_XCALL: used across calls */
+    static THREAD_LOCAL char sidename_buf[4][SIDENAMEBUFLEN];  /* STATIC_RESULT: used for return, not across calls */
 
     bufno = bufno % 4;
     str_strlcpy(sidename_buf[bufno], factionname(s->stealthfaction ? s->stealthfaction : s->bf->faction), SIDENAMEBUFLEN);
@@ -181,7 +204,7 @@ const char *sidename(const side * s)
 
 static const char *sideabkz(side * s, bool truename)
 {
-    static char sideabkz_buf[8];  /* STATIC_RESULT: used for return, not across calls */
+    static THREAD_LOCAL char sideabkz_buf[8];  /* STATIC_RESULT: used for return, not across calls */
     const faction *f = (s->stealthfaction
         && !truename) ? s->stealthfaction : s->bf->faction;
 
@@ -189,11 +212,17 @@ static const char *sideabkz(side * s, bool truename)
     return sideabkz_buf;
 }
 
-void battle_message_faction(battle * b, faction * f, struct message *m)
-{
-    region *r = b->region;
+/* battle messages held back while battles are resolved in parallel */
+typedef struct battle_message {
+    region *r;
+    faction *f;
+    message *m;
+} battle_message;
 
-    assert(f);
+static THREAD_LOCAL battle_message **deferred_messages;
+
+static void add_battle_message(region *r, faction *f, message *m)
+{
     if (f->battles == NULL || f->battles->r != r) {
         struct bmsg *bm = (struct bmsg *)calloc(1, sizeof(struct bmsg));
         assert(bm);
@@ -204,6 +233,20 @@ void battle_message_faction(battle * b, faction * f, struct message *m)
     add_message(&f->battles->msgs, m);
 }
 
+void battle_message_faction(battle * b, faction * f, struct message *m)
+{
+    assert(f);
+    if (deferred_messages) {
+        battle_message *bm = arraddnptr(*deferred_messages, 1);
+        bm->r = b->region;
+        bm->f = f;
+        bm->m = msg_addref(m);
+    }
+    else {
+        add_battle_message(b->region, f, m);
+    }
+}
+
 void message_all(battle * b, message * m)
 {
     bfaction *bf;
@@ -214,9 +257,11 @@ void message_all(battle * b, message * m)
     }
 }
 
+static mt_handle mh_battle_msg = MT_HANDLE("battle_msg", "string");
+
 static void fbattlerecord(battle * b, faction * f, const char *s)
 {
-    message *m = msg_message("battle_msg", "string", s);
+    message *m = msg_handle(&mh_battle_msg, s);
     battle_message_faction(b, f, m);
     msg_release(m);
 }
@@ -436,28 +481,35 @@ static int get_row(const side * s, int row, const side * vs)
     return result;
 }
 
-int get_unitrow(const fighter * af, const side * vs)
+/* the row that fighters of side s with status row 'row' fight in */
+static int side_unitrow(const side * s, int row, const side * vs)
 {
-    int row = statusrow(af->status);
     if (vs == NULL) {
         int i;
         for (i = FIGHT_ROW; i != row; ++i) {
-            if (af->side->size[i]) {
+            if (s->size[i]) {
                 break;
             }
         }
         return FIGHT_ROW + (row - i);
     }
-    return get_row(af->side, row, vs);
+    return get_row(s, row, vs);
 }
 
+int get_unitrow(const fighter * af, const side * vs)
+{
+    return side_unitrow(af->side, statusrow(af->status), vs);
+}
+
+static mt_handle mh_casualties = MT_HANDLE("casualties", "unit runto run alive fallen");
+
 static void reportcasualties(battle * b, fighter * fig, int dead)
 {
     struct message *m;
     region *r = NULL;
     if (fig->alive == fig->unit->number)
         return;
-    m = msg_message("casualties", "unit runto run alive fallen",
+    m = msg_handle(&mh_casualties,
         fig->unit, r, fig->run.number, fig->alive, dead);
     message_all(b, m);
     msg_release(m);
@@ -837,6 +889,94 @@ bool meffect_blocked(battle * b, meffect * s, side * as)
     return false;
 }
 
+/* select_enemy picks the n-th troop of a side, counting in the order of
+ * its fighters list. For every status row, a side keeps a Fenwick tree of
+ * the troops each fighter has left, so that counting and picking do not
+ * walk the list. The trees are built on first use, and again after
+ * side_troops_changed. */
+static void side_index(side * s)
+{
+    fighter *fig;
+    int row, i, n;
+
+    if (arrlen(s->order) > 0) {
+        return;
+    }
+    for (fig = s->fighters; fig; fig = fig->next) {
+        fig->order = (int)arrlen(s->order);
+        arrput(s->order, fig);
+    }
+    n = (int)arrlen(s->order);
+    for (row = FIRST_ROW; row != NUMROWS; ++row) {
+        arrsetlen(s->troops[row], n + 1);
+        memset(s->troops[row], 0, sizeof(int) * (n + 1));
+        s->available[row] = 0;
+    }
+    for (i = 0; i != n; ++i) {
+        fig = s->order[i];
+        row = statusrow(fig->status);
+        s->troops[row][i + 1] = fig->alive - fig->removed;
+        s->available[row] += fig->alive - fig->removed;
+    }
+    for (row = FIRST_ROW; row != NUMROWS; ++row) {
+        int *tree = s->troops[row];
+        for (i = 1; i <= n; ++i) {
+            int parent = i + (i & -i);
+            if (parent <= n) {
+                tree[parent] += tree[i];
+            }
+        }
+    }
+}
+
+void side_troops_changed(side * s)
+{
+    arrsetlen(s->order, 0);
+}
+
+static void troops_changed(fighter * fig, int delta)
+{
+    side *s = fig->side;
+    int n = (int)arrlen(s->order);
+    if (n > 0) {
+        int row = statusrow(fig->status);
+        int *tree = s->troops[row];
+        int i;
+        for (i = fig->order + 1; i <= n; i += (i & -i)) {
+            tree[i] += delta;
+        }
+        s->available[row] += delta;
+    }
+}
+
+/* the fighter with the n-th troop in one of the rows, n is replaced by
+ * the index of that troop */
+static fighter *side_select(const side * s, const bool rows[], int *n)
+{
+    int len = (int)arrlen(s->order);
+    int pos = 0, step = 1;
+
+    while (step * 2 <= len) {
+        step *= 2;
+    }
+    for (; step; step /= 2) {
+        int next = pos + step;
+        if (next <= len) {
+            int row, sum = 0;
+            for (row = FIRST_ROW; row != NUMROWS; ++row) {
+                if (rows[row]) {
+                    sum += s->troops[row][next];
+                }
+            }
+            if (sum <= *n) {
+                pos = next;
+                *n -= sum;
+            }
+        }
+    }
+    return (pos < len) ? s->order[pos] : NULL;
+}
+
 /* rmfighter wird schon im PRAECOMBAT gebraucht, da gibt es noch keine
  * troops */
 void reduce_fighter(fighter * df, int i)
@@ -863,6 +1003,7 @@ void reduce_fighter(fighter * df, int i)
 
     /* und die Einheit selbst aktualisieren */
     df->alive -= i;
+    troops_changed(df, -i);
 }
 
 void flee_all(fighter *fig)
@@ -899,6 +1040,7 @@ void remove_troop(troop dt)
 
     ++df->removed;
     ++df->side->removed;
+    troops_changed(df, -1);
     df->person[dt.index] = df->person[df->alive - df->removed];
     df->person[df->alive - df->removed] = p;
 }
@@ -916,9 +1058,28 @@ void kill_troop(troop dt)
         if (drops != NULL) {
             i_merge(&du->items, &drops);
         }
-        sprintf(eqname, "spo_%s", rc->_name);
+        if (df->side->battle->defer_spoils) {
+            arrput(df->side->battle->spoils, du);
+        }
+        else {
+            sprintf(eqname, "spo_%s", rc->_name);
+            equip_unit_mask(du, eqname, EQUIP_ITEMS);
+        }
+    }
+}
+
+/* The equipment callback may run Lua, which only the main thread can
+ * do, so battles on the worker pool leave it until they are finished. */
+static void equip_spoils(battle *b)
+{
+    ptrdiff_t i, len = arrlen(b->spoils);
+    for (i = 0; i != len; ++i) {
+        unit *du = b->spoils[i];
+        char eqname[64];
+        sprintf(eqname, "spo_%s", u_race(du)->_name);
         equip_unit_mask(du, eqname, EQUIP_ITEMS);
     }
+    arrfree(b->spoils);
 }
 
 /** reduces the target's exp by an equivalent of n points learning
@@ -997,11 +1158,6 @@ static int rc_specialdamage(const unit *au, const unit *du, const struct weapon_
     int modifier = 0;
     if (wtype != NULL) {
         if (fval(u_race(du), RCF_DRAGON)) {
-            static int cache;
-            static const race *rc_halfling;
-            if (rc_changed(&cache)) {
-                rc_halfling = get_race(RC_HALFLING);
-            }
             if (ar == rc_halfling) {
                 modifier += 5;
             }
@@ -1141,6 +1297,8 @@ static void demon_dazzle(fighter *af, troop dt) {
     }
 }
 
+static mt_handle mh_potionsave = MT_HANDLE("potionsave", "unit");
+
 static bool survives(fighter *af, troop dt, battle *b) {
     const fighter *df = dt.fighter;
     const unit* du = df->unit;
@@ -1159,7 +1317,7 @@ static bool survives(fighter *af, troop dt, battle *b) {
 
     /* healing potions can avert a killing blow */
     if (resurrect_troop(dt)) {
-        message *m = msg_message("potionsave", "unit", du);
+        message *m = msg_handle(&mh_potionsave, du);
         battle_message_faction(b, du->faction, m);
         msg_release(m);
         return true;
@@ -1345,30 +1503,19 @@ terminate(troop dt, troop at, int type, const char *damage_formula, bool missile
 }
 
 static int
-count_side(const side * s, const side * vs, int minrow, int maxrow, int select)
+count_side(side * s, const side * vs, int minrow, int maxrow, int select)
 {
-    fighter *fig;
-    int people = 0;
-    int unitrow[NUMROWS];
+    int row, people = 0;
 
     if (maxrow < FIGHT_ROW)
         return 0;
-    if (select & SELECT_ADVANCE) {
-        memset(unitrow, -1, sizeof(unitrow));
-    }
-
-    for (fig = s->fighters; fig; fig = fig->next) {
-        if (fig->alive - fig->removed > 0) {
-            int row = statusrow(fig->status);
-            if (select & SELECT_ADVANCE) {
-                if (unitrow[row] == -1) {
-                    unitrow[row] = get_unitrow(fig, vs);
-                }
-                row = unitrow[row];
-            }
-            if (row >= minrow && row <= maxrow) {
-                people += fig->alive - fig->removed;
-                if (people > 0 && (select & SELECT_FIND))
+    side_index(s);
+    for (row = FIRST_ROW; row != NUMROWS; ++row) {
+        if (s->available[row] > 0) {
+            int r = (select & SELECT_ADVANCE) ? side_unitrow(s, row, vs) : row;
+            if (r >= minrow && r <= maxrow) {
+                people += s->available[row];
+                if (select & SELECT_FIND)
                     break;
             }
         }
@@ -1438,9 +1585,7 @@ troop select_enemy(fighter * af, int minrow, int maxrow, int select)
     battle *b = as->battle;
     int selected, enemies;
     size_t si, sl = arrlen(b->sides);
-#ifdef DEBUG_SELECT
-    troop result = no_troop;
-#endif
+
     if (u_race(af->unit)->flags & RCF_FLY) {
         /* flying races ignore min- and maxrow and can attack anyone fighting
          * them */
@@ -1461,55 +1606,39 @@ troop select_enemy(fighter * af, int minrow, int maxrow, int select)
     for (si = 0; si != sl; ++si) {
         side *ds = b->sides[si];
         if (enemy(as, ds)) {
-            fighter* df;
-            int unitrow[NUMROWS] = { 0 };
-            int offset = 0;
+            bool rows[NUMROWS] = { false };
+            int row, count = 0, offset = 0;
 
             if (select & SELECT_DISTANCE)
                 offset = get_unitrow(af, ds) - FIGHT_ROW;
 
-            for (df = ds->fighters; df; df = df->next) {
-                int dr;
-
-                dr = statusrow(df->status);
+            side_index(ds);
+            for (row = FIRST_ROW; row != NUMROWS; ++row) {
+                int dr = row;
                 if (select & SELECT_ADVANCE) {
-                    if (unitrow[dr] == 0) {
-                        unitrow[dr] = get_unitrow(df, as);
-                    }
-                    dr = unitrow[dr];
+                    dr = side_unitrow(ds, row, as);
                 }
-
                 if (select & SELECT_DISTANCE)
                     dr += offset;
-                if (dr < minrow || dr > maxrow)
-                    continue;
-                if (df->alive - df->removed > selected) {
-#ifdef DEBUG_SELECT
-                    if (result.fighter == NULL) {
-                        result.index = selected;
-                        result.fighter = df;
-                    }
-#else
-                    troop dt;
-                    dt.index = selected;
-                    dt.fighter = df;
+                if (dr >= minrow && dr <= maxrow) {
+                    rows[row] = true;
+                    count += ds->available[row];
+                }
+            }
+            if (count > selected) {
+                troop dt;
+                dt.fighter = side_select(ds, rows, &selected);
+                dt.index = selected;
+                if (dt.fighter) {
                     return dt;
-#endif
                 }
-                selected -= (df->alive - df->removed);
-                enemies -= (df->alive - df->removed);
+                break;
             }
+            selected -= count;
         }
     }
-    if (enemies != 0) {
-        log_error("select_enemies has a bug.\n");
-    }
-#ifdef DEBUG_SELECT
-    return result;
-#else
-    assert(!selected);
+    log_error("select_enemies has a bug.\n");
     return no_troop;
-#endif
 }
 
 int get_tactics(const side * as, const side * ds)
@@ -1636,9 +1765,11 @@ selist *fighters(battle * b, const side * vs, int minrow, int maxrow, int mask)
     return select_fighters(b, vs, mask, select_row, &sel);
 }
 
+static mt_handle mh_spell_failed = MT_HANDLE("spell_failed", "unit spell");
+
 static void report_failed_spell(struct battle * b, struct unit * mage, const struct spell *sp)
 {
-    message *m = msg_message("spell_failed", "unit spell", mage, sp);
+    message *m = msg_handle(&mh_spell_failed, mage, sp);
     message_all(b, m);
     msg_release(m);
 }
@@ -1879,14 +2010,8 @@ int skilldiff(troop at, troop dt, int dist)
     unit *au = af->unit, *du = df->unit;
     int is_protected = 0, skdiff = 0;
     const weapon *awp = select_weapon(at, true, dist > 1);
-    static int rc_cache;
-    static const race *rc_halfling, *rc_goblin;
     const weapon_type *wtype;
 
-    if (rc_changed(&rc_cache)) {
-        rc_halfling = get_race(RC_HALFLING);
-        rc_goblin = get_race(RC_GOBLIN);
-    }
     skdiff += af->person[at.index].attack;
     skdiff -= df->person[dt.index].defense;
 
@@ -2129,7 +2254,14 @@ static void attack(battle * b, troop ta, const att * a, int numattack)
              * Kampfzauber zu schleudern: */
             if (count_enemies(b, af, melee_range[0], missile_range[1],
                 SELECT_ADVANCE | SELECT_DISTANCE | SELECT_FIND)) {
-                do_combatspell(ta);
+                if (battle_timer) {
+                    double t = timer_start();
+                    do_combatspell(ta);
+                    timer_lap(&battle_timer->spells, t);
+                }
+                else {
+                    do_combatspell(ta);
+                }
             }
         }
         break;
@@ -2260,6 +2392,8 @@ static void attack(battle * b, troop ta, const att * a, int numattack)
     }
 }
 
+static mt_handle mh_killed_battle = MT_HANDLE("killed_battle", "unit dead");
+
 static void do_attack(fighter * af)
 {
     unit *au = af->unit;
@@ -2322,7 +2456,7 @@ static void do_attack(fighter * af)
                 callbacks.report_special_attacks(af, wtype->itype);
             }
         }
-        m = msg_message("killed_battle", "unit dead", au, af->special.kills);
+        m = msg_handle(&mh_killed_battle, au, af->special.kills);
         message_all(b, m);
         msg_release(m);
         af->special.kills = 0;
@@ -2627,8 +2761,13 @@ static void reorder_fleeing(region * r)
         }
     }
     *udst = NULL;
+    units_moved(r);
 }
 
+static mt_handle mh_killsandhits = MT_HANDLE("killsandhits", "unit hits kills");
+static mt_handle mh_army_report = MT_HANDLE("army_report", "index abbrev dead fled survived");
+static mt_handle mh_battle_loot = MT_HANDLE("battle_loot", "unit amount item");
+
 static void aftermath(battle * b)
 {
     region *r = b->region;
@@ -2655,7 +2794,7 @@ static void aftermath(battle * b)
             }
             if (df->hits + df->kills) {
                 struct message *m =
-                    msg_message("killsandhits", "unit hits kills", du, df->hits,
+                    msg_handle(&mh_killsandhits, du, df->hits,
                         df->kills);
                 battle_message_faction(b, du->faction, m);
                 msg_release(m);
@@ -2664,7 +2803,14 @@ static void aftermath(battle * b)
     }
 
     /* POSTCOMBAT */
-    do_combatmagic(b, DO_POSTCOMBATSPELL);
+    if (battle_timer) {
+        double t = timer_start();
+        do_combatmagic(b, DO_POSTCOMBATSPELL);
+        timer_lap(&battle_timer->magic, t);
+    }
+    else {
+        do_combatmagic(b, DO_POSTCOMBATSPELL);
+    }
 
     for (si = 0; si != sl; ++si) {
         side *s = b->sides[si];
@@ -2730,6 +2876,7 @@ static void aftermath(battle * b)
                 else {
                     /* nur teilweise geflohene Einheiten mergen sich wieder */
                     df->alive += df->run.number;
+                    troops_changed(df, df->run.number);
                     s->size[0] += df->run.number;
                     s->size[statusrow(df->status)] += df->run.number;
                     s->alive += df->run.number;
@@ -2789,11 +2936,9 @@ static void aftermath(battle * b)
 
     for (si = 0; si != sl; ++si) {
         side *s = b->sides[si];
-        message *seen = msg_message("army_report",
-            "index abbrev dead fled survived",
+        message *seen = msg_handle(&mh_army_report,
             army_index(s), sideabkz(s, false), s->dead, s->flee, s->alive);
-        message *unseen = msg_message("army_report",
-            "index abbrev dead fled survived",
+        message *unseen = msg_handle(&mh_army_report,
             army_index(s), "-?-", s->dead, s->flee, s->alive);
 
         for (bf = b->factions; bf; bf = bf->next) {
@@ -2823,7 +2968,7 @@ static void aftermath(battle * b)
             for (l = df->loot; l; l = l->next) {
                 const item_type *itype = l->type;
                 message *m =
-                    msg_message("battle_loot", "unit amount item", du, l->number,
+                    msg_handle(&mh_battle_loot, du, l->number,
                         itype->rtype);
                 battle_message_faction(b, du->faction, m);
                 msg_release(m);
@@ -2889,6 +3034,8 @@ static void spunit(const struct faction* f, const unit* u,
     bufunit(f, u, of, seen_battle, anon, sbp);
 }
 
+static mt_handle mh_battle_fighter = MT_HANDLE("battle_fighter", "string unit");
+
 static void battle_punit(unit * u, battle * b)
 {
     bfaction *bf;
@@ -2901,13 +3048,15 @@ static void battle_punit(unit * u, battle * b)
         sbs_init(&sbs, buf, sizeof(buf));
         spunit(f, u, &sbs);
         if (sbs.begin != sbs.end) {
-            message* m = msg_message("battle_fighter", "string unit", buf, u);
+            message* m = msg_handle(&mh_battle_fighter, buf, u);
             battle_message_faction(b, f, m);
             msg_release(m);
         }
     }
 }
 
+static mt_handle mh_battle_row = MT_HANDLE("battle_row", "row");
+
 static void print_fighters(battle * b, const side * s)
 {
     fighter *df;
@@ -2922,7 +3071,7 @@ static void print_fighters(battle * b, const side * s)
 
             if (row == thisrow) {
                 if (m == NULL) {
-                    m = msg_message("battle_row", "row", row);
+                    m = msg_handle(&mh_battle_row, row);
                     message_all(b, m);
                 }
                 battle_punit(du, b);
@@ -2943,6 +3092,8 @@ static void set_attacker(fighter * fig)
     fset(fig, FIG_ATTACKER);
 }
 
+static mt_handle mh_para_army_index = MT_HANDLE("para_army_index", "index name faction");
+
 static struct message * army_message(const battle* b, const faction* f, const side* s)
 {
     const char* sname;
@@ -2952,9 +3103,12 @@ static struct message * army_message(const battle* b, const faction* f, const si
     fv = seematrix(f, s) ? s->bf->faction : s->stealthfaction;
     sname = fv ? sidename(s) : LOC(f->locale, "unknown_faction");
 
-    return msg_message("para_army_index", "index name faction", army_index(s), sname, fv);
+    return msg_handle(&mh_para_army_index, army_index(s), sname, fv);
 }
 
+static mt_handle mh_para_tactics_lost = MT_HANDLE("para_tactics_lost", "unit");
+static mt_handle mh_para_tactics_won = MT_HANDLE("para_tactics_won", "unit");
+
 /*
  * Besten Taktiker ermitteln
  */
@@ -2984,10 +3138,10 @@ void init_tactics(battle* b)
                     unit* u = tf->unit;
                     message* m = NULL;
                     if (!is_attacker(tf)) {
-                        m = msg_message("para_tactics_lost", "unit", u);
+                        m = msg_handle(&mh_para_tactics_lost, u);
                     }
                     else {
-                        m = msg_message("para_tactics_won", "unit", u);
+                        m = msg_handle(&mh_para_tactics_won, u);
                     }
                     message_all(b, m);
                     msg_release(m);
@@ -3309,6 +3463,7 @@ fighter *make_fighter(battle * b, unit * u, side * s1, bool attack)
 
     fig->next = s1->fighters;
     s1->fighters = fig;
+    side_troops_changed(s1);
 
     fig->unit = u;
     /* In einer Burg muss man a) nicht Angreifer sein, und b) drin sein, und
@@ -3482,7 +3637,12 @@ bool join_battle(battle * b, unit * u, bool attack, fighter ** cp)
 
 static void free_side(side * si)
 {
+    int row;
     arrfree(si->leader.fighters);
+    arrfree(si->order);
+    for (row = 0; row != NUMROWS; ++row) {
+        arrfree(si->troops[row]);
+    }
 }
 
 static void free_fighter(fighter * fig)
@@ -3524,6 +3684,9 @@ static int *get_alive(side * s)
     return s->size;
 }
 
+static mt_handle mh_para_lineup_battle = MT_HANDLE("para_lineup_battle", "turn");
+static mt_handle mh_para_after_battle = MT_HANDLE("para_after_battle", "");
+
 static int battle_report(battle * b)
 {
     bool cont = false;
@@ -3557,9 +3720,9 @@ static int battle_report(battle * b)
         bool komma = false;
 
         if (cont)
-            m = msg_message("para_lineup_battle", "turn", b->turn);
+            m = msg_handle(&mh_para_lineup_battle, b->turn);
         else
-            m = msg_message("para_after_battle", "");
+            m = msg_handle(&mh_para_after_battle);
         battle_message_faction(b, fac, m);
         msg_release(m);
 
@@ -3949,6 +4112,7 @@ void free_battle(battle* b)
     }
 
     hmfree(b->relations);
+    arrfree(b->spoils);
     selist_foreach(b->meffects, free);
     selist_free(b->meffects);
 
@@ -4081,6 +4245,9 @@ static bool is_enemy(battle *b, unit *u1, unit *u2) {
     return false;
 }
 
+static mt_handle mh_force_leave_building = MT_HANDLE("force_leave_building", "unit owner building");
+static mt_handle mh_force_leave_ship = MT_HANDLE("force_leave_ship", "unit owner ship");
+
 void force_leave(region *r, battle *b) {
     unit *u;
 
@@ -4102,10 +4269,10 @@ void force_leave(region *r, battle *b) {
             if (leave(u, true)) {
                 message *msg;
                 if (uo->building) {
-                    msg = msg_message("force_leave_building", "unit owner building", u, uo, uo->building);
+                    msg = msg_handle(&mh_force_leave_building, u, uo, uo->building);
                 }
                 else {
-                    msg = msg_message("force_leave_ship", "unit owner ship", u, uo, uo->ship);
+                    msg = msg_handle(&mh_force_leave_ship, u, uo, uo->ship);
                 }
                 add_message(&u->faction->msgs, msg);
                 add_message(&uo->faction->msgs, msg);
@@ -4116,28 +4283,13 @@ void force_leave(region *r, battle *b) {
 }
 
 
-static void do_battle(region * r) {
-    battle *b = NULL;
+/* everything from the arrival of all fighters up to the first round */
+static void begin_battle(battle * b)
+{
+    region *r = b->region;
     ship *sh;
-    bool fighting = start_battle(r, &b);
     size_t si, sl;
 
-    if (b == NULL)
-        return;
-
-    /* Bevor wir die alliierten hineinziehen, sollten wir schauen, *
-     * Ob jemand fliehen kann. Dann eruebrigt sich das ganze ja
-     * vielleicht schon. */
-    report_battle_start(b);
-    if (!fighting) {
-        /* Niemand mehr da, Kampf kann nicht stattfinden. */
-        message *m = msg_message("aborted_battle", "");
-        message_all(b, m);
-        msg_release(m);
-        free_battle(b);
-        return;
-    }
-    join_allies(b);
     make_heroes(b);
 
     /* statistics are fun */
@@ -4164,19 +4316,69 @@ static void do_battle(region * r) {
     }
 
     /* PRECOMBATSPELLS */
-    do_combatmagic(b, DO_PRECOMBATSPELL);
+    if (battle_timer) {
+        double t = timer_start();
+        do_combatmagic(b, DO_PRECOMBATSPELL);
+        timer_lap(&battle_timer->magic, t);
+    }
+    else {
+        do_combatmagic(b, DO_PRECOMBATSPELL);
+    }
 
     print_stats(b);               /* gibt die Kampfaufstellung aus */
     init_tactics(b);
+}
+
+static mt_handle mh_aborted_battle = MT_HANDLE("aborted_battle", "");
+
+/* everything up to the first combat round */
+static battle *prepare_battle(region * r) {
+    battle *b = NULL;
+    bool fighting = start_battle(r, &b);
+
+    if (b == NULL)
+        return NULL;
+
+    /* Bevor wir die alliierten hineinziehen, sollten wir schauen, *
+     * Ob jemand fliehen kann. Dann eruebrigt sich das ganze ja
+     * vielleicht schon. */
+    report_battle_start(b);
+    if (!fighting) {
+        /* Niemand mehr da, Kampf kann nicht stattfinden. */
+        message *m = msg_handle(&mh_aborted_battle);
+        message_all(b, m);
+        msg_release(m);
+        free_battle(b);
+        return NULL;
+    }
+    join_allies(b);
+    begin_battle(b);
     log_debug("battle in %s (%d, %d) : ", regionname(r, 0), r->x, r->y);
+    return b;
+}
 
+static void fight_battle(battle * b) {
     for (; battle_report(b) && b->turn <= max_turns; ++b->turn) {
-        battle_flee(b);
-        battle_update(b);
-        battle_attacks(b);
-
+        if (battle_timer) {
+            double t = timer_start();
+            battle_flee(b);
+            t = timer_lap(&battle_timer->flee, t);
+            battle_update(b);
+            t = timer_lap(&battle_timer->update, t);
+            battle_attacks(b);
+            timer_lap(&battle_timer->attacks, t);
+            ++battle_timer->rounds;
+        }
+        else {
+            battle_flee(b);
+            battle_update(b);
+            battle_attacks(b);
+        }
     }
+}
 
+static void finish_battle(battle * b) {
+    equip_spoils(b);
     /* Auswirkungen berechnen: */
     aftermath(b);
     if (rule_force_leave(FORCE_LEAVE_POSTCOMBAT)) {
@@ -4188,10 +4390,141 @@ static void do_battle(region * r) {
     free_battle(b);
 }
 
+void battle_run(battle * b) {
+    init_rules();
+    begin_battle(b);
+    fight_battle(b);
+    finish_battle(b);
+}
+
+static void do_battle(region * r) {
+    battle *b = prepare_battle(r);
+    if (b) {
+        fight_battle(b);
+        finish_battle(b);
+    }
+}
+
+/* combat rounds that cannot cast spells do not create units or touch
+ * anything outside of their region, so they can run on the worker pool */
+static bool is_isolated_battle(const battle * b) {
+    size_t si, sl = arrlen(b->sides);
+
+    for (si = 0; si != sl; ++si) {
+        const side *s = b->sides[si];
+        const fighter *fig;
+        for (fig = s->fighters; fig; fig = fig->next) {
+            const race *rc = u_race(fig->unit);
+            int a;
+            if (fig->magic > 0) {
+                return false;
+            }
+            for (a = 0; a != RACE_ATTACKS; ++a) {
+                if (rc->attack[a].type == AT_SPELL) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+typedef struct battle_job {
+    region *r;
+    battle *b;
+    bool isolated;
+    rng_stream rng;
+    message_buffer msgs;
+    battle_message *bmsgs;
+} battle_job;
+
+static void begin_battle_job(battle_job *job) {
+    rng_stream_begin(&job->rng);
+    msg_defer_begin(&job->msgs);
+    deferred_messages = &job->bmsgs;
+}
+
+static void end_battle_job(void) {
+    deferred_messages = NULL;
+    msg_defer_end();
+    rng_stream_end();
+}
+
+static void fight_battle_job(int index, void *udata) {
+    battle_job *job = (battle_job *)udata + index;
+    if (job->isolated) {
+        begin_battle_job(job);
+        fight_battle(job->b);
+        end_battle_job();
+    }
+}
+
+/* Every battle draws from its own random stream, and holds back its
+ * messages until the end. Setup, spellcasting rounds and aftermath run
+ * in region order on the main thread, the remaining combat rounds run on
+ * the worker pool. The result does not depend on the number of threads. */
+static void do_battles_parallel(void) {
+    region *r;
+    battle_job *jobs;
+    int i, njobs = 0;
+
+    for (r = regions; r; r = r->next) {
+        ++njobs;
+    }
+    jobs = calloc(njobs, sizeof(battle_job));
+    if (!jobs) abort();
+    for (i = 0, r = regions; r; r = r->next, ++i) {
+        battle_job *job = jobs + i;
+        job->r = r;
+        rng_stream_init(&job->rng, BATTLE_RNG_STEP, r->uid);
+        begin_battle_job(job);
+        job->b = prepare_battle(r);
+        if (job->b) {
+            job->b->defer_spoils = true;
+            job->isolated = is_isolated_battle(job->b);
+        }
+        end_battle_job();
+    }
+    workers_run(njobs, fight_battle_job, jobs);
+    /* the workers have changed units this thread may remember */
+    effskill_memo_begin();
+    units_moved(NULL);
+    for (i = 0; i != njobs; ++i) {
+        battle_job *job = jobs + i;
+        ptrdiff_t m, nmsgs;
+
+        begin_battle_job(job);
+        if (job->b) {
+            if (!job->isolated) {
+                fight_battle(job->b);
+            }
+            finish_battle(job->b);
+        }
+        end_battle_job();
+        nmsgs = arrlen(job->bmsgs);
+        for (m = 0; m != nmsgs; ++m) {
+            battle_message *bm = job->bmsgs + m;
+            add_battle_message(bm->r, bm->f, bm->m);
+            msg_release(bm->m);
+        }
+        arrfree(job->bmsgs);
+        msg_defer_flush(&job->msgs);
+    }
+    free(jobs);
+}
+
 void do_battles(void) {
     region *r;
     init_rules();
-    for (r = regions; r; r = r->next) {
-        do_battle(r);
+    config_threads();
+    effskill_memo_begin();
+    if (config_get_int("game.rng.streams", 0)) {
+        do_battles_parallel();
+    }
+    else {
+        for (r = regions; r; r = r->next) {
+            do_battle(r);
+        }
     }
+    effskill_memo_end();
 }
@@ -73,6 +73,10 @@ typedef struct side {
     int healed;
     unsigned int flags;
     const struct faction* stealthfaction;
+    /* troops that can be selected (alive - removed), for select_enemy: */
+    struct fighter** order;     /* the fighters list as an array */
+    int* troops[NUMROWS];       /* Fenwick trees over order, by status row */
+    int available[NUMROWS];
 } side;
 
 typedef int32_t relation_key_t;
@@ -96,6 +100,8 @@ typedef struct battle {
     signed char keeploot; /* keep (50 + keeploot) percent of items as loot */
     bool has_tactics_turn;
     bool reelarrow;
+    bool defer_spoils;  /* equip the spoils of the dead in finish_battle */
+    struct unit **spoils;
 } battle;
 
 typedef struct weapon {
@@ -165,6 +171,7 @@ typedef struct fighter {
     } run;
     int kills;
     int hits;
+    int order;                  /* index in side->order */
 } fighter;
 
 /* schilde */
@@ -193,6 +200,22 @@ side* get_side(battle* b, const struct unit* u);
 
 void do_battles(void);
 
+/* seconds spent in each phase of combat, collected while battle_timer
+ * is set. Used by the battle simulator. */
+typedef struct battle_timing {
+    double magic;       /* pre- and postcombat spells */
+    double flee;
+    double update;
+    double attacks;     /* includes spells */
+    double spells;      /* combat spells */
+    int rounds;
+} battle_timing;
+
+extern battle_timing* battle_timer;
+
+/* fight a battle that was set up with make_battle and join_battle */
+void battle_run(struct battle* b);
+
 /* for combat spells and special attacks */
 enum { SELECT_ADVANCE = 0x1, SELECT_DISTANCE = 0x2, SELECT_FIND = 0x4 };
 enum { ALLY_SELF, ALLY_ANY };
@@ -235,6 +258,7 @@ int statusrow(int status);
 void drain_exp(struct unit* u, int d);
 void kill_troop(troop dt);
 void remove_troop(troop dt);   /* not the same as the badly named rmtroop */
+void side_troops_changed(struct side* s);
 
 bool is_attacker(const fighter* fig);
 struct battle* make_battle(struct region* r);
@@ -13,10 +13,12 @@
 
 #include "kernel/config.h"
 #include "kernel/build.h"          // for construction, requirement
+#include "kernel/callbacks.h"
 #include "kernel/building.h"
 #include "kernel/faction.h"
 #include "kernel/curse.h"
 #include "kernel/item.h"
+#include "kernel/messages.h"
 #include "kernel/order.h"
 #include "kernel/race.h"
 #include "kernel/region.h"
@@ -29,9 +31,12 @@
 #include "util/base36.h"
 #include "util/keyword.h"
 #include "util/language.h"
+#include "util/macros.h"
 #include "util/message.h"
 #include "util/rand.h"
+#include "util/rng.h"
 #include "util/variant.h"
+#include "util/workers.h"
 
 #include <stdlib.h>                // for abort, calloc
 #include <strings.h>
@@ -40,6 +45,7 @@
 
 #include <stb_ds.h>
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
 
@@ -254,6 +260,55 @@ static void test_select_enemy(CuTest * tc)
     test_teardown();
 }
 
+static void test_select_enemy_troops(CuTest * tc)
+{
+    unit *du, *u1, *u2;
+    region *r;
+    fighter *df, *f1, *f2;
+    battle *b;
+    side *ds, *as;
+    troop at;
+
+    test_setup();
+    r = test_create_plain(0, 0);
+
+    du = test_create_unit(test_create_faction(), r);
+    u1 = test_create_unit(test_create_faction(), r);
+    scale_number(u1, 2);
+    u2 = test_create_unit(u1->faction, r);
+    u2->status = ST_BEHIND;
+    scale_number(u2, 3);
+
+    b = make_battle(r);
+    ds = make_side(b, du->faction, 0, 0, 0);
+    df = make_fighter(b, du, ds, false);
+    as = make_side(b, u1->faction, 0, 0, 0);
+    f1 = make_fighter(b, u1, as, true);
+    f2 = make_fighter(b, u2, as, true);
+    set_enemy(as, ds, true);
+
+    CuAssertIntEquals(tc, 5, count_enemies(b, df, FIRST_ROW, LAST_ROW, SELECT_ADVANCE));
+    CuAssertIntEquals(tc, 2, count_enemies(b, df, FIGHT_ROW, FIGHT_ROW, 0));
+    at = select_enemy(df, FIGHT_ROW, FIGHT_ROW, 0);
+    CuAssertPtrEquals(tc, f1, at.fighter);
+
+    /* the fighters list is in reverse order of creation */
+    at.fighter = f2;
+    at.index = 2;
+    kill_troop(at);
+    at.fighter = f1;
+    at.index = 1;
+    remove_troop(at);
+    CuAssertIntEquals(tc, 3, count_enemies(b, df, FIRST_ROW, LAST_ROW, SELECT_ADVANCE));
+    CuAssertIntEquals(tc, 1, count_enemies(b, df, FIGHT_ROW, FIGHT_ROW, 0));
+    at = select_enemy(df, BEHIND_ROW, BEHIND_ROW, 0);
+    CuAssertPtrEquals(tc, f2, at.fighter);
+    CuAssertTrue(tc, at.index < 2);
+
+    free_battle(b);
+    test_teardown();
+}
+
 static void test_defenders_get_building_bonus(CuTest * tc)
 {
     unit *du, *au;
@@ -1154,6 +1209,121 @@ static void test_battle_attack_invisible(CuTest* tc) {
     test_teardown();
 }
 
+static void test_battle_streams(CuTest* tc) {
+    region* r;
+    unit* u1, * u2;
+    faction *f;
+    test_setup();
+    setup_messages();
+    config_set_int("game.rng.streams", 1);
+    config_set_int("rules.combat.flee_chance_base", 100);
+    config_set_int("rules.combat.flee_chance_limit", 100);
+    r = test_create_plain(0, 0);
+    u1 = test_create_unit(f = test_create_faction(), r);
+    u2 = test_create_unit(test_create_faction(), test_create_plain(1, 1));
+    unit_addorder(u1, create_order(K_ATTACK, f->locale, itoa36(u2->no)));
+    do_battles();
+    CuAssertPtrNotNull(tc, test_find_messagetype(f->msgs, "feedback_unit_not_found"));
+    test_clear_messages(f);
+    move_unit(u2, r, NULL);
+    u2->status = ST_FLEE;
+    do_battles();
+    CuAssertPtrEquals(tc, NULL, test_find_messagetype(f->msgs, "feedback_unit_not_found"));
+    CuAssertIntEquals(tc, 1, u1->number);
+    CuAssertIntEquals(tc, 1, u2->number);
+    CuAssertIntEquals(tc, UFL_LONGACTION | UFL_NOTMOVING, (u1->flags & (UFL_LONGACTION | UFL_NOTMOVING)));
+    test_teardown();
+}
+
+/* six battles, the defenders carry silver that can be looted */
+static void setup_battle_threads(void)
+{
+    item_type *silver;
+    int x;
+
+    rng_init(42);
+    setup_messages();
+    config_set_int("game.rng.streams", 1);
+    silver = test_create_silver();
+    for (x = 0; x != 6; ++x) {
+        region *r = test_create_plain(x, 0);
+        unit *u1 = test_create_unit(test_create_faction(), r);
+        unit *u2 = test_create_unit(test_create_faction(), r);
+        scale_number(u1, 10 + x);
+        scale_number(u2, 10);
+        test_set_item(u2, silver, 1000);
+        unit_addorder(u1, create_order(K_ATTACK, u1->faction->locale, itoa36(u2->no)));
+    }
+}
+
+static void battle_result(char *buf, size_t size)
+{
+    const item_type *silver = get_resourcetype(R_SILVER)->itype;
+    region *r;
+    faction *f;
+    size_t len = 0;
+
+    for (r = regions; r && len < size; r = r->next) {
+        unit *u;
+        for (u = r->units; u && len < size; u = u->next) {
+            len += snprintf(buf + len, size - len, "%s:%d:%d:%d ", itoa36(u->no),
+                u->number, u->hp, i_get(u->items, silver));
+        }
+    }
+    for (f = factions; f && len < size; f = f->next) {
+        struct bmsg *bm;
+        len += test_messagetypes(buf + len, size - len, f->msgs);
+        for (bm = f->battles; bm && len < size; bm = bm->next) {
+            len += snprintf(buf + len, size - len, "%d,%d: ", bm->r->x, bm->r->y);
+            if (len < size) {
+                len += test_messagetypes(buf + len, size - len, bm->msgs);
+            }
+        }
+    }
+    assert(len < size);
+}
+
+/* with random streams, the outcome does not depend on the number of threads */
+static void test_battle_threads(CuTest* tc) {
+    test_threads_agree(tc, setup_battle_threads, do_battles, battle_result);
+}
+
+static int equip_calls;
+static bool equip_in_worker;
+
+static bool equip_spoils_callback(unit *u, const char *eqname, int mask)
+{
+    UNUSED_ARG(u);
+    UNUSED_ARG(eqname);
+    UNUSED_ARG(mask);
+    if (workers_active()) {
+        equip_in_worker = true;
+    }
+    ++equip_calls;
+    return true;
+}
+
+/* the spoils of the dead are equipped on the main thread, where the
+ * callback may call into Lua */
+static void test_battle_threads_spoils(CuTest* tc) {
+    region *r;
+
+    test_setup();
+    setup_battle_threads();
+    for (r = regions; r; r = r->next) {
+        scale_number(r->units->next, 1);
+    }
+    callbacks.equip_unit = equip_spoils_callback;
+    equip_calls = 0;
+    equip_in_worker = false;
+    config_set_int("game.threads", 4);
+    do_battles();
+    workers_set_count(1);
+    CuAssertTrue(tc, equip_calls > 0);
+    CuAssertTrue(tc, !equip_in_worker);
+    test_teardown();
+}
+
 static void test_battle_fleeing(CuTest* tc) {
     region *r;
     unit *u1, *u2;
@@ -1459,12 +1629,16 @@ CuSuite *get_battle_suite(void)
     SUITE_ADD_TEST(suite, test_select_armor);
     SUITE_ADD_TEST(suite, test_battle_fleeing);
     SUITE_ADD_TEST(suite, test_battle_attack_invisible);
+    SUITE_ADD_TEST(suite, test_battle_streams);
+    SUITE_ADD_TEST(suite, test_battle_threads);
+    SUITE_ADD_TEST(suite, test_battle_threads_spoils);
     SUITE_ADD_TEST(suite, test_battle_skilldiff);
     SUITE_ADD_TEST(suite, test_battle_skilldiff_building);
     SUITE_ADD_TEST(suite, test_battle_report_one);
     SUITE_ADD_TEST(suite, test_battle_report_two);
     SUITE_ADD_TEST(suite, test_battle_report_three);
     SUITE_ADD_TEST(suite, test_select_enemy);
+    SUITE_ADD_TEST(suite, test_select_enemy_troops);
     SUITE_ADD_TEST(suite, test_defenders_get_building_bonus);
     SUITE_ADD_TEST(suite, test_attackers_get_no_building_bonus);
     SUITE_ADD_TEST(suite, test_building_bonus_respects_size);
@@ -0,0 +1,545 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "battle.h"
+#include "bind_config.h"
+#include "eressea.h"
+#include "magic.h"
+
+#include <kernel/config.h>
+#include <kernel/faction.h>
+#include <kernel/item.h>
+#include <kernel/messages.h>
+#include <kernel/race.h>
+#include <kernel/region.h>
+#include <kernel/skill.h>
+#include <kernel/spell.h>
+#include <kernel/terrain.h>
+#include <kernel/unit.h>
+
+#include <util/language.h>
+#include <util/log.h>
+#include <util/path.h>
+#include <util/rng.h>
+
+#include <cJSON.h>
+#include <stb_ds.h>
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Fights the same battle many times, and reports how it ends and how
+ * long the phases of combat take. The armies are read from a JSON file:
+ *
+ * { "terrain": "plain", "settings": { "rules.combat.turns": 5 },
+ *   "armies": [ { "race": "human", "attack": true, "units": [
+ *     { "number": 100, "race": "orc", "status": "front",
+ *       "skills": { "melee": 5 }, "items": { "sword": 100 },
+ *       "magic": "draig", "aura": 50, "spells": { "fireball": 5 } } ] } ] }
+ *
+ * Every army is a faction. The units of attacking armies attack all the
+ * other armies. Each battle uses the seed of the first one plus its
+ * number, so a run can be repeated exactly, e.g. under a profiler. */
+
+typedef struct spec_item {
+    const item_type *itype;
+    int number;
+} spec_item;
+
+typedef struct spec_spell {
+    spell *sp;
+    int level;
+} spec_spell;
+
+typedef struct spec_unit {
+    const race *rc;
+    int number;
+    status_t status;
+    int skills[MAXSKILLS];
+    spec_item *items;
+    spec_spell *spells;
+    magic_t magic;
+    int aura;
+} spec_unit;
+
+typedef struct army {
+    const race *rc;
+    bool attack;
+    spec_unit *units;
+    faction *f;
+    int people;
+    int wins;
+    long long casualties;
+    long long fled;
+} army;
+
+typedef struct scenario {
+    const terrain_type *terrain;
+    army *armies;
+} scenario;
+
+static const char *status_names[] = {
+    "aggressive", "front", "rear", "defensive", "avoid", "flee", NULL
+};
+
+static int read_status(const char *name)
+{
+    int i;
+    for (i = 0; status_names[i]; ++i) {
+        if (strcmp(name, status_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static magic_t read_magic(const char *name)
+{
+    int i;
+    for (i = 0; i != MAXMAGIETYP; ++i) {
+        if (magic_school[i] && strcmp(name, magic_school[i]) == 0) {
+            return (magic_t)i;
+        }
+    }
+    return M_NONE;
+}
+
+static int read_unit(cJSON *json, spec_unit *su, const race *rc)
+{
+    cJSON *child;
+
+    memset(su, 0, sizeof(spec_unit));
+    su->rc = rc;
+    su->number = 1;
+    su->status = ST_FIGHT;
+    su->magic = M_NONE;
+    for (child = json->child; child; child = child->next) {
+        if (strcmp(child->string, "number") == 0 && child->type == cJSON_Number) {
+            su->number = child->valueint;
+        }
+        else if (strcmp(child->string, "aura") == 0 && child->type == cJSON_Number) {
+            su->aura = child->valueint;
+        }
+        else if (strcmp(child->string, "race") == 0 && child->type == cJSON_String) {
+            su->rc = rc_find(child->valuestring);
+            if (!su->rc) {
+                log_error("unknown race %s", child->valuestring);
+                return -1;
+            }
+        }
+        else if (strcmp(child->string, "status") == 0 && child->type == cJSON_String) {
+            int status = read_status(child->valuestring);
+            if (status < 0) {
+                log_error("unknown status %s", child->valuestring);
+                return -1;
+            }
+            su->status = (status_t)status;
+        }
+        else if (strcmp(child->string, "magic") == 0 && child->type == cJSON_String) {
+            su->magic = read_magic(child->valuestring);
+            if (su->magic == M_NONE) {
+                log_error("unknown school of magic %s", child->valuestring);
+                return -1;
+            }
+        }
+        else if (strcmp(child->string, "skills") == 0 && child->type == cJSON_Object) {
+            cJSON *entry;
+            for (entry = child->child; entry; entry = entry->next) {
+                skill_t sk = findskill(entry->string);
+                if (sk == NOSKILL) {
+                    log_error("unknown skill %s", entry->string);
+                    return -1;
+                }
+                su->skills[sk] = entry->valueint;
+            }
+        }
+        else if (strcmp(child->string, "items") == 0 && child->type == cJSON_Object) {
+            cJSON *entry;
+            for (entry = child->child; entry; entry = entry->next) {
+                spec_item si;
+                si.itype = it_find(entry->string);
+                if (!si.itype) {
+                    log_error("unknown item %s", entry->string);
+                    return -1;
+                }
+                si.number = entry->valueint;
+                arrput(su->items, si);
+            }
+        }
+        else if (strcmp(child->string, "spells") == 0 && child->type == cJSON_Object) {
+            cJSON *entry;
+            for (entry = child->child; entry; entry = entry->next) {
+                spec_spell ss;
+                ss.sp = find_spell(entry->string);
+                if (!ss.sp) {
+                    log_error("unknown spell %s", entry->string);
+                    return -1;
+                }
+                ss.level = entry->valueint;
+                arrput(su->spells, ss);
+            }
+        }
+        else {
+            log_error("unknown unit property %s", child->string);
+            return -1;
+        }
+    }
+    if (su->number <= 0) {
+        log_error("units need a positive number of people");
+        return -1;
+    }
+    if (su->spells && su->magic == M_NONE) {
+        log_error("units with spells need a school of magic");
+        return -1;
+    }
+    return 0;
+}
+
+static int read_army(cJSON *json, army *a)
+{
+    cJSON *child, *units = NULL;
+
+    memset(a, 0, sizeof(army));
+    a->rc = rc_find("human");
+    for (child = json->child; child; child = child->next) {
+        if (strcmp(child->string, "race") == 0 && child->type == cJSON_String) {
+            a->rc = rc_find(child->valuestring);
+            if (!a->rc) {
+                log_error("unknown race %s", child->valuestring);
+                return -1;
+            }
+        }
+        else if (strcmp(child->string, "attack") == 0) {
+            a->attack = (child->type == cJSON_True);
+        }
+        else if (strcmp(child->string, "units") == 0 && child->type == cJSON_Array) {
+            units = child;
+        }
+    }
+    if (!a->rc || !units) {
+        log_error("armies need a race and units");
+        return -1;
+    }
+    for (child = units->child; child; child = child->next) {
+        spec_unit su;
+        if (read_unit(child, &su, a->rc) != 0) {
+            return -1;
+        }
+        a->people += su.number;
+        arrput(a->units, su);
+    }
+    return 0;
+}
+
+static int read_scenario(const char *filename, scenario *sc)
+{
+    FILE *F = fopen(filename, "rb");
+    cJSON *json, *child;
+    char *data;
+    long size;
+    int result = 0;
+
+    memset(sc, 0, sizeof(scenario));
+    if (!F) {
+        perror(filename);
+        return -1;
+    }
+    fseek(F, 0, SEEK_END);
+    size = ftell(F);
+    rewind(F);
+    data = malloc((size_t)size + 1);
+    if (!data) abort();
+    size = (long)fread(data, 1, (size_t)size, F);
+    data[size] = 0;
+    fclose(F);
+    json = cJSON_Parse(data);
+    free(data);
+    if (!json) {
+        log_error("%s is not valid JSON", filename);
+        return -1;
+    }
+    sc->terrain = get_terrain("plain");
+    for (child = json->child; child && result == 0; child = child->next) {
+        if (strcmp(child->string, "terrain") == 0 && child->type == cJSON_String) {
+            sc->terrain = get_terrain(child->valuestring);
+            if (!sc->terrain) {
+                log_error("unknown terrain %s", child->valuestring);
+                result = -1;
+            }
+        }
+        else if (strcmp(child->string, "settings") == 0 && child->type == cJSON_Object) {
+            cJSON *entry;
+            for (entry = child->child; entry; entry = entry->next) {
+                if (entry->type == cJSON_String) {
+                    config_set(entry->string, entry->valuestring);
+                }
+                else if (entry->type == cJSON_Number) {
+                    char buffer[32];
+                    snprintf(buffer, sizeof(buffer), "%g", entry->valuedouble);
+                    config_set(entry->string, buffer);
+                }
+                else {
+                    config_set(entry->string, (entry->type == cJSON_True) ? "1" : "0");
+                }
+            }
+        }
+        else if (strcmp(child->string, "armies") == 0 && child->type == cJSON_Array) {
+            cJSON *entry;
+            for (entry = child->child; entry && result == 0; entry = entry->next) {
+                army a;
+                result = read_army(entry, &a);
+                if (result == 0) {
+                    arrput(sc->armies, a);
+                }
+            }
+        }
+    }
+    cJSON_Delete(json);
+    if (result == 0 && arrlen(sc->armies) < 2) {
+        log_error("a battle needs at least two armies");
+        result = -1;
+    }
+    return result;
+}
+
+static void free_scenario(scenario *sc)
+{
+    ptrdiff_t i, len = arrlen(sc->armies);
+    for (i = 0; i != len; ++i) {
+        army *a = sc->armies + i;
+        ptrdiff_t u, ulen = arrlen(a->units);
+        for (u = 0; u != ulen; ++u) {
+            arrfree(a->units[u].items);
+            arrfree(a->units[u].spells);
+        }
+        arrfree(a->units);
+    }
+    arrfree(sc->armies);
+}
+
+static unit *create_spec_unit(region *r, faction *f, const spec_unit *su)
+{
+    unit *u = create_unit(r, f, su->number, su->rc, 0, NULL, NULL);
+    ptrdiff_t i, len;
+    int sk;
+
+    unit_setstatus(u, su->status);
+    for (sk = 0; sk != MAXSKILLS; ++sk) {
+        if (su->skills[sk] > 0) {
+            set_level(u, (skill_t)sk, su->skills[sk]);
+        }
+    }
+    for (i = 0, len = arrlen(su->items); i != len; ++i) {
+        i_change(&u->items, su->items[i].itype, su->items[i].number);
+    }
+    if (su->magic != M_NONE) {
+        create_mage(u, su->magic);
+        set_spellpoints(u, su->aura);
+        for (i = 0, len = arrlen(su->spells); i != len; ++i) {
+            unit_add_spell(u, su->spells[i].sp, su->spells[i].level);
+            set_combatspell(u, su->spells[i].sp, NULL, su->spells[i].level);
+        }
+    }
+    return u;
+}
+
+/* fights one battle, returns the index of the winning army or -1 */
+static int simulate(scenario *sc, const struct locale *lang)
+{
+    region *r = new_region(0, 0, NULL, 0);
+    ptrdiff_t i, len = arrlen(sc->armies);
+    battle *b;
+    unit *u;
+    size_t si, sj, sl;
+    int winner = -1;
+
+    terraform_region(r, sc->terrain);
+    for (i = 0; i != len; ++i) {
+        army *a = sc->armies + i;
+        ptrdiff_t n, ulen = arrlen(a->units);
+        a->f = addfaction("battlesim@eressea.de", NULL, a->rc, lang);
+        for (n = 0; n != ulen; ++n) {
+            create_spec_unit(r, a->f, a->units + n);
+        }
+    }
+
+    b = make_battle(r);
+    for (i = 0; i != len; ++i) {
+        army *a = sc->armies + i;
+        for (u = r->units; u; u = u->next) {
+            if (u->faction == a->f) {
+                fighter *fig;
+                join_battle(b, u, a->attack, &fig);
+            }
+        }
+    }
+    sl = arrlen(b->sides);
+    for (si = 0; si != sl; ++si) {
+        side *as = b->sides[si];
+        for (sj = 0; sj != sl; ++sj) {
+            side *ds = b->sides[sj];
+            if (as->bf->faction != ds->bf->faction) {
+                for (i = 0; i != len; ++i) {
+                    if (sc->armies[i].f == as->bf->faction && sc->armies[i].attack) {
+                        as->bf->attacker = true;
+                        set_enemy(as, ds, true);
+                    }
+                }
+            }
+        }
+    }
+    battle_run(b);
+
+    for (i = 0; i != len; ++i) {
+        army *a = sc->armies + i;
+        int standing = 0, fled = 0;
+        for (u = r->units; u; u = u->next) {
+            if (u->faction == a->f && u->number > 0) {
+                if (u->flags & UFL_FLEEING) {
+                    fled += u->number;
+                }
+                else {
+                    standing += u->number;
+                }
+            }
+        }
+        a->casualties += a->people - standing - fled;
+        a->fled += fled;
+        if (standing > 0) {
+            winner = (winner == -1) ? (int)i : -2;
+        }
+    }
+    free_gamedata();
+    return (winner >= 0) ? winner : -1;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-r rules] [-i install] [-n battles] [-s seed] [-p profile.csv] scenario.json\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *rules = "e2", *install = ".", *profile = NULL;
+    const char *filename = NULL;
+    char path[PATH_MAX];
+    int i, runs = 100, draws = 0;
+    unsigned int seed = 1;
+    battle_timing total, timing;
+    struct locale *lang;
+    scenario sc;
+    FILE *P = NULL;
+    clock_t start;
+    double elapsed;
+
+    for (i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' && i + 1 < argc) {
+            switch (argv[i][1]) {
+            case 'r':
+                rules = argv[++i];
+                break;
+            case 'i':
+                install = argv[++i];
+                break;
+            case 'n':
+                runs = atoi(argv[++i]);
+                break;
+            case 's':
+                seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+                break;
+            case 'p':
+                profile = argv[++i];
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else {
+            filename = argv[i];
+        }
+    }
+    if (!filename || runs <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    log_to_file(LOG_CPERROR, stderr);
+    message_handle_missing(MESSAGE_MISSING_IGNORE);
+    game_init();
+    path_join("conf", rules, path, sizeof(path));
+    path_join(path, "config.json", path, sizeof(path));
+    if (config_read(path, install) != 0) {
+        log_error("could not read rules from %s", path);
+        return 1;
+    }
+    lang = get_or_create_locale("de");
+    if (read_scenario(filename, &sc) != 0) {
+        free_scenario(&sc);
+        return 1;
+    }
+    if (profile) {
+        P = fopen(profile, "w");
+        if (!P) {
+            perror(profile);
+            return 1;
+        }
+        fputs("battle,seed,winner,rounds,magic,flee,update,attacks,spells\n", P);
+    }
+
+    memset(&total, 0, sizeof(total));
+    battle_timer = &timing;
+    start = clock();
+    for (i = 0; i != runs; ++i) {
+        int winner;
+        memset(&timing, 0, sizeof(timing));
+        rng_init(seed + i);
+        winner = simulate(&sc, lang);
+        if (winner >= 0) {
+            ++sc.armies[winner].wins;
+        }
+        else {
+            ++draws;
+        }
+        total.magic += timing.magic;
+        total.flee += timing.flee;
+        total.update += timing.update;
+        total.attacks += timing.attacks;
+        total.spells += timing.spells;
+        total.rounds += timing.rounds;
+        if (P) {
+            fprintf(P, "%d,%u,%d,%d,%f,%f,%f,%f,%f\n", i, seed + i, winner,
+                timing.rounds, timing.magic, timing.flee, timing.update,
+                timing.attacks, timing.spells);
+        }
+    }
+    elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    battle_timer = NULL;
+    if (P) {
+        fclose(P);
+    }
+
+    printf("%d battles, %d rounds, %.3fs\n", runs, total.rounds, elapsed);
+    for (i = 0; i != arrlen(sc.armies); ++i) {
+        const army *a = sc.armies + i;
+        printf("army %d (%s, %d people): %.1f%% wins, %.1f dead, %.1f fled\n",
+            i + 1, a->rc->_name, a->people, 100.0 * a->wins / runs,
+            (double)a->casualties / runs, (double)a->fled / runs);
+    }
+    printf("draws: %.1f%%\n", 100.0 * draws / runs);
+    printf("time per round (ms): flee %.3f, update %.3f, attacks %.3f (spells %.3f)\n",
+        total.rounds ? 1000.0 * total.flee / total.rounds : 0.0,
+        total.rounds ? 1000.0 * total.update / total.rounds : 0.0,
+        total.rounds ? 1000.0 * total.attacks / total.rounds : 0.0,
+        total.rounds ? 1000.0 * total.spells / total.rounds : 0.0);
+    printf("time per battle (ms): pre- and postcombat magic %.3f\n",
+        1000.0 * total.magic / runs);
+
+    free_scenario(&sc);
+    game_done();
+    return 0;
+}
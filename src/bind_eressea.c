@@ -13,6 +13,7 @@
 
 #include <util/language.h>
 #include <util/log.h>
+#include <util/message.h>
 
 #include <stream.h>
 #include <stdio.h>
@@ -27,11 +28,20 @@ void eressea_free_game(void) {
 
 int eressea_read_game(const char * filename) {
     if (filename) {
+        msg_arena_open();
         return readgame(filename);
     }
     return -1;
 }
 
+int eressea_read_game_lazy(const char * filename) {
+    if (filename) {
+        msg_arena_open();
+        return readgame_lazy(filename);
+    }
+    return -1;
+}
+
 int eressea_write_game(const char * filename) {
     if (filename) {
         remove_empty_factions();
@@ -4,6 +4,7 @@
 
 void eressea_free_game(void);
 int eressea_read_game(const char * filename);
+int eressea_read_game_lazy(const char * filename);
 int eressea_write_game(const char * filename);
 int eressea_read_orders(const char * filename);
 
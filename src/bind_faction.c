@@ -519,7 +519,7 @@ static int cb_ally_push(struct allies *af, struct faction *f, int status, void *
 static int tolua_faction_reset_allies(lua_State * L) {
     faction *f = (faction *)tolua_tousertype(L, 1, NULL);
 
-    freelist(f->allies);
+    allies_free(f->allies);
     f->allies = NULL;
     while (f->groups) {
         group* g = f->groups;
@@ -205,7 +205,7 @@ static int msg_send_faction(lua_message * msg, faction * f)
 
     if (msg->mtype) {
         if (msg->msg == NULL) {
-            msg->msg = msg_create(msg->mtype, msg->args);
+            msg->msg = msg_create_heap(msg->mtype, msg->args);
         }
         add_message(&f->msgs, msg->msg);
         return E_OK;
@@ -219,7 +219,7 @@ static int msg_send_region(lua_message * lmsg, region * r)
     if (lmsg->mtype) {
         assert(r);
         if (lmsg->msg == NULL) {
-            lmsg->msg = msg_create(lmsg->mtype, lmsg->args);
+            lmsg->msg = msg_create_heap(lmsg->mtype, lmsg->args);
         }
         add_message(&r->msgs, lmsg->msg);
         return E_OK;
@@ -337,7 +337,7 @@ static int tolua_msg_report_action(lua_State * L)
     unit *u = (unit *)tolua_tousertype(L, 3, 0);
     int result, flags = (int)tolua_tonumber(L, 4, 0);
     if (lmsg->msg == NULL) {
-        lmsg->msg = msg_create(lmsg->mtype, lmsg->args);
+        lmsg->msg = msg_create_heap(lmsg->mtype, lmsg->args);
     }
     result = report_action(r, u, lmsg->msg, flags);
     lua_pushinteger(L, result);
@@ -371,7 +371,7 @@ static int tolua_msg_render(lua_State * L)
     char name[64];
 
     if (lmsg->msg == NULL) {
-        lmsg->msg = msg_create(lmsg->mtype, lmsg->args);
+        lmsg->msg = msg_create_heap(lmsg->mtype, lmsg->args);
     }
     nr_render(lmsg->msg, lang, name, sizeof(name), NULL);
     lua_pushstring(L, name);
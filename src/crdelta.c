@@ -0,0 +1,463 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "crdelta.h"
+
+#include <util/log.h>
+
+#include <strings.h>
+
+#include <stb_ds.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CRDELTA_VERSION 1
+#define MAXTAG 64
+#define MAXKEY 256
+
+typedef struct cr_block {
+    char *key;
+    const char *text;
+    size_t len;
+    uint64_t hash;
+} cr_block;
+
+typedef struct block_index {
+    char *key;
+    ptrdiff_t value;
+} block_index;
+
+typedef struct key_count {
+    char *key;
+    int value;
+} key_count;
+
+typedef struct hash_entry {
+    char *key;
+    uint64_t value;
+} hash_entry;
+
+typedef struct cr_file {
+    char *data;
+    size_t size;
+    size_t preamble;    /* bytes before the first block, i.e. the BOM */
+    cr_block *blocks;
+    block_index *index;
+} cr_file;
+
+/* blocks that start a new context for the keys of the blocks after them */
+static const char *const top_tags[] = {
+    "VERSION", "PARTEI", "REGION", "BATTLE", "ZAUBER", "TRANK",
+    "TRANSLATION", NULL
+};
+
+static const char *const object_tags[] = {
+    "EINHEIT", "BURG", "SCHIFF", "GRUPPE", NULL
+};
+
+static uint64_t block_hash(const char *text, size_t len)
+{
+    /* FNV-1a */
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i;
+    for (i = 0; i != len; ++i) {
+        hash ^= (unsigned char)text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool is_tag(const char *line)
+{
+    return *line >= 'A' && *line <= 'Z';
+}
+
+static bool has_tag(const char *line, const char *const tags[])
+{
+    int i;
+    for (i = 0; tags[i]; ++i) {
+        size_t len = strlen(tags[i]);
+        if (strncmp(line, tags[i], len) == 0
+            && (line[len] == ' ' || line[len] == '\n' || line[len] == '\r' || line[len] == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char *next_line(const char *pos, const char *end)
+{
+    const char *eol = memchr(pos, '\n', end - pos);
+    return eol ? eol + 1 : end;
+}
+
+/* copy the tag line at pos into buf, without the line break */
+static void tag_line(const char *pos, const char *end, char *buf, size_t size)
+{
+    size_t len = 0;
+    while (pos + len != end && pos[len] != '\n' && pos[len] != '\r' && len + 1 < size) {
+        ++len;
+    }
+    memcpy(buf, pos, len);
+    buf[len] = 0;
+}
+
+static int read_file(const char *filename, char **data, size_t *size)
+{
+    FILE *F = fopen(filename, "rb");
+    long len;
+    char *buf;
+
+    if (!F) {
+        log_error("could not open %s: %s", filename, strerror(errno));
+        errno = 0;
+        return -1;
+    }
+    fseek(F, 0, SEEK_END);
+    len = ftell(F);
+    fseek(F, 0, SEEK_SET);
+    buf = malloc((size_t)len + 1);
+    if (!buf) abort();
+    if (len > 0 && fread(buf, 1, (size_t)len, F) != (size_t)len) {
+        log_error("could not read %s", filename);
+        free(buf);
+        fclose(F);
+        return -1;
+    }
+    buf[len] = 0;
+    fclose(F);
+    *data = buf;
+    *size = (size_t)len;
+    return 0;
+}
+
+/* split the text into blocks. If with_keys is set, give every block a
+ * key from its tag line and the enclosing region, unit, etc., that is
+ * unique within the file. */
+static void cr_split(cr_file *cf, bool with_keys)
+{
+    const char *pos = cf->data, *end = cf->data + cf->size;
+    char top[MAXTAG], object[MAXKEY - MAXTAG], tag[MAXTAG];
+    key_count *counts = NULL;
+
+    top[0] = object[0] = 0;
+    if (cf->size >= 3 && memcmp(pos, "\xef\xbb\xbf", 3) == 0) {
+        pos += 3;
+    }
+    while (pos != end && !is_tag(pos)) {
+        pos = next_line(pos, end);
+    }
+    cf->preamble = pos - cf->data;
+    sh_new_strdup(counts);
+    while (pos != end) {
+        cr_block block;
+        const char *next = next_line(pos, end);
+        while (next != end && !is_tag(next)) {
+            next = next_line(next, end);
+        }
+        block.text = pos;
+        block.len = next - pos;
+        block.hash = block_hash(pos, block.len);
+        block.key = NULL;
+        if (with_keys) {
+            char key[MAXKEY];
+            ptrdiff_t i;
+            tag_line(pos, end, tag, sizeof(tag));
+            if (has_tag(tag, top_tags)) {
+                str_strlcpy(top, tag, sizeof(top));
+                str_strlcpy(key, tag, sizeof(key));
+                object[0] = 0;
+            }
+            else if (has_tag(tag, object_tags)) {
+                snprintf(object, sizeof(object), "%s/%s", top, tag);
+                str_strlcpy(key, object, sizeof(key));
+            }
+            else {
+                snprintf(key, sizeof(key), "%s/%s", object[0] ? object : top, tag);
+            }
+            i = shgeti(counts, key);
+            if (i < 0) {
+                shput(counts, key, 1);
+            }
+            else {
+                size_t len = strlen(key);
+                snprintf(key + len, sizeof(key) - len, "#%d", ++counts[i].value);
+            }
+            block.key = str_strdup(key);
+            shput(cf->index, block.key, arrlen(cf->blocks));
+        }
+        arrput(cf->blocks, block);
+        pos = next;
+    }
+    shfree(counts);
+}
+
+static int cr_read(cr_file *cf, const char *filename, bool with_keys)
+{
+    memset(cf, 0, sizeof(cr_file));
+    if (read_file(filename, &cf->data, &cf->size) != 0) {
+        return -1;
+    }
+    cr_split(cf, with_keys);
+    return 0;
+}
+
+static void cr_free(cr_file *cf)
+{
+    ptrdiff_t i, len = arrlen(cf->blocks);
+    for (i = 0; i != len; ++i) {
+        free(cf->blocks[i].key);
+    }
+    arrfree(cf->blocks);
+    shfree(cf->index);
+    free(cf->data);
+}
+
+static void state_path(char *buf, size_t size, const char *statebase, int turn)
+{
+    snprintf(buf, size, "%s-%d.crstate", statebase, turn);
+}
+
+/* read the hashes of a turn, returns 0 if there are none */
+static int state_read(hash_entry **hashes, const char *filename, int turn)
+{
+    char line[MAXKEY + 32];
+    FILE *F = fopen(filename, "r");
+
+    sh_new_strdup(*hashes);
+    if (!F) {
+        errno = 0;
+        return 0;
+    }
+    if (!fgets(line, sizeof(line), F) || atoi(line) != turn) {
+        log_warning("ignoring %s, it is not the state of turn %d", filename, turn);
+        turn = 0;
+    }
+    else {
+        while (fgets(line, sizeof(line), F)) {
+            char *key = strchr(line, ' ');
+            if (key) {
+                size_t len;
+                uint64_t hash = (uint64_t)strtoull(line, NULL, 16);
+                ++key;
+                len = strlen(key);
+                if (len > 0 && key[len - 1] == '\n') {
+                    key[len - 1] = 0;
+                }
+                shput(*hashes, key, hash);
+            }
+        }
+    }
+    fclose(F);
+    return turn;
+}
+
+/* written under a temporary name and renamed, so a crash while it is
+ * written leaves the state of the previous turn behind */
+static int state_write(const cr_file *cf, const char *filename, int turn)
+{
+    char tmp[4096 + 8];
+    ptrdiff_t i, len = arrlen(cf->blocks);
+    FILE *F;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+    F = fopen(tmp, "w");
+    if (!F) {
+        log_error("could not write %s: %s", tmp, strerror(errno));
+        errno = 0;
+        return -1;
+    }
+    fprintf(F, "%d\n", turn);
+    for (i = 0; i != len; ++i) {
+        const cr_block *block = cf->blocks + i;
+        fprintf(F, "%016llx %s\n", (unsigned long long)block->hash, block->key);
+    }
+    if (fclose(F) != 0) {
+        log_error("could not write %s: %s", tmp, strerror(errno));
+        errno = 0;
+        remove(tmp);
+        return -1;
+    }
+#ifdef _WIN32
+    remove(filename);
+#endif
+    if (rename(tmp, filename) != 0) {
+        log_error("could not rename %s: %s", tmp, strerror(errno));
+        errno = 0;
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int crdelta_write(const char *crfile, const char *deltafile,
+    const char *statebase, int turn)
+{
+    char statefile[4096];
+    cr_file cf;
+    hash_entry *hashes = NULL;
+    bool *changed = NULL;
+    ptrdiff_t i, len, nhashes;
+    int baseturn;
+    FILE *F;
+
+    if (cr_read(&cf, crfile, true) != 0) {
+        return -1;
+    }
+    F = fopen(deltafile, "wb");
+    if (!F) {
+        log_error("could not write %s: %s", deltafile, strerror(errno));
+        errno = 0;
+        cr_free(&cf);
+        return -1;
+    }
+    state_path(statefile, sizeof(statefile), statebase, turn - 1);
+    baseturn = state_read(&hashes, statefile, turn - 1);
+    fwrite(cf.data, 1, cf.preamble, F);
+    fprintf(F, "DELTA %d\n", CRDELTA_VERSION);
+    fprintf(F, "%d;Runde\n", turn);
+    fprintf(F, "%d;Basis\n", baseturn);
+
+    fputs("MANIFEST\n", F);
+    len = arrlen(cf.blocks);
+    for (i = 0; i != len; ++i) {
+        const cr_block *block = cf.blocks + i;
+        ptrdiff_t h = shgeti(hashes, block->key);
+        bool change = (h < 0 || hashes[h].value != block->hash);
+        arrput(changed, change);
+        fprintf(F, "\"%c%016llx %s\"\n", change ? '+' : '=',
+            (unsigned long long)block->hash, block->key);
+    }
+
+    fputs("REMOVED\n", F);
+    nhashes = shlen(hashes);
+    for (i = 0; i != nhashes; ++i) {
+        if (shgeti(cf.index, hashes[i].key) < 0) {
+            fprintf(F, "\"%s\"\n", hashes[i].key);
+        }
+    }
+
+    for (i = 0; i != len; ++i) {
+        if (changed[i]) {
+            const cr_block *block = cf.blocks + i;
+            fwrite(block->text, 1, block->len, F);
+        }
+    }
+    fclose(F);
+    arrfree(changed);
+    shfree(hashes);
+
+    state_path(statefile, sizeof(statefile), statebase, turn);
+    if (state_write(&cf, statefile, turn) != 0) {
+        /* a stale state from an earlier run of this turn must not become
+         * the base of the next delta, that will be a full report */
+        log_error("no report state for turn %d, the next delta will be complete", turn);
+        remove(statefile);
+        errno = 0;
+    }
+    else {
+        /* a turn that is run again still needs the state before it */
+        state_path(statefile, sizeof(statefile), statebase, turn - 2);
+        remove(statefile);
+        errno = 0;
+    }
+    cr_free(&cf);
+    return 0;
+}
+
+/* get the text of a manifest entry, without the quotes */
+static bool manifest_entry(const char *pos, const char *end, char *buf, size_t size)
+{
+    if (*pos != '"') {
+        return false;
+    }
+    tag_line(pos + 1, end, buf, size);
+    size = strlen(buf);
+    if (size == 0 || buf[size - 1] != '"') {
+        return false;
+    }
+    buf[size - 1] = 0;
+    return true;
+}
+
+int crdelta_apply(const char *basefile, const char *deltafile,
+    const char *outfile)
+{
+    cr_file base, delta;
+    const cr_block *manifest;
+    const char *pos, *end;
+    ptrdiff_t next, nblocks;
+    FILE *F;
+    int result = 0;
+
+    memset(&base, 0, sizeof(base));
+    if (basefile && cr_read(&base, basefile, true) != 0) {
+        return -1;
+    }
+    if (cr_read(&delta, deltafile, false) != 0) {
+        cr_free(&base);
+        return -1;
+    }
+    nblocks = arrlen(delta.blocks);
+    if (nblocks < 3 || strncmp(delta.blocks[0].text, "DELTA ", 6) != 0
+        || atoi(delta.blocks[0].text + 6) != CRDELTA_VERSION
+        || strncmp(delta.blocks[1].text, "MANIFEST\n", 9) != 0
+        || strncmp(delta.blocks[2].text, "REMOVED\n", 8) != 0) {
+        log_error("%s is not a report delta", deltafile);
+        cr_free(&base);
+        cr_free(&delta);
+        return -1;
+    }
+    F = fopen(outfile, "wb");
+    if (!F) {
+        log_error("could not write %s: %s", outfile, strerror(errno));
+        errno = 0;
+        cr_free(&base);
+        cr_free(&delta);
+        return -1;
+    }
+    fwrite(delta.data, 1, delta.preamble, F);
+
+    /* the changed blocks follow the MANIFEST and REMOVED lists */
+    next = 3;
+    manifest = delta.blocks + 1;
+    end = manifest->text + manifest->len;
+    for (pos = next_line(manifest->text, end); pos != end; pos = next_line(pos, end)) {
+        char entry[MAXKEY + 32];
+        const cr_block *block = NULL;
+        uint64_t hash;
+
+        if (!manifest_entry(pos, end, entry, sizeof(entry)) || strlen(entry) < 18) {
+            result = -1;
+            break;
+        }
+        hash = (uint64_t)strtoull(entry + 1, NULL, 16);
+        if (entry[0] == '+') {
+            if (next < nblocks) {
+                block = delta.blocks + next++;
+            }
+        }
+        else if (entry[0] == '=') {
+            ptrdiff_t i = shgeti(base.index, entry + 18);
+            if (i >= 0) {
+                block = base.blocks + base.index[i].value;
+            }
+        }
+        if (!block || block->hash != hash) {
+            log_error("block %s does not match the base report", entry + 18);
+            result = -1;
+            break;
+        }
+        fwrite(block->text, 1, block->len, F);
+    }
+    fclose(F);
+    cr_free(&base);
+    cr_free(&delta);
+    return result;
+}
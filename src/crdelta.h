@@ -0,0 +1,30 @@
+#pragma once
+#ifndef H_GC_CRDELTA
+#define H_GC_CRDELTA
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /* Computer report deltas.
+     * A computer report is split into blocks, each starting at a tag line
+     * like REGION or EINHEIT. The delta for a turn contains a manifest of
+     * all blocks in the report, the blocks that were removed since the
+     * base turn, and the text of those blocks that are new or have
+     * changed. Together with the report of the base turn, that is enough
+     * to restore the full report.
+     * The hashes of each report are kept in a state file named
+     * <statebase>-<turn>.crstate, and the delta is always made against
+     * the state of the turn before, so a turn that is run or sent again
+     * gets the same delta. Without that state file, every block is in the
+     * delta. */
+
+    int crdelta_write(const char *crfile, const char *deltafile,
+        const char *statebase, int turn);
+    int crdelta_apply(const char *basefile, const char *deltafile,
+        const char *outfile);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,163 @@
+#include "crdelta.h"
+
+#include <tests.h>
+#include <CuTest.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void write_text(const char *filename, const char *text)
+{
+    FILE *F = fopen(filename, "wb");
+    fputs(text, F);
+    fclose(F);
+}
+
+static char *read_text(const char *filename, char *buf, size_t size)
+{
+    FILE *F = fopen(filename, "rb");
+    size_t len = fread(buf, 1, size - 1, F);
+    buf[len] = 0;
+    fclose(F);
+    return buf;
+}
+
+static const char *cr_turn1 =
+    "VERSION 69\n"
+    "1;Runde\n"
+    "PARTEI 1\n"
+    "\"Hodor\";Parteiname\n"
+    "REGION 0 0\n"
+    "\"Ebene\";Terrain\n"
+    "EINHEIT 5\n"
+    "\"Hodor\";Name\n"
+    "COMMANDS\n"
+    "\"ARBEITE\"\n"
+    "REGION 1 0\n"
+    "\"Wald\";Terrain\n"
+    "GRENZE 1\n"
+    "\"Strasse\";typ\n"
+    "REGION 2 0\n"
+    "\"Berg\";Terrain\n";
+
+static const char *cr_turn2 =
+    "VERSION 69\n"
+    "2;Runde\n"
+    "PARTEI 1\n"
+    "\"Hodor\";Parteiname\n"
+    "REGION 0 0\n"
+    "\"Ebene\";Terrain\n"
+    "EINHEIT 5\n"
+    "\"Hodor\";Name\n"
+    "COMMANDS\n"
+    "\"LERNE Ausdauer\"\n"
+    "REGION 1 0\n"
+    "\"Wald\";Terrain\n"
+    "GRENZE 1\n"
+    "\"Strasse\";typ\n";
+
+static void test_crdelta_first_turn(CuTest *tc) {
+    char buf[1024];
+
+    test_setup();
+    remove("test-0.crstate");
+    errno = 0;
+    write_text("1.cr", cr_turn1);
+    CuAssertIntEquals(tc, 0, crdelta_write("1.cr", "1.crd", "test", 1));
+    read_text("1.crd", buf, sizeof(buf));
+    CuAssertPtrNotNull(tc, strstr(buf, "0;Basis\n"));
+    CuAssertPtrEquals(tc, NULL, strstr(buf, "\"="));
+    CuAssertIntEquals(tc, 0, crdelta_apply(NULL, "1.crd", "test.cr"));
+    CuAssertStrEquals(tc, cr_turn1, read_text("test.cr", buf, sizeof(buf)));
+
+    CuAssertIntEquals(tc, 0, remove("1.cr"));
+    CuAssertIntEquals(tc, 0, remove("1.crd"));
+    CuAssertIntEquals(tc, 0, remove("test.cr"));
+    CuAssertIntEquals(tc, 0, remove("test-1.crstate"));
+    /* the state is written to a temporary file and renamed */
+    CuAssertIntEquals(tc, -1, remove("test-1.crstate.tmp"));
+    errno = 0;
+    test_teardown();
+}
+
+static void test_crdelta_changes(CuTest *tc) {
+    char buf[1024];
+
+    test_setup();
+    write_text("1.cr", cr_turn1);
+    CuAssertIntEquals(tc, 0, crdelta_write("1.cr", "1.crd", "test", 1));
+    write_text("2.cr", cr_turn2);
+    CuAssertIntEquals(tc, 0, crdelta_write("2.cr", "2.crd", "test", 2));
+    /* a report that is sent again gets the same delta */
+    CuAssertIntEquals(tc, 0, crdelta_write("2.cr", "2.crd", "test", 2));
+
+    read_text("2.crd", buf, sizeof(buf));
+    CuAssertPtrNotNull(tc, strstr(buf, "2;Runde\n1;Basis\n"));
+    CuAssertPtrNotNull(tc, strstr(buf, " REGION 0 0/EINHEIT 5/COMMANDS\"\n"));
+    CuAssertPtrNotNull(tc, strstr(buf, "REMOVED\n\"REGION 2 0\"\n"));
+    /* unchanged blocks are only in the manifest */
+    CuAssertPtrEquals(tc, NULL, strstr(buf, "\"Wald\";Terrain"));
+    CuAssertPtrNotNull(tc, strstr(buf, "\"LERNE Ausdauer\""));
+
+    CuAssertIntEquals(tc, 0, crdelta_apply("1.cr", "2.crd", "test.cr"));
+    CuAssertStrEquals(tc, cr_turn2, read_text("test.cr", buf, sizeof(buf)));
+
+    /* the delta cannot be applied to a report that lacks its blocks */
+    write_text("1.cr", "VERSION 69\n1;Runde\n");
+    CuAssertIntEquals(tc, -1, crdelta_apply("1.cr", "2.crd", "test.cr"));
+
+    CuAssertIntEquals(tc, 0, remove("1.cr"));
+    CuAssertIntEquals(tc, 0, remove("1.crd"));
+    CuAssertIntEquals(tc, 0, remove("2.cr"));
+    CuAssertIntEquals(tc, 0, remove("2.crd"));
+    CuAssertIntEquals(tc, 0, remove("test.cr"));
+    CuAssertIntEquals(tc, 0, remove("test-1.crstate"));
+    CuAssertIntEquals(tc, 0, remove("test-2.crstate"));
+    test_teardown();
+}
+
+static void test_crdelta_missing_state(CuTest *tc) {
+    char buf[1024];
+
+    test_setup();
+    write_text("1.cr", cr_turn1);
+    CuAssertIntEquals(tc, 0, crdelta_write("1.cr", "1.crd", "test", 1));
+    CuAssertIntEquals(tc, 0, remove("test-1.crstate"));
+    /* without the state of the turn before, the delta is complete */
+    write_text("2.cr", cr_turn2);
+    CuAssertIntEquals(tc, 0, crdelta_write("2.cr", "2.crd", "test", 2));
+    read_text("2.crd", buf, sizeof(buf));
+    CuAssertPtrNotNull(tc, strstr(buf, "2;Runde\n0;Basis\n"));
+    CuAssertPtrEquals(tc, NULL, strstr(buf, "\"="));
+    CuAssertIntEquals(tc, 0, crdelta_apply(NULL, "2.crd", "test.cr"));
+    CuAssertStrEquals(tc, cr_turn2, read_text("test.cr", buf, sizeof(buf)));
+
+    /* only the state of the turn before is kept */
+    CuAssertIntEquals(tc, 0, crdelta_write("1.cr", "1.crd", "test", 1));
+    write_text("3.cr", cr_turn2);
+    CuAssertIntEquals(tc, 0, crdelta_write("3.cr", "3.crd", "test", 3));
+    CuAssertIntEquals(tc, -1, remove("test-1.crstate"));
+    errno = 0;
+
+    CuAssertIntEquals(tc, 0, remove("1.cr"));
+    CuAssertIntEquals(tc, 0, remove("1.crd"));
+    CuAssertIntEquals(tc, 0, remove("2.cr"));
+    CuAssertIntEquals(tc, 0, remove("2.crd"));
+    CuAssertIntEquals(tc, 0, remove("3.cr"));
+    CuAssertIntEquals(tc, 0, remove("3.crd"));
+    CuAssertIntEquals(tc, 0, remove("test.cr"));
+    CuAssertIntEquals(tc, 0, remove("test-2.crstate"));
+    CuAssertIntEquals(tc, 0, remove("test-3.crstate"));
+    test_teardown();
+}
+
+CuSuite *get_crdelta_suite(void)
+{
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_crdelta_first_turn);
+    SUITE_ADD_TEST(suite, test_crdelta_changes);
+    SUITE_ADD_TEST(suite, test_crdelta_missing_state);
+    return suite;
+}
@@ -4,13 +4,12 @@
 #include <kernel/config.h>
 #include <kernel/version.h>
 #include "creport.h"
+#include "crdelta.h"
 
 /* tweakable features */
 #define RESOURCECOMPAT
 
 #define BUFFERSIZE 32768
-/* FIXME: riesig, wegen spionage-messages :-( */
-static char g_bigbuf[BUFFERSIZE];
 
 /* modules include */
 #include <modules/score.h>
@@ -68,6 +67,8 @@ static char g_bigbuf[BUFFERSIZE];
 #include <util/macros.h>
 #include <util/message.h>
 #include <util/nrmessage.h>
+#include <util/path.h>
+#include <util/workers.h>
 
 #include <filestream.h>
 #include <selist.h>
@@ -85,6 +86,9 @@ static char g_bigbuf[BUFFERSIZE];
 #include <stdlib.h>
 #include <string.h>
 
+/* FIXME: riesig, wegen spionage-messages :-( */
+static THREAD_LOCAL char g_bigbuf[BUFFERSIZE];
+
 /* imports */
 bool opt_cr_absolute_coords = false;
 
@@ -117,8 +121,8 @@ typedef struct translation {
 } translation;
 
 #define TRANSMAXHASH 257
-static translation *translation_table[TRANSMAXHASH];
-static translation *junkyard;
+static THREAD_LOCAL translation *translation_table[TRANSMAXHASH];
+static THREAD_LOCAL translation *junkyard;
 
 static const char *translate(const char *key, const char *value)
 {
@@ -1275,7 +1279,7 @@ static void cr_output_region_compat(FILE* F, report_context* ctx, region* r)
     /* TODO: eliminate this function */
     stream strm;
     fstream_init(&strm, F);
-    cr_output_region(&strm, ctx->f, r, r->seen.mode);
+    cr_output_region(&strm, ctx->f, r, report_seen(ctx, r));
 }
 
 static void cb_output_price(struct demand *dmd, int n, void *data)
@@ -1668,7 +1672,7 @@ report_computer(const char *filename, report_context * ctx, const char *bom)
 
     /* traverse all regions */
     for (r = ctx->first; r != ctx->last; r = r->next) {
-        if (r->seen.mode > seen_none) {
+        if (report_seen(ctx, r) > seen_none) {
             cr_output_region_compat(F, ctx, r);
         }
     }
@@ -1680,6 +1684,32 @@ report_computer(const char *filename, report_context * ctx, const char *bom)
     return 0;
 }
 
+/* the delta against the previous turn's computer report. It is made from
+ * the .cr file, which is written first if the faction does not want one. */
+static int
+report_delta(const char *filename, report_context * ctx, const char *bom)
+{
+    char crfile[4096], statebase[4096];
+    bool want_cr = (ctx->f->options & WANT_OPTION(O_COMPUTER)) != 0;
+    size_t len = str_strlcpy(crfile, filename, sizeof(crfile));
+    int err;
+
+    assert(len > 1 && len < sizeof(crfile) && crfile[len - 1] == 'd');
+    crfile[len - 1] = 0;
+    if (!want_cr) {
+        err = report_computer(crfile, ctx, bom);
+        if (err) {
+            return err;
+        }
+    }
+    path_join(datapath(), itoa36(ctx->f->no), statebase, sizeof(statebase));
+    err = crdelta_write(crfile, filename, statebase, turn);
+    if (!want_cr) {
+        remove(crfile);
+    }
+    return err;
+}
+
 int crwritemap(const char *filename)
 {
     FILE *F = fopen(filename, "w");
@@ -1729,8 +1759,11 @@ void register_cr(void)
     tsf_register("items", cr_resources);
     tsf_register("regions", cr_regions);
 
-    if (!nocr)
+    if (!nocr) {
         register_reporttype("cr", &report_computer, 1 << O_COMPUTER);
+        register_reporttype("crd", &report_delta, 1 << O_CRDELTA);
+    }
+    workers_atexit(creport_cleanup);
 }
 
 void creport_cleanup(void)
@@ -87,11 +87,13 @@ static void add_request(econ_request * req, enum econ_type type, unit *u, order
 
 static bool rule_auto_taxation(void)
 {
-    return config_get_int("rules.economy.taxation", 0) != 0;
+    static config_int rule = CONFIG_INT("rules.economy.taxation", 0);
+    return config_int_get(&rule) != 0;
 }
 
 static bool rule_autowork(void) {
-    return config_get_int("work.auto", 0) != 0;
+    static config_int rule = CONFIG_INT("work.auto", 0);
+    return config_int_get(&rule) != 0;
 }
 
 int entertainmoney(const region * r)
@@ -210,6 +212,8 @@ void give_control(unit * u, unit * u2)
     }
 }
 
+static mt_handle mh_givecommand = MT_HANDLE("givecommand", "unit recipient");
+
 int give_control_cmd(unit * u, order * ord)
 {
     char token[128];
@@ -253,7 +257,7 @@ int give_control_cmd(unit * u, order * ord)
             }
         }
         if (okay) {
-            message *msg = msg_message("givecommand", "unit recipient", u, u2);
+            message *msg = msg_handle(&mh_givecommand, u, u2);
             add_message(&u->faction->msgs, msg);
             if (u->faction != u2->faction) {
                 add_message(&u2->faction->msgs, msg);
@@ -265,6 +269,8 @@ int give_control_cmd(unit * u, order * ord)
     return 0;
 }
 
+static mt_handle mh_forget = MT_HANDLE("forget", "unit skill");
+
 int forget_cmd(unit * u, order * ord)
 {
     char token[128];
@@ -298,12 +304,17 @@ int forget_cmd(unit * u, order * ord)
                 a_removeall(&u->attribs, &at_familiar);
             }
         }
-        ADDMSG(&u->faction->msgs, msg_message("forget", "unit skill", u, sk));
+        ADDMSG(&u->faction->msgs, msg_handle(&mh_forget, u, sk));
         set_level(u, sk, 0);
     }
     return 0;
 }
 
+static mt_handle mh_maintenance_noowner = MT_HANDLE("maintenance_noowner", "building");
+static mt_handle mh_maintenance_nowork = MT_HANDLE("maintenance_nowork", "building");
+static mt_handle mh_maintenancefail = MT_HANDLE("maintenancefail", "unit building");
+static mt_handle mh_maintenance = MT_HANDLE("maintenance", "unit building");
+
 static bool maintain(building * b)
 {
     int c;
@@ -321,14 +332,15 @@ static bool maintain(building * b)
     }
     /* If the owner is the region owner, check if dontpay flag is set for the building he is in */
     if (b != u->building) {
-        if (!config_token("rules.region_owner_pay_building", b->type->_name)) {
+        static config_tokens owner_pays = CONFIG_TOKENS("rules.region_owner_pay_building");
+        if (!config_tokens_has(&owner_pays, b->type->_name)) {
             /* no owner - send a message to the entire region */
-            ADDMSG(&r->msgs, msg_message("maintenance_noowner", "building", b));
+            ADDMSG(&r->msgs, msg_handle(&mh_maintenance_noowner, b));
             return false;
         }
     }
     if (fval(u->building, BLD_DONTPAY)) {
-        ADDMSG(&r->msgs, msg_message("maintenance_nowork", "building", b));
+        ADDMSG(&r->msgs, msg_handle(&mh_maintenance_nowork, b));
         return false;
     }
     for (c = 0; b->type->maintenance[c].number && paid; ++c) {
@@ -343,8 +355,8 @@ static bool maintain(building * b)
         }
     }
     if (!paid) {
-        ADDMSG(&u->faction->msgs, msg_message("maintenancefail", "unit building", u, b));
-        ADDMSG(&r->msgs, msg_message("maintenance_nowork", "building", b));
+        ADDMSG(&u->faction->msgs, msg_handle(&mh_maintenancefail, u, b));
+        ADDMSG(&r->msgs, msg_handle(&mh_maintenance_nowork, b));
         return paid;
     }
     for (c = 0; b->type->maintenance[c].number; ++c) {
@@ -359,7 +371,7 @@ static bool maintain(building * b)
                 cost);
         assert(cost == 0);
     }
-    ADDMSG(&u->faction->msgs, msg_message("maintenance", "unit building", u, b));
+    ADDMSG(&u->faction->msgs, msg_handle(&mh_maintenance, u, b));
     return true;
 }
 
@@ -416,6 +428,8 @@ void do_give(region * r)
     }
 }
 
+static mt_handle mh_destroy_road = MT_HANDLE("destroy_road", "unit from to");
+
 static void destroy_road(unit* u, int nmax, struct order* ord)
 {
     char token[128];
@@ -462,13 +476,17 @@ static void destroy_road(unit* u, int nmax, struct order* ord)
                 road = (short)(road - willdo);
             rsetroad(r, d, road);
             if (willdo > 0) {
-                ADDMSG(&u->faction->msgs, msg_message("destroy_road",
-                    "unit from to", u, r, r2));
+                ADDMSG(&u->faction->msgs, msg_handle(&mh_destroy_road, u, r, r2));
             }
         }
     }
 }
 
+static mt_handle mh_destroy = MT_HANDLE("destroy", "building unit");
+static mt_handle mh_destroy_partial = MT_HANDLE("destroy_partial", "building unit");
+static mt_handle mh_shipdestroy = MT_HANDLE("shipdestroy", "unit region ship");
+static mt_handle mh_shipdestroy_partial = MT_HANDLE("shipdestroy_partial", "unit region ship");
+
 int destroy_cmd(unit* u, struct order* ord)
 {
     char token[128];
@@ -527,7 +545,7 @@ int destroy_cmd(unit* u, struct order* ord)
                     leave_building(u2);
                 }
             }
-            ADDMSG(&u->faction->msgs, msg_message("destroy", "building unit", b, u));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_destroy, b, u));
 
             for (s = 0; s != len; ++s) {
                 building_stage *stage = b->type->a_stages + s;
@@ -538,8 +556,7 @@ int destroy_cmd(unit* u, struct order* ord)
         else {
             /* TODO: partial destroy does not recycle */
             b->size -= n;
-            ADDMSG(&u->faction->msgs, msg_message("destroy_partial",
-                "building unit", b, u));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_destroy_partial, b, u));
         }
     }
     else if (u->ship) {
@@ -562,16 +579,14 @@ int destroy_cmd(unit* u, struct order* ord)
                     leave_ship(u2);
                 }
             }
-            ADDMSG(&u->faction->msgs, msg_message("shipdestroy",
-                "unit region ship", u, r, sh));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_shipdestroy, u, r, sh));
             size = recycle(u, sh->type->construction, size);
             remove_ship(&sh->region->ships, sh);
         }
         else {
             /* partial destroy */
             sh->size -= (ship_maxsize(sh) * n) / 100;
-            ADDMSG(&u->faction->msgs, msg_message("shipdestroy_partial",
-                "unit region ship", u, r, sh));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_shipdestroy_partial, u, r, sh));
         }
     }
     else {
@@ -668,6 +683,8 @@ static struct message * get_modifiers(unit *u, skill_t sk, const resource_type *
     return NULL;
 }
 
+static mt_handle mh_produce = MT_HANDLE("produce", "unit region amount wanted resource");
+
 static void manufacture(unit * u, const item_type * itype, int want)
 {
     int n;
@@ -705,8 +722,7 @@ static void manufacture(unit * u, const item_type * itype, int want)
         i_change(&u->items, itype, n);
         if (want == INT_MAX)
             want = n;
-        ADDMSG(&u->faction->msgs, msg_message("produce",
-            "unit region amount wanted resource", u, u->region, n, want,
+        ADDMSG(&u->faction->msgs, msg_handle(&mh_produce, u, u->region, n, want,
             itype->rtype));
     }
     else {
@@ -996,8 +1012,7 @@ void split_allocations(region * r)
             }
             if (al->want == INT_MAX)
                 al->want = al->get;
-            ADDMSG(&al->unit->faction->msgs, msg_message("produce",
-                "unit region amount wanted resource",
+            ADDMSG(&al->unit->faction->msgs, msg_handle(&mh_produce,
                 al->unit, al->unit->region, al->get, al->want, rtype));
             *p_al = al->next;
             free_allocation(al);
@@ -1034,8 +1049,7 @@ static void create_potion(unit * u, const item_type * itype, int want)
         i_change(&u->items, itype, built);
         if (want == INT_MAX)
             want = built;
-        ADDMSG(&u->faction->msgs, msg_message("produce",
-            "unit region amount wanted resource", u, u->region, built, want,
+        ADDMSG(&u->faction->msgs, msg_handle(&mh_produce, u, u->region, built, want,
             itype->rtype));
         break;
     }
@@ -1237,6 +1251,9 @@ int max_luxuries_sold(const region* r)
     return rpeasants(r) / TRADE_FRACTION;
 }
 
+static mt_handle mh_buy = MT_HANDLE("buy", "unit money");
+static mt_handle mh_buyamount = MT_HANDLE("buyamount", "unit amount resource");
+
 static void expandbuying(region * r, econ_request * buyorders)
 {
     const resource_type *rsilver = get_resourcetype(R_SILVER);
@@ -1315,10 +1332,10 @@ static void expandbuying(region * r, econ_request * buyorders)
                 struct trade* t = NULL;
                 t = (struct trade*)a->data.v;
                 if (t) {
-                    ADDMSG(&u->faction->msgs, msg_message("buy", "unit money", u, t->price));
+                    ADDMSG(&u->faction->msgs, msg_handle(&mh_buy, u, t->price));
                     if (t->trades) {
-                        ADDMSG(&u->faction->msgs, msg_message("buyamount",
-                            "unit amount resource", u, t->trades, it_sold->rtype));
+                        ADDMSG(&u->faction->msgs, msg_handle(&mh_buyamount,
+                            u, t->trades, it_sold->rtype));
                         i_change(&u->items, it_sold, t->trades);
                     }
                     /* prevent reporting this as a sale */
@@ -1440,17 +1457,20 @@ static void buy(unit * u, econ_request ** buyorders, struct order *ord)
     o->type = ECON_BUY;
 }
 
+static mt_handle mh_income = MT_HANDLE("income", "unit region mode wanted amount");
+
 /* ------------------------------------------------------------- */
 void add_income(unit * u, income_t type, int want, int qty)
 {
     if (want == INT_MAX)
         want = qty;
     if (qty > 0 || type != IC_TRADE) {
-        ADDMSG(&u->faction->msgs, msg_message("income",
-            "unit region mode wanted amount", u, u->region, (int)type, want, qty));
+        ADDMSG(&u->faction->msgs, msg_handle(&mh_income, u, u->region, (int)type, want, qty));
     }
 }
 
+static mt_handle mh_sellamount = MT_HANDLE("sellamount", "unit amount resource");
+
 /* Steuersaetze in % bei Burggroesse */
 static int tax_per_size[7] = { 0, 6, 12, 18, 24, 30, 36 };
 
@@ -1646,8 +1666,8 @@ static void expandselling(region * r, econ_request * sellorders, int limit)
             t = (struct trade*)a->data.v;
             for (itm = t->items; itm; itm = itm->next) {
                 if (itm->number) {
-                    ADDMSG(&u->faction->msgs, msg_message("sellamount",
-                        "unit amount resource", u, itm->number, itm->type->rtype));
+                    ADDMSG(&u->faction->msgs, msg_handle(&mh_sellamount,
+                        u, itm->number, itm->type->rtype));
                 }
             }
             income = t->price - hafencollected - taxcollected;
@@ -1776,6 +1796,8 @@ static bool sell(unit * u, econ_request ** sellorders, struct order *ord)
     }
 }
 
+static mt_handle mh_plant = MT_HANDLE("plant", "unit region amount herb");
+
 /* ------------------------------------------------------------- */
 static void plant(unit * u, int raw)
 {
@@ -1831,7 +1853,7 @@ static void plant(unit * u, int raw)
     use_pooled(u, rt_water, GET_DEFAULT, 1);
     use_pooled(u, itype->rtype, GET_DEFAULT, n);
     rsetherbs(r, rherbs(r) + planted);
-    ADDMSG(&u->faction->msgs, msg_message("plant", "unit region amount herb",
+    ADDMSG(&u->faction->msgs, msg_handle(&mh_plant,
         u, r, planted, itype->rtype));
 }
 
@@ -1898,10 +1920,11 @@ static void breedtrees(unit * u, int raw)
     produceexp(u, SK_HERBALISM);
     use_pooled(u, rtype, GET_DEFAULT, n);
 
-    ADDMSG(&u->faction->msgs, msg_message("plant",
-        "unit region amount herb", u, r, n, rtype));
+    ADDMSG(&u->faction->msgs, msg_handle(&mh_plant, u, r, n, rtype));
 }
 
+static mt_handle mh_raised = MT_HANDLE("raised", "unit amount");
+
 /* zuechte pferde */
 static void breedhorses(unit * u)
 {
@@ -1938,7 +1961,7 @@ static void breedhorses(unit * u)
 
     produceexp(u, SK_HORSE_TRAINING);
 
-    ADDMSG(&u->faction->msgs, msg_message("raised", "unit amount", u, breed));
+    ADDMSG(&u->faction->msgs, msg_handle(&mh_raised, u, breed));
 }
 
 static void breed_cmd(unit * u, struct order *ord)
@@ -2017,6 +2040,9 @@ static const char *rough_amount(int a, int m)
     return "sehr viele";
 }
 
+static mt_handle mh_researchherb = MT_HANDLE("researchherb", "unit region amount herb");
+static mt_handle mh_researchherb_none = MT_HANDLE("researchherb_none", "unit region");
+
 static void research_cmd(unit * u, struct order *ord)
 {
     region *r = u->region;
@@ -2034,18 +2060,15 @@ static void research_cmd(unit * u, struct order *ord)
         const item_type *itype = rherbtype(r);
 
         if (itype != NULL) {
-            ADDMSG(&u->faction->msgs, msg_message("researchherb",
-                "unit region amount herb",
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_researchherb,
                 u, r, rough_amount(rherbs(r), 100), itype->rtype));
         }
         else {
-            ADDMSG(&u->faction->msgs, msg_message("researchherb_none",
-                "unit region", u, r));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_researchherb_none, u, r));
         }
     }
     else {
-        ADDMSG(&u->faction->msgs, msg_message("researchherb_none",
-            "unit region", u, r));
+        ADDMSG(&u->faction->msgs, msg_handle(&mh_researchherb_none, u, r));
     }
 }
 
@@ -2346,6 +2369,8 @@ void tax_cmd(unit * u, struct order *ord, econ_request ** taxorders)
     return;
 }
 
+static config_int enable_loot = CONFIG_INT("rules.enable_loot", 0);
+
 void loot_cmd(unit * u, struct order *ord, econ_request ** lootorders)
 {
     region *r = u->region;
@@ -2356,7 +2381,7 @@ void loot_cmd(unit * u, struct order *ord, econ_request ** lootorders)
 
     init_order(ord, NULL);
 
-    if (config_get_int("rules.enable_loot", 0) == 0 && !IS_MONSTERS(u->faction)) {
+    if (config_int_get(&enable_loot) == 0 && !IS_MONSTERS(u->faction)) {
         return;
     }
 
@@ -2429,6 +2454,8 @@ void auto_work(region * r)
     }
 }
 
+static mt_handle mh_income_tax = MT_HANDLE("income_tax", "unit region amount");
+
 static void peasant_taxes(region * r)
 {
     faction *f;
@@ -2464,8 +2491,7 @@ static void peasant_taxes(region * r)
             int taxmoney = (int)taxfactor;
             change_money(u, taxmoney);
             rsetmoney(r, money - taxmoney);
-            ADDMSG(&u->faction->msgs, msg_message("income_tax",
-                "unit region amount", u, r, taxmoney));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_income_tax, u, r, taxmoney));
         }
     }
 }
@@ -16,8 +16,10 @@
 #include "kernel/faction.h"
 #include "kernel/item.h"
 #include "kernel/plane.h"
+#include "kernel/pool.h"
 #include "kernel/race.h"
 #include "kernel/region.h"
+#include "kernel/save.h"
 #include "kernel/ship.h"
 #include "kernel/spell.h"
 #include "kernel/terrain.h"
@@ -201,9 +203,11 @@ void init_locale(struct locale *lang)
  */
 void free_gamedata(void)
 {
+    readgame_lazy_done();
     free_ids();
     free_factions();
     free_donations();
+    pool_done();
     free_units();
     free_regions();
     free_borders();
@@ -214,6 +218,8 @@ void free_gamedata(void)
         planes = planes->next;
         free_plane(pl);
     }
+    /* all message lists are gone with their factions and regions */
+    msg_arena_close();
 }
 
 void free_configuration(void)
@@ -78,6 +78,33 @@ static int tolua_eressea_eressea_read_game00(lua_State* tolua_S)
 #endif
 }
 
+/* function: eressea_read_game_lazy */
+static int tolua_eressea_eressea_read_game_lazy00(lua_State* tolua_S)
+{
+#ifndef TOLUA_RELEASE
+ tolua_Error tolua_err;
+ if (
+ !tolua_isstring(tolua_S,1,0,&tolua_err) || 
+ !tolua_isnoobj(tolua_S,2,&tolua_err)
+ )
+ goto tolua_lerror;
+ else
+#endif
+ {
+  const char* filename = ((const char*)  tolua_tostring(tolua_S,1,0));
+ {
+  int tolua_ret = (int)  eressea_read_game_lazy(filename);
+ tolua_pushnumber(tolua_S,(lua_Number)tolua_ret);
+ }
+ }
+ return 1;
+#ifndef TOLUA_RELEASE
+ tolua_lerror:
+ tolua_error(tolua_S,"#ferror in function 'read_game_lazy'.",&tolua_err);
+ return 0;
+#endif
+}
+
 /* function: eressea_write_game */
 static int tolua_eressea_eressea_write_game00(lua_State* tolua_S)
 {
@@ -199,6 +226,7 @@ int luaopen_eressea (lua_State* tolua_S)
  tolua_beginmodule(tolua_S,"eressea");
  tolua_function(tolua_S,"free_game",tolua_eressea_eressea_free_game00);
  tolua_function(tolua_S,"read_game",tolua_eressea_eressea_read_game00);
+ tolua_function(tolua_S,"read_game_lazy",tolua_eressea_eressea_read_game_lazy00);
  tolua_function(tolua_S,"write_game",tolua_eressea_eressea_write_game00);
  tolua_function(tolua_S,"read_orders",tolua_eressea_eressea_read_orders00);
  tolua_function(tolua_S,"export",tolua_eressea_eressea_export00);
@@ -4,6 +4,7 @@
 #include "exparse.h"
 
 #include "alchemy.h"
+#include "rulecache.h"
 
 #include "modules/score.h"
 
@@ -65,6 +66,7 @@ typedef struct parseinfo {
     XML_Char *cdata;
     size_t clength;
     void *object;
+    struct rc_writer *cache;
 } parseinfo;
 
 static bool xml_strequal(const XML_Char *xs, const char *cs) {
@@ -1295,6 +1297,23 @@ static void start_buildings(parseinfo *pi, const XML_Char *el, const XML_Char **
 
 static void XMLCALL handle_start(void *data, const XML_Char *el, const XML_Char **attr) {
     parseinfo *pi = (parseinfo *)data;
+    if (pi->cache) {
+        const char *args[RC_MAXARGS];
+        int nargs = 0;
+        args[nargs++] = el;
+        while (nargs < RC_MAXARGS && attr[nargs - 1]) {
+            args[nargs] = attr[nargs - 1];
+            ++nargs;
+        }
+        if (attr[nargs - 1]) {
+            /* too many attributes to record, do not cache this file */
+            rulecache_abort(pi->cache);
+            pi->cache = NULL;
+        }
+        else {
+            rulecache_add(pi->cache, RC_START, args, nargs);
+        }
+    }
     if (pi->depth == 0) {
         pi->type = EXP_UNKNOWN;
         if (!xml_strequal(el, "eressea")) {
@@ -1519,6 +1538,10 @@ static void end_buildings(parseinfo *pi, const XML_Char *el) {
 static void XMLCALL handle_end(void *data, const XML_Char *el) {
     parseinfo *pi = (parseinfo *)data;
 
+    if (pi->cache) {
+        rulecache_add(pi->cache, RC_END, &el, 1);
+    }
+
     switch (pi->type) {
     case EXP_RACES:
         end_races(pi, el);
@@ -1558,6 +1581,15 @@ static void XMLCALL handle_end(void *data, const XML_Char *el) {
     }
 }
 
+static void replay_event(int kind, const char **args, int nargs, void *data) {
+    if (kind == RC_START) {
+        handle_start(data, args[0], args + 1);
+    }
+    else if (kind == RC_END && nargs == 1) {
+        handle_end(data, args[0]);
+    }
+}
+
 int exparse_readfile(const char * filename) {
     XML_Parser xp;
     FILE *F;
@@ -1565,6 +1597,10 @@ int exparse_readfile(const char * filename) {
     char buf[4096];
     parseinfo pi;
 
+    memset(&pi, 0, sizeof(pi));
+    if (rulecache_replay(filename, replay_event, &pi) == 0) {
+        return (pi.depth != 0) ? -3 : pi.errors;
+    }
     F = fopen(filename, "r");
     if (!F) {
         return 2;
@@ -1572,7 +1608,7 @@ int exparse_readfile(const char * filename) {
     xp = XML_ParserCreate("UTF-8");
     XML_SetElementHandler(xp, handle_start, handle_end);
     XML_SetUserData(xp, &pi);
-    memset(&pi, 0, sizeof(pi));
+    pi.cache = rulecache_begin(filename);
     for (;;) {
         int len = (int)fread(buf, 1, sizeof(buf), F);
         int done;
@@ -1600,6 +1636,15 @@ int exparse_readfile(const char * filename) {
     }
     XML_ParserFree(xp);
     fclose(F);
+    if (pi.cache) {
+        /* only a clean parse is worth replaying */
+        if (err == 0 && pi.errors == 0) {
+            rulecache_commit(pi.cache);
+        }
+        else {
+            rulecache_abort(pi.cache);
+        }
+    }
     if (err != 0) {
         return err;
     }
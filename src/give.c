@@ -47,12 +47,14 @@
 #define RESERVE_GIVE            /* reserve anything that's given from one unit to another? */
 
 static int max_transfers(void) {
-    return config_get_int("rules.give.max_men", 5);
+    static config_int max_men = CONFIG_INT("rules.give.max_men", 5);
+    return config_int_get(&max_men);
 }
 
 static int GiveRestriction(void)
 {
-    return config_get_int("GiveRestriction", 0);
+    static config_int restriction = CONFIG_INT("GiveRestriction", 0);
+    return config_int_get(&restriction);
 }
 
 static void feedback_give_not_allowed(unit * u, order * ord)
@@ -286,8 +288,8 @@ bool can_give_men(const unit *u, const unit *dst, order *ord, message **msg)
 
 bool rule_transfermen(void)
 {
-    int rule = config_get_int("rules.transfermen", 1);
-    return rule != 0;
+    static config_int rule = CONFIG_INT("rules.transfermen", 1);
+    return config_int_get(&rule) != 0;
 }
 
 static void transfer_ships(ship *s1, ship *s2, int n)
@@ -7,6 +7,7 @@
 #include "move.h"
 #include "prefix.h"
 #include "exparse.h"
+#include "rulecache.h"
 
 /* kernel includes */
 #include "kernel/attrib.h"
@@ -1311,6 +1312,49 @@ static int add_po_string(const char *msgid, const char *msgstr, const char *msgc
     return 0;
 }
 
+typedef struct po_record {
+    struct locale *lang;
+    struct rc_writer *cache;
+} po_record;
+
+static int record_po_string(const char *msgid, const char *msgstr, const char *msgctxt, void *data) {
+    po_record *rec = (po_record *)data;
+    const char *args[3];
+    args[0] = msgid;
+    args[1] = msgstr;
+    args[2] = msgctxt;
+    rulecache_add(rec->cache, RC_STRING, args, msgctxt ? 3 : 2);
+    return add_po_string(msgid, msgstr, msgctxt, rec->lang);
+}
+
+static void replay_po_string(int kind, const char **args, int nargs, void *data) {
+    if (kind == RC_STRING && nargs >= 2) {
+        add_po_string(args[0], args[1], args[2], data);
+    }
+}
+
+static int read_po(const char *filename, struct locale *lang) {
+    po_record rec;
+    int err;
+
+    if (rulecache_replay(filename, replay_po_string, lang) == 0) {
+        return 0;
+    }
+    rec.cache = rulecache_begin(filename);
+    if (!rec.cache) {
+        return pofile_read(filename, add_po_string, lang);
+    }
+    rec.lang = lang;
+    err = pofile_read(filename, record_po_string, &rec);
+    if (err == 0) {
+        rulecache_commit(rec.cache);
+    }
+    else {
+        rulecache_abort(rec.cache);
+    }
+    return err;
+}
+
 static int include_po(const char *uri) {
     char name[PATH_MAX];
     const char *filename = uri_to_file(uri, name, sizeof(name));
@@ -1328,7 +1372,7 @@ static int include_po(const char *uri) {
             lname[len] = 0;
             lang = get_or_create_locale(lname);
             if (lang) {
-                int err = pofile_read(filename, add_po_string, lang);
+                int err = read_po(filename, lang);
                 if (err < 0) {
                     log_error("could not parse translations from %s", uri);
                 }
@@ -16,44 +16,95 @@
 #include <storage.h>
 #include <strings.h>
 
+#include <stb_ds.h>
+
 #include <assert.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 
-#define BLOCKSIZE 15
+/* The allies are kept in the order they were added. Short lists are
+ * searched linearly, longer ones have an open addressing index by
+ * faction, so that each lookup is a single probe in most cases. */
+#define MINHASH 8
+
+typedef struct ally_entry {
+    struct faction *faction;
+    int status;
+} ally_entry;
+
 typedef struct allies {
-    struct allies *next;
-    int num;
-    struct faction *factions[BLOCKSIZE];
-    int status[BLOCKSIZE];
+    ally_entry *entries;    /* stb_ds array */
+    int *slots;             /* entry + 1, or 0 for an empty slot */
+    unsigned int nslots;    /* a power of 2, or 0 */
 } allies;
 
-static void block_insert(allies *al, struct faction *f, int status) {
-    int i = al->num++;
-    assert(status > 0);
-    al->status[i] = status;
-    al->factions[i] = f;
-    /* TODO: heapify */
+static unsigned int ally_hash(const struct faction *f)
+{
+    unsigned int h = (unsigned int)((uintptr_t)f >> 4);
+    h = (h ^ (h >> 16)) * 0x45d9f3bu;
+    return h ^ (h >> 16);
+}
+
+static void index_add(allies *al, int i)
+{
+    unsigned int mask = al->nslots - 1;
+    unsigned int k = ally_hash(al->entries[i].faction) & mask;
+    while (al->slots[k] != 0) {
+        k = (k + 1) & mask;
+    }
+    al->slots[k] = i + 1;
 }
 
-static int block_search(allies *al, const struct faction *f) {
-    int i;
-    /* TODO: binary search */
-    for (i = 0; i != al->num; ++i) {
-        if (al->factions[i] == f) {
-            return i;
+static void index_build(allies *al)
+{
+    int i, num = (int)arrlen(al->entries);
+    free(al->slots);
+    al->slots = NULL;
+    al->nslots = 0;
+    if (num > MINHASH) {
+        unsigned int size = 4 * MINHASH;
+        /* keep the table at most half full */
+        while (size < 2 * (unsigned int)num) size *= 2;
+        al->slots = calloc(size, sizeof(int));
+        if (!al->slots) abort();
+        al->nslots = size;
+        for (i = 0; i != num; ++i) {
+            index_add(al, i);
         }
     }
-    return BLOCKSIZE;
 }
 
-int allies_walk(struct allies *all, cb_allies_walk callback, void *udata)
+static int ally_find(const allies *al, const struct faction *f)
 {
-    allies *al;
-    for (al = all; al; al = al->next) {
+    if (al->slots) {
+        unsigned int mask = al->nslots - 1;
+        unsigned int k = ally_hash(f) & mask;
         int i;
-        for (i = 0; i != al->num; ++i) {
-            int e = callback(all, al->factions[i], al->status[i], udata);
+        while ((i = al->slots[k]) != 0) {
+            if (al->entries[i - 1].faction == f) {
+                return i - 1;
+            }
+            k = (k + 1) & mask;
+        }
+    }
+    else {
+        int i, num = (int)arrlen(al->entries);
+        for (i = 0; i != num; ++i) {
+            if (al->entries[i].faction == f) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+int allies_walk(struct allies *all, cb_allies_walk callback, void *udata)
+{
+    if (all) {
+        ptrdiff_t i, num = arrlen(all->entries);
+        for (i = 0; i != num; ++i) {
+            int e = callback(all, all->entries[i].faction, all->entries[i].status, udata);
             if (e != 0) {
                 return e;
             }
@@ -64,10 +115,10 @@ int allies_walk(struct allies *all, cb_allies_walk callback, void *udata)
 
 int ally_get(allies *al, const struct faction *f)
 {
-    for (; al; al =  al->next) {
-        int i = block_search(al, f);
-        if (i != BLOCKSIZE) {
-            return al->status[i];
+    if (al) {
+        int i = ally_find(al, f);
+        if (i >= 0) {
+            return al->entries[i].status;
         }
     }
     return 0;
@@ -75,52 +126,56 @@ int ally_get(allies *al, const struct faction *f)
 
 void ally_set(allies **p_al, struct faction *f, int status)
 {
-    while (*p_al) {
-        allies *al = *p_al;
-        int i = block_search(al, f);
-        if (i != BLOCKSIZE) {
-            if (status == 0) {
-                if (--al->num != i) {
-                    al->factions[i] = al->factions[al->num];
-                    al->status[i] = al->status[al->num];
-                    /* TODO: repair heap up or down */
-                }
-                else if (al->num == 0) {
-                    *p_al = al->next;
-                    free(al);
-                    return;
-                }
-            }
-            else {
-                al->status[i] = status;
+    allies *al = *p_al;
+    int i = al ? ally_find(al, f) : -1;
+
+    if (i >= 0) {
+        if (status == 0) {
+            ptrdiff_t num = arrlen(al->entries) - 1;
+            if (num == 0) {
+                allies_free(al);
+                *p_al = NULL;
+                return;
             }
-            return;
+            /* the last entry takes the place of the removed one */
+            al->entries[i] = al->entries[num];
+            arrsetlen(al->entries, num);
+            index_build(al);
         }
-        if (al->num < BLOCKSIZE) {
-            if (status > 0) {
-                block_insert(al, f, status);
-            }
-            return;
+        else {
+            al->entries[i].status = status;
         }
-        p_al = &al->next;
     }
-    if (status > 0) {
-        *p_al = calloc(1, sizeof(allies));
-        block_insert(*p_al, f, status);
+    else if (status > 0) {
+        ally_entry entry;
+        ptrdiff_t num;
+        if (!al) {
+            *p_al = al = calloc(1, sizeof(allies));
+            if (!al) abort();
+        }
+        entry.faction = f;
+        entry.status = status;
+        arrput(al->entries, entry);
+        num = arrlen(al->entries);
+        if (num > MINHASH && 2 * num > (ptrdiff_t)al->nslots) {
+            index_build(al);
+        }
+        else if (al->slots) {
+            index_add(al, (int)num - 1);
+        }
     }
 }
 
-void write_allies(gamedata * data, const allies *alist)
+void write_allies(gamedata * data, const allies *al)
 {
-    const allies *al;
-    for (al = alist; al; al = al->next) {
-        int i;
-        for (i = 0; i != al->num; ++i) {
-            const faction * f = al->factions[i];
+    if (al) {
+        ptrdiff_t i, num = arrlen(al->entries);
+        for (i = 0; i != num; ++i) {
+            const faction * f = al->entries[i].faction;
             if (f && faction_alive(f)) {
                 write_faction_reference(f, data->store);
-                assert(al->status[i] > 0);
-                WRITE_INT(data->store, al->status[i]);
+                assert(al->entries[i].status > 0);
+                WRITE_INT(data->store, al->entries[i].status);
             }
         }
     }
@@ -149,24 +204,29 @@ void read_allies(gamedata * data, allies **p_al)
 
 void allies_free(allies *al)
 {
-    while (al) {
-        allies * an = al->next;
+    if (al) {
+        arrfree(al->entries);
+        free(al->slots);
         free(al);
-        al = an;
     }
 }
 
 allies *allies_clone(const allies *al) {
-    allies *al_clone = NULL, **al_end = &al_clone;
-
-    for (; al; al = al->next) {
-        allies *al_new = calloc(1, sizeof(allies));
-        if (!al_new) abort();
-        memcpy(al_new, al, sizeof(allies));
-        *al_end = al_new;
-        al_end = &al_new->next;
+    allies *al_clone;
+
+    if (!al) {
+        return NULL;
+    }
+    al_clone = calloc(1, sizeof(allies));
+    if (!al_clone) abort();
+    arrsetlen(al_clone->entries, arrlen(al->entries));
+    memcpy(al_clone->entries, al->entries, sizeof(ally_entry) * arrlen(al->entries));
+    if (al->slots) {
+        al_clone->slots = malloc(sizeof(int) * al->nslots);
+        if (!al_clone->slots) abort();
+        memcpy(al_clone->slots, al->slots, sizeof(int) * al->nslots);
+        al_clone->nslots = al->nslots;
     }
-    *al_end = NULL;
     return al_clone;
 }
 
@@ -66,6 +66,40 @@ static void test_allies_set(CuTest *tc) {
     test_teardown();
 }
 
+static int cb_count_allies(struct allies *al, struct faction *f, int status, void *udata) {
+    int *count = (int *)udata;
+    ++*count;
+    return 0;
+}
+
+static void test_allies_many(CuTest *tc) {
+    struct faction *factions[100];
+    struct allies *al = NULL, *ac;
+    int i, count = 0;
+
+    test_setup();
+    for (i = 0; i != 100; ++i) {
+        factions[i] = test_create_faction();
+        ally_set(&al, factions[i], 1 + i % 64);
+    }
+    for (i = 0; i != 100; ++i) {
+        CuAssertIntEquals(tc, 1 + i % 64, ally_get(al, factions[i]));
+    }
+    for (i = 0; i < 100; i += 2) {
+        ally_set(&al, factions[i], DONT_HELP);
+    }
+    ac = allies_clone(al);
+    for (i = 0; i != 100; ++i) {
+        CuAssertIntEquals(tc, (i % 2) ? 1 + i % 64 : 0, ally_get(al, factions[i]));
+        CuAssertIntEquals(tc, (i % 2) ? 1 + i % 64 : 0, ally_get(ac, factions[i]));
+    }
+    allies_walk(ac, cb_count_allies, &count);
+    CuAssertIntEquals(tc, 50, count);
+    allies_free(al);
+    allies_free(ac);
+    test_teardown();
+}
+
 static void test_alliedfaction(CuTest *tc) {
     struct faction *f1, *f2;
 
@@ -110,6 +144,7 @@ CuSuite *get_ally_suite(void)
     SUITE_ADD_TEST(suite, test_allies);
     SUITE_ADD_TEST(suite, test_allies_clone);
     SUITE_ADD_TEST(suite, test_allies_set);
+    SUITE_ADD_TEST(suite, test_allies_many);
     SUITE_ADD_TEST(suite, test_alliedfaction);
     SUITE_ADD_TEST(suite, test_alliedunit);
     return suite;
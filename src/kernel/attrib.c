@@ -1,6 +1,7 @@
 #include "attrib.h"
 
 #include <util/log.h>
+#include <util/macros.h>
 #include <util/variant.h>
 #include <kernel/gamedata.h>
 
@@ -183,9 +184,42 @@ attrib *a_select(attrib * a, const void *data,
     return a;
 }
 
+/* counts the changes to attribute lists on this thread, for caches of
+ * values that depend on them */
+static THREAD_LOCAL int a_changes = 1;
+
+bool attrib_changed(int *cache_key)
+{
+    if (*cache_key != a_changes) {
+        *cache_key = a_changes;
+        return true;
+    }
+    return false;
+}
+
+/* The first attribute of a list keeps a bitmap of the types in the list,
+ * so a_find can return early for those that are absent, which is most. */
+static unsigned long long a_typebit(const attrib_type *at)
+{
+    return 1ULL << (at->hashkey & 63);
+}
+
+static void a_settypes(attrib *head)
+{
+    unsigned long long mask = 0;
+    attrib *a;
+    for (a = head; a; a = a->nexttype) {
+        mask |= a_typebit(a->type);
+    }
+    head->typemask = mask;
+}
+
 attrib *a_find(attrib * a, const attrib_type * at)
 {
     assert(at);
+    if (a && a->typemask && !(a->typemask & a_typebit(at))) {
+        return NULL;
+    }
     while (a && a->type != at)
         a = a->nexttype;
     return a;
@@ -210,8 +244,12 @@ attrib *a_add(attrib ** pa, attrib * a)
     attrib *first = *pa;
     assert(a->next == NULL && a->nexttype == NULL);
 
-    if (first == NULL)
+    ++a_changes;
+    if (first == NULL) {
+        a->typemask = a_typebit(a->type);
         return *pa = a;
+    }
+    first->typemask |= a_typebit(a->type);
     if (first->type == a->type) {
         return a_insert(first, a);
     }
@@ -293,9 +331,13 @@ int a_remove(attrib ** pa, attrib * a)
     assert(a != NULL);
     ok = a_unlink(pa, a);
     if (ok) {
+        ++a_changes;
         if (head == a) {
             *pa = a->next;
         }
+        if (*pa) {
+            a_settypes(*pa);
+        }
         a_free(a);
     }
     return ok;
@@ -305,6 +347,7 @@ void a_removeall(attrib ** pa, const attrib_type * at)
 {
     attrib **pnexttype = pa;
 
+    ++a_changes;
     if (!at) {
         while (*pnexttype) {
             attrib *a = *pnexttype;
@@ -335,6 +378,9 @@ void a_removeall(attrib ** pa, const attrib_type * at)
                 a = a->next;
                 a_free(ra);
             }
+            if (*pa) {
+                a_settypes(*pa);
+            }
         }
     }
 }
@@ -18,6 +18,7 @@ extern "C" {
         /* internal data, do not modify: */
         struct attrib *next;        /* next attribute in the list */
         struct attrib *nexttype;    /* skip to attribute of a different type */
+        unsigned long long typemask; /* first in list: types in the list, else 0 */
     } attrib;
 
 #define ATF_UNIQUE   (1<<0)     /* only one per attribute-list */
@@ -54,6 +55,7 @@ extern "C" {
     void a_removeall(attrib ** a, const attrib_type * at);
     attrib *a_new(const attrib_type * at);
     int a_age(attrib ** attribs, void *owner);
+    bool attrib_changed(int *cache_key);
 
     void a_free_voidptr(union variant *v);
     int a_read_orig(struct gamedata *data, attrib ** attribs, void *owner);
@@ -117,6 +117,34 @@ static void test_attrib_nexttype(CuTest * tc)
     a_removeall(&alist, &at_bar);
 }
 
+static void test_attrib_typemask(CuTest * tc)
+{
+    attrib_type at_foo = { "foo" };
+    attrib_type at_bar = { "bar" };
+    attrib_type at_baz = { "baz" };
+    attrib *a, *alist = NULL;
+
+    at_foo.hashkey = 1;
+    at_bar.hashkey = 2;
+    at_baz.hashkey = 3;
+    a = a_add(&alist, a_new(&at_foo));
+    a_add(&alist, a_new(&at_foo));
+    CuAssertPtrEquals(tc, NULL, a_find(alist, &at_bar));
+    a_add(&alist, a_new(&at_bar));
+    CuAssertPtrNotNull(tc, a_find(alist, &at_bar));
+    CuAssertPtrEquals(tc, NULL, a_find(alist, &at_baz));
+
+    /* the second foo becomes the first in the list */
+    a_remove(&alist, a);
+    CuAssertPtrEquals(tc, alist, a_find(alist, &at_foo));
+    CuAssertPtrNotNull(tc, a_find(alist, &at_bar));
+    a_removeall(&alist, &at_foo);
+    CuAssertPtrEquals(tc, &at_bar, (void *)alist->type);
+    CuAssertPtrEquals(tc, NULL, a_find(alist, &at_foo));
+    CuAssertPtrEquals(tc, alist, a_find(alist, &at_bar));
+    a_removeall(&alist, NULL);
+}
+
 static void test_attrib_rwstring(CuTest *tc) {
     gamedata data;
     storage store;
@@ -207,6 +235,7 @@ CuSuite *get_attrib_suite(void)
     SUITE_ADD_TEST(suite, test_attrib_removeall);
     SUITE_ADD_TEST(suite, test_attrib_remove_self);
     SUITE_ADD_TEST(suite, test_attrib_nexttype);
+    SUITE_ADD_TEST(suite, test_attrib_typemask);
     SUITE_ADD_TEST(suite, test_attrib_rwstring);
     SUITE_ADD_TEST(suite, test_attrib_rwint);
     SUITE_ADD_TEST(suite, test_attrib_rwchars);
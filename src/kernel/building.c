@@ -25,6 +25,7 @@
 
 #include <util/base36.h>
 #include <util/functions.h>
+#include <util/macros.h>
 #include <util/keyword.h>
 #include <util/language.h>
 #include <util/log.h>
@@ -161,8 +162,9 @@ attrib_type at_building_generic_type = {
 
 /* TECH DEBT: simplest thing that works for E3 dwarf/halfling faction rules */
 static int adjust_size(const building *b, int bsize) {
+    static config_int dwarf_castles = CONFIG_INT("rules.dwarf_castles", 0);
     assert(b);
-    if (config_get_int("rules.dwarf_castles", 0)
+    if (config_int_get(&dwarf_castles)
         && strcmp(b->type->_name, "castle") == 0) {
         unit *u = building_owner(b);
         if (u && u->faction->race == get_race(RC_HALFLING)) {
@@ -571,7 +573,8 @@ build_building(unit *u, const building_type *btype, int id, int want, order *ord
         n = 1;
     }
     if (b) {
-        bool rule_other = config_get_int("rules.build.other_buildings", 1) != 0;
+        static config_int other_buildings = CONFIG_INT("rules.build.other_buildings", 1);
+        bool rule_other = config_int_get(&other_buildings) != 0;
         if (!rule_other) {
             unit *owner = building_owner(b);
             if (!owner || owner->faction != u->faction) {
@@ -793,8 +796,8 @@ const char *write_buildingname(const building * b, char *ibuf, size_t size)
 const char *buildingname(const building * b)
 {
     typedef char name[OBJECTIDSIZE + 1];
-    static name idbuf[8];
-    static int nextbuf = 0;
+    static THREAD_LOCAL name idbuf[8];
+    static THREAD_LOCAL int nextbuf = 0;
     char *ibuf = idbuf[(++nextbuf) % 8];
     return write_buildingname(b, ibuf, sizeof(idbuf[0]));
 }
@@ -807,6 +810,7 @@ void building_set_owner(struct unit * owner)
 
 static unit *building_owner_ex(const building * bld, const struct faction * last_owner)
 {
+    static config_tokens owner_pays = CONFIG_TOKENS("rules.region_owner_pay_building");
     unit *u, *heir = NULL;
     /* Eigentuemer tot oder kein Eigentuemer vorhanden.
      * Erste lebende Einheit nehmen. */
@@ -823,7 +827,7 @@ static unit *building_owner_ex(const building * bld, const struct faction * last
             }
         }
     }
-    if (!heir && config_token("rules.region_owner_pay_building", bld->type->_name)) {
+    if (!heir && config_tokens_has(&owner_pays, bld->type->_name)) {
         if (rule_region_owners()) {
             u = building_owner(largestbuilding(bld->region, cmp_taxes, false));
         }
@@ -3,6 +3,7 @@
 
 #include "kernel/config.h"
 #include "util/log.h"
+#include "util/macros.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -19,7 +20,7 @@ season_t *month_season = NULL;
 
 const char *calendar_month(int index)
 {
-    static char result[20];
+    static THREAD_LOCAL char result[20];
     snprintf(result, sizeof(result), "month_%d", index + 1);
     return result;
 }
@@ -33,7 +34,7 @@ season_t calendar_season(int now) {
 
 const char *calendar_era(void)
 {
-    static char result[20];
+    static THREAD_LOCAL char result[20];
     int era = config_get_int("game.era", 1);
     snprintf(result, sizeof(result), "age_%d", era);
     return result;
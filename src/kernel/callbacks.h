@@ -18,6 +18,9 @@ struct callback_struct {
     void(*produce_resource)(struct region *, const struct resource_type *, int);
     int(*limit_resource)(const struct region *, const struct resource_type *);
     void (*report_special_attacks)(const struct fighter *fig, const struct item_type *itype);
+    /* called when findregion or findunit miss, to load the object on demand */
+    struct region *(*load_region)(int x, int y);
+    struct unit *(*load_unit)(int no);
 };
 
 extern struct callback_struct callbacks;
@@ -16,6 +16,7 @@
 #include "move.h"
 #include "objtypes.h"
 #include "order.h"
+#include "pathfinder.h"
 #include "plane.h"
 #include "pool.h"
 #include "race.h"
@@ -41,6 +42,7 @@
 #include <util/rng.h>
 #include <util/translation.h>
 #include <util/umlaut.h>
+#include <util/workers.h>
 
 #include "guard.h"
 #include "prefix.h"
@@ -156,7 +158,7 @@ static const char * relpath(char *buf, size_t sz, const char *path) {
 static const char *g_datadir;
 const char *datapath(void)
 {
-    static char zText[4096];
+    static THREAD_LOCAL char zText[4096];
     if (g_datadir)
         return g_datadir;
     return relpath(zText, sizeof(zText), "data");
@@ -170,7 +172,7 @@ void set_datapath(const char *path)
 static char *g_reportdir;
 const char *reportpath(void)
 {
-    static char zText[4096];
+    static THREAD_LOCAL char zText[4096];
     if (g_reportdir)
         return g_reportdir;
     return relpath(zText, sizeof(zText), "reports");
@@ -268,6 +270,13 @@ void kernel_init(void)
     register_reports();
     mt_clear();
     translation_init();
+    workers_atexit(pathfinder_cleanup);
+    pool_init();
+}
+
+void config_threads(void)
+{
+    workers_set_count(config_get_int("game.threads", 1));
 }
 
 int rule_give(void)
@@ -293,6 +302,72 @@ bool config_changed(int *cache_key) {
     return false;
 }
 
+/* Handles are shared by worker threads. The configuration does not
+ * change while workers run, so a stale handle is refreshed at most once
+ * per parallel section: under the lock, with the key published after
+ * the value. Readers that see the current key use the value without
+ * locking, and a value is only freed while nobody else can hold it. */
+int config_int_get(config_int *ci)
+{
+    int key = config_cache_key;
+    if (WORKERS_LOAD_ACQUIRE(&ci->cache_key) != key) {
+        workers_lock();
+        if (ci->cache_key != key) {
+            ci->value = config_get_int(ci->key, ci->def);
+            WORKERS_STORE_RELEASE(&ci->cache_key, key);
+        }
+        workers_unlock();
+    }
+    return ci->value;
+}
+
+double config_flt_get(config_flt *cf)
+{
+    int key = config_cache_key;
+    if (WORKERS_LOAD_ACQUIRE(&cf->cache_key) != key) {
+        workers_lock();
+        if (cf->cache_key != key) {
+            cf->value = config_get_flt(cf->key, cf->def);
+            WORKERS_STORE_RELEASE(&cf->cache_key, key);
+        }
+        workers_unlock();
+    }
+    return cf->value;
+}
+
+static bool has_token(const char *value, const char *tok)
+{
+    size_t len = strlen(tok);
+
+    /* scan in place instead of strtok, this may run on worker threads */
+    while (value && *value) {
+        size_t n;
+        value += strspn(value, " ,;");
+        n = strcspn(value, " ,;");
+        if (n > 0 && n == len && strncmp(value, tok, n) == 0) {
+            return true;
+        }
+        value += n;
+    }
+    return false;
+}
+
+bool config_tokens_has(config_tokens *ct, const char *tok)
+{
+    int key = config_cache_key;
+    if (WORKERS_LOAD_ACQUIRE(&ct->cache_key) != key) {
+        workers_lock();
+        if (ct->cache_key != key) {
+            const char *value = config_get(ct->key);
+            free(ct->value);
+            ct->value = value ? str_strdup(value) : NULL;
+            WORKERS_STORE_RELEASE(&ct->cache_key, key);
+        }
+        workers_unlock();
+    }
+    return has_token(ct->value, tok);
+}
+
 #define MAXKEYS 16
 void config_set_from(const struct _dictionary_ *d, const char *valid_keys[])
 {
@@ -339,12 +414,14 @@ void config_set_from(const struct _dictionary_ *d, const char *valid_keys[])
 
 void config_set(const char *key, const char *value)
 {
+    assert(!workers_active());
     ++config_cache_key;
     params_set(&configuration, key, value);
 }
 
 void config_set_int(const char *key, int value)
 {
+    assert(!workers_active());
     ++config_cache_key;
     params_set(&configuration, key, itoa10(value));
 }
@@ -380,7 +457,7 @@ const char * game_mailcmd(void)
 {
     const char *param = config_get("game.mailcmd");
     if (!param) {
-        static char result[32]; /* FIXME: static result */
+        static THREAD_LOCAL char result[32]; /* FIXME: static result */
         char *r = result;
         const char *c;
         param = game_name();
@@ -471,24 +548,7 @@ int params_get_int(const struct params* p, const char* key, int def)
 
 int params_check(const struct params* p, const char* key, const char* searchvalue)
 {
-    int result = 0;
-    const char* value = params_get(p, key);
-    char* v, * p_value;
-    if (!value) {
-        return 0;
-    }
-    p_value = str_strdup(value);
-    v = strtok(p_value, " ,;");
-
-    while (v != NULL) {
-        if (strcmp(v, searchvalue) == 0) {
-            result = 1;
-            break;
-        }
-        v = strtok(NULL, " ,;");
-    }
-    free(p_value);
-    return result;
+    return has_token(params_get(p, key), searchvalue);
 }
 
 double params_get_flt(const struct params* p, const char* key, double def)
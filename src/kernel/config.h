@@ -80,6 +80,11 @@ extern "C" {
     void kernel_init(void);
     void kernel_done(void);
 
+    /* size the worker pool from game.threads (default 1). Every phase
+     * that runs on the pool calls this first: process(), do_battles()
+     * and reports(), so each of them can also be run on its own. */
+    void config_threads(void);
+
     /* globale settings des Spieles */
     typedef struct settings {
         void *vm_state;
@@ -96,6 +101,36 @@ extern "C" {
     bool config_token(const char *key, const char *tok);
     bool config_changed(int *cache_key);
 
+    /* Typed handles for configuration values that are used often. The
+     * value is parsed on first use, and again after config_set. */
+    typedef struct config_int {
+        const char *key;
+        int def;
+        int cache_key;
+        int value;
+    } config_int;
+
+    typedef struct config_flt {
+        const char *key;
+        double def;
+        int cache_key;
+        double value;
+    } config_flt;
+
+    typedef struct config_tokens {
+        const char *key;
+        int cache_key;
+        char *value;
+    } config_tokens;
+
+#define CONFIG_INT(key, def) { key, def, 0, 0 }
+#define CONFIG_FLT(key, def) { key, def, 0, 0.0 }
+#define CONFIG_TOKENS(key) { key, 0, NULL }
+
+    int config_int_get(config_int *ci);
+    double config_flt_get(config_flt *cf);
+    bool config_tokens_has(config_tokens *ct, const char *tok);
+
     char * join_path(const char *p1, const char *p2, char *dst, size_t len);
 
     void free_config(void);
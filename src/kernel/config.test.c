@@ -7,6 +7,7 @@
 #include <util/keyword.h>    // for K_GIVE, enable_keyword, K_WORK, K_ENTERTAIN
 #include <util/language.h>
 #include <util/param.h>
+#include <util/workers.h>
 
 #include <iniparser.h>
 #include <CuTest.h>
@@ -147,6 +148,60 @@ static void test_config_cache(CuTest *tc) {
     test_teardown();
 }
 
+static void test_config_handles(CuTest *tc) {
+    config_int ci = CONFIG_INT("hodor", 4);
+    config_flt cf = CONFIG_FLT("hodor", 0.5);
+    config_tokens ct = CONFIG_TOKENS("hodor");
+
+    test_setup();
+    CuAssertIntEquals(tc, 4, config_int_get(&ci));
+    CuAssertDblEquals(tc, 0.5, config_flt_get(&cf), 0.0);
+    CuAssertTrue(tc, !config_tokens_has(&ct, "2"));
+    config_set("hodor", "2");
+    CuAssertIntEquals(tc, 2, config_int_get(&ci));
+    CuAssertDblEquals(tc, 2.0, config_flt_get(&cf), 0.0);
+    CuAssertTrue(tc, config_tokens_has(&ct, "2"));
+    config_set("hodor", "castle, 3");
+    CuAssertTrue(tc, config_tokens_has(&ct, "castle"));
+    CuAssertTrue(tc, config_tokens_has(&ct, "3"));
+    CuAssertTrue(tc, !config_tokens_has(&ct, "cast"));
+    free_config();
+    CuAssertIntEquals(tc, 4, config_int_get(&ci));
+    CuAssertTrue(tc, !config_tokens_has(&ct, "castle"));
+    test_teardown();
+}
+
+typedef struct handle_job {
+    config_int ci;
+    config_tokens ct;
+    int results[64];
+} handle_job;
+
+static void read_handles(int index, void *udata)
+{
+    handle_job *job = (handle_job *)udata;
+    job->results[index] = config_int_get(&job->ci)
+        + (config_tokens_has(&job->ct, "castle") ? 1 : 0);
+}
+
+static void test_config_handles_parallel(CuTest *tc) {
+    handle_job job = { CONFIG_INT("hodor.int", 4), CONFIG_TOKENS("hodor"), { 0 } };
+    int i;
+
+    test_setup();
+    config_set("hodor", "castle, 3");
+    config_set("hodor.int", "7");
+    /* every worker finds the handles stale, only one refreshes them */
+    workers_set_count(4);
+    workers_run(64, read_handles, &job);
+    workers_set_count(1);
+    for (i = 0; i != 64; ++i) {
+        CuAssertIntEquals(tc, 8, job.results[i]);
+    }
+    free(job.ct.value);
+    test_teardown();
+}
+
 static void test_rules(CuTest *tc) {
     CuAssertIntEquals(tc, HARVEST_WORK, rule_blessed_harvest());
     config_set("rules.blessed_harvest.flags", "15");
@@ -234,6 +289,7 @@ CuSuite *get_config_suite(void)
     SUITE_ADD_TEST(suite, test_findparam);
     SUITE_ADD_TEST(suite, test_config_inifile);
     SUITE_ADD_TEST(suite, test_config_cache);
+    SUITE_ADD_TEST(suite, test_config_handles);
     SUITE_ADD_TEST(suite, test_get_set_param);
     SUITE_ADD_TEST(suite, test_param_int);
     SUITE_ADD_TEST(suite, test_param_flt);
@@ -241,6 +297,7 @@ CuSuite *get_config_suite(void)
     SUITE_ADD_TEST(suite, test_read_unitid);
     SUITE_ADD_TEST(suite, test_default_order);
     SUITE_ADD_TEST(suite, test_game_mailcmd);
+    SUITE_ADD_TEST(suite, test_config_handles_parallel);
     SUITE_ADD_TEST(suite, test_rules);
     return suite;
 }
@@ -450,7 +450,7 @@ static const char *b_nameroad(const connection * b, const region * r,
 {
     region *r2 = (r == b->to) ? b->from : b->to;
     int local = (r == b->from) ? b->data.sa[0] : b->data.sa[1];
-    static char buffer[64];
+    static THREAD_LOCAL char buffer[64];
 
     UNUSED_ARG(f);
     if (gflags & GF_PURE)
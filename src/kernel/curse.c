@@ -330,21 +330,12 @@ static bool cmp_curse(const attrib * a, const void *data)
 
 curse *get_curse(const attrib * ap, const curse_type * ctype)
 {
-    const attrib *a = ap;
+    const attrib *a;
     if (!ctype) return NULL;
-    while (a) {
-        if (a->type == &at_curse) {
-            const attrib_type *at = a->type;
-            while (a && a->type == at) {
-                curse *c = (curse *)a->data.v;
-                if (c->type == ctype)
-                    return c;
-                a = a->next;
-            }
-        }
-        else {
-            a = a->nexttype;
-        }
+    for (a = a_find((attrib *)ap, &at_curse); a && a->type == &at_curse; a = a->next) {
+        curse *c = (curse *)a->data.v;
+        if (c->type == ctype)
+            return c;
     }
     return NULL;
 }
@@ -397,6 +388,7 @@ double curse_changevigour(attrib ** ap, curse * c, double vigour)
     }
     else {
         set_cursevigour(c, vigour);
+        effskill_changed();
     }
     return vigour;
 }
@@ -558,6 +550,7 @@ curse *create_curse(unit * magician, attrib ** ap, const curse_type * ct,
             c->data.i += men;
         }
         set_curseingmagician(magician, *ap, ct);
+        effskill_changed();
     }
     else if (ap) {
         c = make_curse(magician, ap, ct, vigour, duration, effect, men);
@@ -1,6 +1,7 @@
 #include "config.h"
 #include "database.h"
 #include "db/driver.h"
+#include "order.h"
 
 void swapdb_open(void)
 {
@@ -11,6 +12,7 @@ void swapdb_open(void)
 
 void swapdb_close(void)
 {
+    free_order_tokens();
     db_driver_close(DB_SWAP);
 }
 
@@ -1,12 +1,14 @@
 #include <kernel/faction.h>
 #include <kernel/order.h>
 
+#include "db/arena.h"
 #include "db/driver.h"
 
 #include <CuTest.h>
 #include <tests.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static void test_orderdb(CuTest *tc) {
@@ -42,6 +44,50 @@ static void test_save_load_order(CuTest *tc) {
     test_teardown();
 }
 
+static void test_arena(CuTest *tc) {
+    string_arena arena;
+    dbrow_id id1, id2;
+    const char *str;
+    size_t len;
+
+    CuAssertIntEquals(tc, 0, arena_open(&arena, NULL));
+    CuAssertPtrEquals(tc, NULL, (void *)arena_load(&arena, 1, NULL));
+    id1 = arena_save(&arena, "GIB enno 1 Hodor");
+    id2 = arena_save(&arena, "LERNE Hiebwaffen");
+    CuAssertTrue(tc, id1 != 0);
+    CuAssertTrue(tc, id1 != id2);
+    CuAssertIntEquals(tc, id1, arena_save(&arena, "GIB enno 1 Hodor"));
+    str = arena_load(&arena, id1, &len);
+    CuAssertStrEquals(tc, "GIB enno 1 Hodor", str);
+    CuAssertIntEquals(tc, 16, (int)len);
+    CuAssertPtrEquals(tc, (void *)str, (void *)arena_load(&arena, id1, NULL));
+    CuAssertStrEquals(tc, "LERNE Hiebwaffen", arena_load(&arena, id2, NULL));
+    CuAssertPtrEquals(tc, NULL, (void *)arena_load(&arena, id2 + 1, NULL));
+    arena_close(&arena);
+}
+
+static void test_arena_blocks(CuTest *tc) {
+    string_arena arena;
+    dbrow_id id1, id2;
+    const char *str;
+    char *big;
+
+    big = malloc(ARENA_BLOCKSIZE + 1);
+    CuAssertPtrNotNull(tc, big);
+    memset(big, 'a', ARENA_BLOCKSIZE);
+    big[ARENA_BLOCKSIZE] = 0;
+    CuAssertIntEquals(tc, 0, arena_open(&arena, "arena.test.swap"));
+    id1 = arena_save(&arena, "GIB enno 1 Hodor");
+    id2 = arena_save(&arena, big);
+    str = arena_load(&arena, id1, NULL);
+    CuAssertStrEquals(tc, "GIB enno 1 Hodor", str);
+    CuAssertIntEquals(tc, 0, strcmp(big, arena_load(&arena, id2, NULL)));
+    CuAssertIntEquals(tc, id2 + 1, arena_save(&arena, "LERNE Hiebwaffen"));
+    CuAssertPtrEquals(tc, (void *)str, (void *)arena_load(&arena, id1, NULL));
+    arena_close(&arena);
+    free(big);
+}
+
 static void test_update_faction(CuTest *tc) {
     faction *f;
     int err;
@@ -76,6 +122,8 @@ CuSuite *get_db_suite(void)
     SUITE_ADD_TEST(suite, test_save_load_order);
     SUITE_ADD_TEST(suite, test_update_faction);
     SUITE_ADD_TEST(suite, test_orderdb);
+    SUITE_ADD_TEST(suite, test_arena);
+    SUITE_ADD_TEST(suite, test_arena_blocks);
 
     return suite;
 }
@@ -0,0 +1,169 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "arena.h"
+
+#include <util/log.h>
+
+#include <stb_ds.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct arena_index {
+    char *key;
+    dbrow_id value;
+};
+
+int arena_open(string_arena *a, const char *filename)
+{
+    memset(a, 0, sizeof(string_arena));
+    a->fd = -1;
+#ifndef _WIN32
+    if (filename) {
+        a->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (a->fd < 0) {
+            log_error("could not open %s: %s", filename, strerror(errno));
+            errno = 0;
+            return -1;
+        }
+        a->filename = filename;
+    }
+#endif
+    return 0;
+}
+
+static void block_sync(arena_block *block)
+{
+#ifndef _WIN32
+    /* write the pages of a full block back to disk in one go */
+    msync(block->data, block->size, MS_ASYNC);
+#endif
+}
+
+static void block_free(string_arena *a, arena_block *block)
+{
+#ifndef _WIN32
+    if (a->fd >= 0) {
+        munmap(block->data, block->size);
+        return;
+    }
+#endif
+    free(block->data);
+}
+
+static arena_block *block_add(string_arena *a, size_t len)
+{
+    arena_block block;
+    ptrdiff_t nblocks = arrlen(a->blocks);
+
+    if (nblocks > 0 && a->fd >= 0) {
+        block_sync(a->blocks + nblocks - 1);
+    }
+    block.used = 0;
+    block.size = ARENA_BLOCKSIZE;
+    if (len > block.size) {
+        block.size = (len + ARENA_BLOCKSIZE - 1) / ARENA_BLOCKSIZE * ARENA_BLOCKSIZE;
+    }
+#ifndef _WIN32
+    if (a->fd >= 0) {
+        void *data;
+        off_t offset = (off_t)a->filesize;
+        if (ftruncate(a->fd, offset + (off_t)block.size) != 0) {
+            log_fatal("could not grow %s: %s", a->filename, strerror(errno));
+            abort();
+        }
+        data = mmap(NULL, block.size, PROT_READ | PROT_WRITE, MAP_SHARED, a->fd, offset);
+        if (data == MAP_FAILED) {
+            log_fatal("could not map %s: %s", a->filename, strerror(errno));
+            abort();
+        }
+        a->filesize += block.size;
+        block.data = data;
+        arrput(a->blocks, block);
+        return a->blocks + nblocks;
+    }
+#endif
+    block.data = malloc(block.size);
+    if (!block.data) abort();
+    arrput(a->blocks, block);
+    return a->blocks + nblocks;
+}
+
+void arena_close(string_arena *a)
+{
+    ptrdiff_t i, nblocks = arrlen(a->blocks);
+
+    for (i = 0; i != nblocks; ++i) {
+        block_free(a, a->blocks + i);
+    }
+    arrfree(a->blocks);
+    arrfree(a->entries);
+    shfree(a->index);
+#ifndef _WIN32
+    if (a->fd >= 0) {
+        close(a->fd);
+        if (0 != remove(a->filename)) {
+            log_error("could not remove %s: %s", a->filename, strerror(errno));
+            errno = 0;
+        }
+    }
+#endif
+    a->fd = -1;
+}
+
+dbrow_id arena_save(string_arena *a, const char *str)
+{
+    ptrdiff_t i, nblocks;
+    arena_block *block;
+    arena_entry entry;
+    size_t len;
+    char *result;
+
+    assert(str);
+    i = shgeti(a->index, str);
+    if (i >= 0) {
+        return a->index[i].value;
+    }
+    len = strlen(str);
+    nblocks = arrlen(a->blocks);
+    block = (nblocks > 0) ? a->blocks + nblocks - 1 : NULL;
+    if (!block || block->size - block->used < len + 1) {
+        block = block_add(a, len + 1);
+    }
+    result = block->data + block->used;
+    memcpy(result, str, len + 1);
+    block->used += len + 1;
+
+    entry.str = result;
+    entry.len = len;
+    arrput(a->entries, entry);
+    assert(arrlen(a->entries) < UINT_MAX);
+    shput(a->index, result, (dbrow_id)arrlen(a->entries));
+    return (dbrow_id)arrlen(a->entries);
+}
+
+const char *arena_load(const string_arena *a, dbrow_id id, size_t *size)
+{
+    const arena_entry *entry;
+
+    if (id == 0 || id > (dbrow_id)arrlen(a->entries)) {
+        return NULL;
+    }
+    entry = a->entries + id - 1;
+    if (size) {
+        *size = entry->len;
+    }
+    return entry->str;
+}
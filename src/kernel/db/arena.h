@@ -0,0 +1,40 @@
+#pragma once
+
+#include "driver.h"
+
+#include <stddef.h>
+
+/* An append-only string store. Every distinct string is stored once,
+ * saving the same text twice returns the same id. Stored strings never
+ * move, so the pointers returned by arena_load remain valid until the
+ * arena is closed.
+ * If the arena is opened with a filename, its blocks are memory-mapped
+ * from that file, and the operating system can page them out when the
+ * arena grows larger than physical memory. */
+
+#define ARENA_BLOCKSIZE (1 << 22)
+
+typedef struct arena_entry {
+    const char *str;
+    size_t len;
+} arena_entry;
+
+typedef struct arena_block {
+    char *data;
+    size_t size;
+    size_t used;
+} arena_block;
+
+typedef struct string_arena {
+    arena_block *blocks;
+    arena_entry *entries;
+    struct arena_index *index;
+    const char *filename;
+    int fd;
+    size_t filesize;
+} string_arena;
+
+int arena_open(string_arena *a, const char *filename);
+void arena_close(string_arena *a);
+dbrow_id arena_save(string_arena *a, const char *str);
+const char *arena_load(const string_arena *a, dbrow_id id, size_t *size);
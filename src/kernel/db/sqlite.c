@@ -7,24 +7,31 @@
 #include <util/base36.h>
 
 #include "driver.h"
+#include "arena.h"
+
+#include <kernel/order.h>
 
 #include <sqlite3.h>
 
 #include <assert.h>
 #include <errno.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
 static sqlite3 *g_game_db;
+static sqlite3_stmt * g_stmt_update_faction;
+static sqlite3_stmt * g_stmt_insert_faction;
+/* the order swap is kept in a string arena, unless game.dbarena is 0 */
+static bool g_swap_arena;
+static string_arena g_swap;
 static sqlite3 *g_swap_db;
 static sqlite3_stmt * g_stmt_insert_string;
 static sqlite3_stmt * g_stmt_select_string;
 static sqlite3_stmt * g_stmt_insert_order;
 static sqlite3_stmt * g_stmt_select_order;
-static sqlite3_stmt * g_stmt_update_faction;
-static sqlite3_stmt * g_stmt_insert_faction;
 
 static int g_insert_batchsize;
 static int g_insert_tx_size;
@@ -42,6 +49,27 @@ static int SQLITE_EXEC(sqlite3 *db, const char *sql)
     return SQLITE_CHECK(db, sqlite3_exec(db, sql, NULL, NULL, NULL));
 }
 
+/* orders are kept in the arena, and the order text is not copied when
+ * it is loaded: the order_data points straight into arena memory. */
+static struct order_data *arena_order_load(dbrow_id id)
+{
+    const char *str = arena_load(&g_swap, id, NULL);
+    if (str) {
+        struct order_data *od;
+        odata_create(&od, 0, NULL);
+        od->_str = str;
+        return od;
+    }
+    return NULL;
+}
+
+static int arena_open_swap(const char *dbname) {
+    if (dbname && strcmp(dbname, ":memory:") == 0) {
+        dbname = NULL;
+    }
+    return arena_open(&g_swap, dbname);
+}
+
 static void end_transaction(void) {
     if (g_insert_tx_size > 0) {
         g_insert_tx_size = 0;
@@ -54,6 +82,9 @@ struct order_data *db_driver_order_load(dbrow_id id)
     struct order_data * od = NULL;
     int rc;
 
+    if (g_swap_arena) {
+        return arena_order_load(id);
+    }
     ERRNO_CHECK();
     end_transaction();
     SQLITE_CHECK(g_swap_db, sqlite3_reset(g_stmt_select_order));
@@ -78,6 +109,9 @@ dbrow_id db_driver_order_save(const char *str) {
     int rc;
     
     assert(str);
+    if (g_swap_arena) {
+        return arena_save(&g_swap, str);
+    }
    
     ERRNO_CHECK();
 
@@ -214,6 +248,10 @@ static int db_open_game(const char *dbname) {
 static int db_open_swap(const char *dbname) {
     int err;
 
+    g_swap_arena = config_get_int("game.dbarena", 1) != 0;
+    if (g_swap_arena) {
+        return arena_open_swap(dbname);
+    }
     g_insert_batchsize = config_get_int("game.dbbatch", 100);
 
     err = sqlite3_open(dbname, &g_swap_db);
@@ -232,6 +270,30 @@ static int db_open_swap(const char *dbname) {
 
 static const char *g_swapname;
 
+static void db_close_swap(void) {
+    if (g_swap_arena) {
+        arena_close(&g_swap);
+        return;
+    }
+    assert(g_swap_db);
+    SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_select_string));
+    SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_insert_string));
+    SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_select_order));
+    SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_insert_order));
+    SQLITE_CHECK(g_swap_db, sqlite3_close(g_swap_db));
+    if (g_swapname) {
+        FILE * F = fopen(g_swapname, "r");
+        if (F) {
+            fclose(F);
+            if (0 != remove(g_swapname)) {
+                log_error("could not remove %s: %s", g_swapname,
+                        strerror(errno));
+                errno = 0;
+            }
+        }
+    }
+}
+
 int db_driver_open(database_t db, const char *dbname)
 {
     ERRNO_CHECK();
@@ -254,23 +316,7 @@ void db_driver_close(database_t db)
 {
     ERRNO_CHECK();
     if (db == DB_SWAP) {
-        assert(g_swap_db);
-        SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_select_string));
-        SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_insert_string));
-        SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_select_order));
-        SQLITE_CHECK(g_swap_db, sqlite3_finalize(g_stmt_insert_order));
-        SQLITE_CHECK(g_swap_db, sqlite3_close(g_swap_db));
-        if (g_swapname) {
-            FILE * F = fopen(g_swapname, "r");
-            if (F) {
-                fclose(F);
-                if (0 != remove(g_swapname)) {
-                    log_error("could not remove %s: %s", g_swapname,
-                            strerror(errno));
-                    errno = 0;
-                }
-            }
-        }
+        db_close_swap();
     }
     else if (db == DB_GAME) {
         assert(g_game_db);
@@ -286,6 +332,9 @@ dbrow_id db_driver_string_save(const char *str) {
     int rc;
 
     assert(str);
+    if (g_swap_arena) {
+        return arena_save(&g_swap, str);
+    }
 
     ERRNO_CHECK();
 
@@ -314,6 +363,9 @@ dbrow_id db_driver_string_save(const char *str) {
 const char *db_driver_string_load(dbrow_id id, size_t *size) {
     int err;
 
+    if (g_swap_arena) {
+        return arena_load(&g_swap, id, size);
+    }
     end_transaction();
     err = sqlite3_reset(g_stmt_select_string);
     assert(err == SQLITE_OK);
@@ -33,6 +33,7 @@
 /* util includes */
 #include <util/base36.h>
 #include <util/lists.h>
+#include <util/macros.h>
 #include <util/goodies.h>
 #include <util/lists.h>
 #include <util/language.h>
@@ -160,8 +161,8 @@ void set_show_item(faction * f, const struct item_type *itype)
 const char *factionname(const faction * f)
 {
     typedef char name[OBJECTIDSIZE + 1];
-    static name idbuf[8];
-    static int nextbuf = 0;
+    static THREAD_LOCAL name idbuf[8];
+    static THREAD_LOCAL int nextbuf = 0;
 
     char *ibuf = idbuf[(++nextbuf) % 8];
 
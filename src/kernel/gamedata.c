@@ -10,6 +10,8 @@
 #include <memstream.h>
 #include <binarystore.h>
 
+#include <stb_ds.h>
+
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,10 +19,13 @@
 
 void gamedata_done(gamedata *data) {
     binstore_done(data->store);
+    arrfree(data->offsets);
 }
 
 void gamedata_init(gamedata *data, storage *store, int version) {
     data->version = version;
+    data->file = NULL;
+    data->offsets = NULL;
     data->store = store;
     binstore_init(data->store, &data->strm);
 }
@@ -5,6 +5,8 @@
 
 #include <stream.h>
 
+#include <stdio.h>
+
 #define UIDHASH_VERSION 332     /* 2008-05-22 = 572 borders use the region.uid to store */
 #define REGIONOWNER_VERSION 333 /* 2009-05-14 regions have owners and morale */
 #define ALLIANCELEADER_VERSION 333      /* alliances have a leader */
@@ -57,8 +59,9 @@
 #define FIX_SHADOWS_VERSION 379 /* shadowdemon/-master skills, bug 3011 */
 #define FIX_SHAPESHIFT_IRACE_VERSION 380 /* shapeshift spell, bug 2991 */
 #define SKILL_DAYS_VERSION 381 /* skills are stored as days, not weeks */
+#define REGION_INDEX_VERSION 382 /* the file ends with the offsets of all regions */
 
-#define RELEASE_VERSION SKILL_DAYS_VERSION /* use for new datafiles */
+#define RELEASE_VERSION REGION_INDEX_VERSION /* use for new datafiles */
 #define MIN_VERSION UIDHASH_VERSION      /* minimal datafile we support */
 #define MAX_VERSION RELEASE_VERSION /* change this if we can need to read the future datafile, and we can do so */
 
@@ -70,6 +73,8 @@ typedef struct gamedata {
     struct storage *store;
     stream strm;
     int version;
+    FILE *file; /* the file behind strm, if the region offsets are wanted */
+    long long *offsets; /* stb_ds array, where each region starts in file */
 } gamedata;
 
 void gamedata_init(gamedata *data, struct storage *store, int version);
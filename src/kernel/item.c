@@ -29,6 +29,7 @@
 #include <util/message.h>
 #include <util/rng.h>
 #include <util/umlaut.h>
+#include <util/workers.h>
 
 #include <critbit.h>
 #include <storage.h>
@@ -37,6 +38,7 @@
 /* libc includes */
 #include <assert.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -99,7 +101,7 @@ static int golem_factor(const unit *u, const resource_type *rtype) {
     return 0;
 }
 
-static int res_changeitem(unit * u, const resource_type * rtype, int delta)
+int res_changeitem(unit * u, const resource_type * rtype, int delta)
 {
     int num;
     int gf = (delta > 0) ? 0 : golem_factor(u, rtype);
@@ -141,7 +143,7 @@ const char *resourcename(const resource_type * rtype, int flags)
             }
         }
         if (flags & NMF_PLURAL) {
-            static char name[64]; /* FIXME: static return value */
+            static THREAD_LOCAL char name[64]; /* FIXME: static return value */
             size_t len = strlen(rtype->_name);
             assert(len <= sizeof(name) - 3);
             memcpy(name, rtype->_name, len);
@@ -383,9 +385,31 @@ int i_get(const item * i, const item_type * it)
     return 0;
 }
 
+/* counts the items that were added to a list, see items_changed.
+ * Item types share ITEM_SLOTS counters, a type that shares its counter
+ * with a busy one is only checked again more often. */
+#define ITEM_SLOTS 64
+static THREAD_LOCAL int i_added[ITEM_SLOTS];
+
+static int *item_slot(const item_type *itype)
+{
+    return i_added + ((uintptr_t)itype / sizeof(void *)) % ITEM_SLOTS;
+}
+
+bool items_changed(const item_type *itype, int *cache_key)
+{
+    int *added = item_slot(itype);
+    if (*cache_key != *added) {
+        *cache_key = *added;
+        return true;
+    }
+    return false;
+}
+
 item *i_add(item ** pi, item * i)
 {
     assert(i && i->type && !i->next);
+    ++*item_slot(i->type);
     while (*pi) {
         int d = strcmp((*pi)->type->rtype->_name, i->type->rtype->_name);
         if (d >= 0)
@@ -406,6 +430,10 @@ item *i_add(item ** pi, item * i)
 
 void i_merge(item ** pi, item ** si)
 {
+    const item *itm;
+    for (itm = *si; itm; itm = itm->next) {
+        ++*item_slot(itm->type);
+    }
     if (*pi == NULL) {
         *pi = *si;
     }
@@ -498,7 +526,8 @@ void item_done(void) {
 
 void i_free(item * i)
 {
-    if (icache_size >= ICACHE_MAX) {
+    /* the free-list is not shared with worker threads */
+    if (icache_size >= ICACHE_MAX || workers_active()) {
         free(i);
     }
     else {
@@ -522,7 +551,9 @@ void i_freeall(item ** i)
 item *i_new(const item_type * itype, int size)
 {
     item *i;
-    if (icache_size > 0) {
+    assert(itype);
+    ++*item_slot(itype);
+    if (icache_size > 0 && !workers_active()) {
         i = icache;
         icache = i->next;
         --icache_size;
@@ -531,7 +562,6 @@ item *i_new(const item_type * itype, int size)
         i = malloc(sizeof(item));
         if (!i) abort();
     }
-    assert(itype);
     i->next = NULL;
     i->type = itype;
     i->number = size;
@@ -195,6 +195,9 @@ extern "C" {
     void i_free(item * i);
     void i_freeall(item ** i);
     item *i_new(const item_type * it, int number);
+    /* true if items of itype may have been added to any list since the
+     * cache_key was set */
+    bool items_changed(const item_type *itype, int *cache_key);
 
     void read_items(struct storage *store, struct item **it);
     void write_items(struct storage *store, struct item *it);
@@ -202,6 +205,7 @@ extern "C" {
     /* convenience: */
     void item_add(item* itm, int delta);
     item *i_change(item ** items, const item_type * it, int delta);
+    int res_changeitem(struct unit * u, const resource_type * rtype, int delta);
     int i_get(const item * items, const item_type * it);
 
     /* creation */
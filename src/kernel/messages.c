@@ -21,6 +21,9 @@
 #include <util/nrmessage.h>
 #include <util/crmessage.h>
 #include <util/log.h>
+#include <util/workers.h>
+
+#include <stb_ds.h>
 
 /* libc includes */
 #include <stddef.h>
@@ -214,6 +217,116 @@ message *msg_message(const char *name, const char *sig, ...)
     return msg_create(mtype, args);
 }
 
+/* Find the type of a handle and the parameter slot for each name in its
+ * signature. The type and slots are published with a release store of
+ * the cache_key, so a reader that sees the new key also sees them. Names
+ * that the type does not have get slot -1, and take no argument, like
+ * they do in msg_message. */
+static const message_type *mt_handle_type(mt_handle *mh)
+{
+    int key = mt_version();
+
+    if (WORKERS_LOAD_ACQUIRE(&mh->cache_key) != key) {
+        workers_lock();
+        if (mh->cache_key != key) {
+            const message_type *mtype = mt_find(mh->name);
+            int nargs = 0, argnum = 0;
+
+            if (mtype) {
+                const char *ic = mh->sig;
+                while (*ic && !isalnum(*ic))
+                    ic++;
+                while (*ic) {
+                    char paramname[64];
+                    char *oc = paramname;
+                    int i;
+
+                    while (isalnum(*ic))
+                        *oc++ = *ic++;
+                    *oc = '\0';
+
+                    for (i = 0; i != mtype->nparameters; ++i) {
+                        if (!strcmp(paramname, mtype->pnames[i]))
+                            break;
+                    }
+                    if (i != mtype->nparameters) {
+                        argnum++;
+                    }
+                    else {
+                        log_error("invalid parameter %s for message type %s\n", paramname, mtype->name);
+                        i = -1;
+                    }
+                    assert(nargs < MT_MAXSLOTS);
+                    mh->slots[nargs++] = (signed char)i;
+                    while (*ic && !isalnum(*ic))
+                        ic++;
+                }
+                if (argnum != mtype->nparameters) {
+                    log_error("not enough parameters for message type %s\n", mtype->name);
+                }
+            }
+            mh->mtype = mtype;
+            mh->nargs = nargs;
+            WORKERS_STORE_RELEASE(&mh->cache_key, key);
+        }
+        workers_unlock();
+    }
+    return mh->mtype;
+}
+
+message *msg_handle(mt_handle *mh, ...)
+/* static mt_handle mh_oops = MT_HANDLE("oops_error", "unit region command");
+ * msg_handle(&mh_oops, u, r, cmd) */
+{
+    va_list vargs;
+    const message_type *mtype = mt_handle_type(mh);
+    variant args[MT_MAXSLOTS];
+    int i;
+
+    if (!mtype) {
+        return missing_message(mh->name);
+    }
+    memset(args, 0, sizeof(args));
+    va_start(vargs, mh);
+    for (i = 0; i != mh->nargs; ++i) {
+        int slot = mh->slots[i];
+        if (slot < 0) {
+            continue;
+        }
+        if (mtype->types[slot]->vtype == VAR_VOIDPTR) {
+            args[slot].v = va_arg(vargs, void *);
+        }
+        else if (mtype->types[slot]->vtype == VAR_INT) {
+            args[slot].i = va_arg(vargs, int);
+        }
+        else {
+            assert(!"unknown variant type");
+        }
+    }
+    va_end(vargs);
+    return msg_create(mtype, args);
+}
+
+/* like msg_handle, with the arguments in an array, in signature order */
+message *msg_handle_args(mt_handle *mh, const variant args[])
+{
+    const message_type *mtype = mt_handle_type(mh);
+    variant params[MT_MAXSLOTS];
+    int i;
+
+    if (!mtype) {
+        return missing_message(mh->name);
+    }
+    memset(params, 0, sizeof(params));
+    for (i = 0; i != mh->nargs; ++i) {
+        int slot = mh->slots[i];
+        if (slot >= 0) {
+            params[slot] = args[i];
+        }
+    }
+    return msg_create(mtype, params);
+}
+
 static void
 caddmessage(region * r, faction * f, const char *s, msg_t mtype, int level)
 {
@@ -253,7 +366,7 @@ void addmessage(struct region * r, struct faction * f, const char *s, enum msg_t
 }
 
 message * msg_error(const unit * u, struct order *ord, int mno) {
-    static char msgname[20];
+    static THREAD_LOCAL char msgname[20];
 
     if (u->faction->flags & FFL_NPC) {
         return NULL;
@@ -286,23 +399,66 @@ void free_messagelist(mlist *msgs)
     struct mlist **mlistptr;
     for (mlistptr = &msgs; *mlistptr;) {
         struct mlist *ml = *mlistptr;
+        /* nodes for arena messages are in the arena, too */
+        bool in_arena = ml->msg->in_arena;
         *mlistptr = ml->next;
         msg_release(ml->msg);
-        free(ml);
+        if (!in_arena) {
+            free(ml);
+        }
+    }
+}
+
+static THREAD_LOCAL message_buffer *deferred;
+
+void msg_defer_begin(message_buffer *buf)
+{
+    assert(!deferred);
+    deferred = buf;
+}
+
+void msg_defer_end(void)
+{
+    deferred = NULL;
+}
+
+void msg_defer_flush(message_buffer *buf)
+{
+    ptrdiff_t i, len = arrlen(buf->items);
+
+    assert(deferred != buf);
+    for (i = 0; i != len; ++i) {
+        msg_deferred *md = buf->items + i;
+        add_message(md->target, md->msg);
+        msg_release(md->msg);
     }
+    arrfree(buf->items);
 }
 
 message *add_message(message_list ** pm, message * m)
 {
-    if (m != NULL) {
-        struct mlist *mnew = malloc(sizeof(struct mlist));
-        if (!mnew) abort();
+    if (m != NULL && deferred) {
+        msg_deferred *md = arraddnptr(deferred->items, 1);
+        md->target = pm;
+        md->msg = msg_addref(m);
+    }
+    else if (m != NULL) {
+        /* recipients of the same news share one message */
+        message *mi = msg_intern(m);
+        struct mlist *mnew;
+        if (mi->in_arena) {
+            mnew = msg_arena_alloc(sizeof(struct mlist));
+        }
+        else {
+            mnew = malloc(sizeof(struct mlist));
+            if (!mnew) abort();
+        }
         if (*pm == NULL) {
             *pm = malloc(sizeof(message_list));
             if (*pm == NULL) abort();
             (*pm)->end = &(*pm)->begin;
         }
-        mnew->msg = msg_addref(m);
+        mnew->msg = msg_addref(mi);
         mnew->next = NULL;
         *((*pm)->end) = mnew;
         (*pm)->end = &mnew->next;
@@ -49,6 +49,26 @@ void message_handle_missing(int mode);
 void free_messagelist(struct mlist *msgs);
 
 struct message *msg_message(const char *name, const char *sig, ...);
+
+/* A precompiled msg_message call site. The type is looked up and the
+ * signature checked against it on first use, and again after message
+ * types were added or cleared. Arguments are then passed in signature
+ * order, without looking at any names. */
+#define MT_MAXSLOTS 16
+
+typedef struct mt_handle {
+    const char *name;
+    const char *sig;
+    const struct message_type *mtype;
+    int cache_key;
+    int nargs;
+    signed char slots[MT_MAXSLOTS];
+} mt_handle;
+
+#define MT_HANDLE(name, sig) { name, sig, NULL, 0, 0, { 0 } }
+
+struct message *msg_handle(mt_handle *mh, ...);
+struct message *msg_handle_args(mt_handle *mh, const variant args[]);
 struct message *msg_feedback(const struct unit *, struct order *cmd,
     const char *name, const char *sig, ...);
 struct message *add_message(struct message_list **pm,
@@ -57,6 +77,22 @@ void addmessage(struct region *r, struct faction *f, const char *s,
     enum msg_t mtype, int level);
 
 struct mlist ** merge_messages(message_list *ml, message_list *append);
+
+/* deferred delivery: while a buffer is active on the calling thread,
+ * add_message() records (list, message) pairs in it instead of appending
+ * to the list. msg_defer_flush() delivers them in recording order. */
+typedef struct msg_deferred {
+    struct message_list **target;
+    struct message *msg;
+} msg_deferred;
+
+typedef struct message_buffer {
+    struct msg_deferred *items;
+} message_buffer;
+
+void msg_defer_begin(struct message_buffer *buf);
+void msg_defer_end(void);
+void msg_defer_flush(struct message_buffer *buf);
 void split_messages(message_list *ml, struct mlist **split);
 
 #define ADDMSG(msgs, mcreate) { struct message * mx = mcreate; if (mx) { add_message(msgs, mx); msg_release(mx); } }
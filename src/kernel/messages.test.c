@@ -3,16 +3,19 @@
 #include "unit.h"
 #include "faction.h"
 #include "order.h"
+#include "region.h"
 
 #include "util/message.h"
 #include "util/keyword.h"  // for K_ENTERTAIN, K_MOVE
 #include "util/variant.h"  // for variant
+#include "util/workers.h"
 
 #include <CuTest.h>
 #include <tests.h>
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 void test_missing_message(CuTest *tc) {
     message *msg;
@@ -69,6 +72,153 @@ void test_message(CuTest *tc) {
     test_teardown();
 }
 
+static void test_msg_handle(CuTest *tc) {
+    static mt_handle mh = MT_HANDLE("custom", "region number");
+    message *msg;
+    message_type *mtype;
+    region *r;
+    variant args[2];
+
+    test_setup();
+    r = test_create_plain(0, 0);
+    mtype = mt_create_va(mt_new("custom", NULL), "number:int", "region:region", MT_NEW_END);
+    msg = msg_handle(&mh, r, 42);
+    CuAssertPtrEquals(tc, mtype, (void *)msg->type);
+    CuAssertPtrEquals(tc, mtype, (void *)mh.mtype);
+    CuAssertIntEquals(tc, 42, msg->parameters[0].i);
+    CuAssertPtrEquals(tc, r, msg->parameters[1].v);
+    msg_release(msg);
+
+    args[0].v = r;
+    args[1].i = 7;
+    msg = msg_handle_args(&mh, args);
+    CuAssertIntEquals(tc, 7, msg->parameters[0].i);
+    CuAssertPtrEquals(tc, r, msg->parameters[1].v);
+    msg_release(msg);
+
+    /* the handle notices when the catalogue changes */
+    mt_clear();
+    msg = msg_handle(&mh, r, 42);
+    CuAssertStrEquals(tc, "missing_message", msg->type->name);
+    CuAssertPtrEquals(tc, NULL, (void *)mh.mtype);
+    msg_release(msg);
+    test_teardown();
+}
+
+typedef struct handle_job {
+    region *r;
+    const message_type *types[64];
+    int numbers[64];
+} handle_job;
+
+static void create_handle_messages(int index, void *udata)
+{
+    static mt_handle mh = MT_HANDLE("custom", "region number");
+    handle_job *job = (handle_job *)udata;
+    message *msg = msg_handle(&mh, job->r, index);
+    job->types[index] = msg->type;
+    job->numbers[index] = msg->parameters[0].i;
+    msg_release(msg);
+}
+
+static void test_msg_handle_parallel(CuTest *tc) {
+    handle_job job;
+    message_type *mtype;
+    int i;
+
+    test_setup();
+    memset(&job, 0, sizeof(job));
+    job.r = test_create_plain(0, 0);
+    mtype = mt_create_va(mt_new("custom", NULL), "number:int", "region:region", MT_NEW_END);
+    /* every worker finds the handle stale, only one resolves it */
+    workers_set_count(4);
+    workers_run(64, create_handle_messages, &job);
+    workers_set_count(1);
+    for (i = 0; i != 64; ++i) {
+        CuAssertPtrEquals(tc, mtype, (void *)job.types[i]);
+        CuAssertIntEquals(tc, i, job.numbers[i]);
+    }
+    test_teardown();
+}
+
+static void test_message_arena(CuTest *tc) {
+    message *msg, *heap;
+    message_list *msgs = NULL;
+    variant args[2];
+
+    test_setup();
+    mt_create_va(mt_new("custom", NULL), "name:string", "number:int", MT_NEW_END);
+    msg_arena_open();
+    msg = msg_message("custom", "name number", "Hodor", 42);
+    CuAssertTrue(tc, msg->in_arena);
+    CuAssertPtrEquals(tc, msg + 1, msg->parameters);
+    CuAssertStrEquals(tc, "Hodor", (const char *)msg->parameters[0].v);
+    CuAssertIntEquals(tc, 42, msg->parameters[1].i);
+    add_message(&msgs, msg);
+    msg_release(msg);
+
+    args[0].v = "Hodor";
+    args[1].i = 7;
+    heap = msg_create_heap(mt_find("custom"), args);
+    CuAssertTrue(tc, !heap->in_arena);
+    add_message(&msgs, heap);
+    CuAssertPtrEquals(tc, heap, msgs->begin->next->msg);
+    free_messagelist(msgs->begin);
+    free(msgs);
+    msg_arena_close();
+
+    /* the heap message outlives the arena */
+    CuAssertIntEquals(tc, 7, heap->parameters[1].i);
+    msg_release(heap);
+    msg = msg_message("custom", "name number", "Hodor", 42);
+    CuAssertTrue(tc, !msg->in_arena);
+    msg_release(msg);
+    test_teardown();
+}
+
+typedef struct defer_job {
+    message_buffer buffers[2];
+    message_list *lists[2];
+} defer_job;
+
+static void create_deferred_messages(int index, void *udata)
+{
+    defer_job *job = (defer_job *)udata;
+    message *msg;
+
+    msg_defer_begin(job->buffers + index);
+    msg = msg_message("custom", "name number", "Hodor", 42);
+    add_message(job->lists + index, msg);
+    msg_release(msg);
+    msg_defer_end();
+}
+
+static void test_defer_intern_parallel(CuTest *tc) {
+    defer_job job;
+    message *msg;
+    int i;
+
+    test_setup();
+    memset(&job, 0, sizeof(job));
+    mt_create_va(mt_new("custom", NULL), "name:string", "number:int", MT_NEW_END);
+    msg_arena_open();
+    workers_set_count(2);
+    workers_run(2, create_deferred_messages, &job);
+    workers_set_count(1);
+    msg_defer_flush(job.buffers);
+    msg_defer_flush(job.buffers + 1);
+    /* equal messages from different workers are shared */
+    msg = job.lists[0]->begin->msg;
+    CuAssertPtrEquals(tc, msg, job.lists[1]->begin->msg);
+    CuAssertTrue(tc, msg->shared);
+    for (i = 0; i != 2; ++i) {
+        free_messagelist(job.lists[i]->begin);
+        free(job.lists[i]);
+    }
+    msg_arena_close();
+    test_teardown();
+}
+
 static void test_merge_split(CuTest *tc) {
     message_list *mlist = NULL, *append = NULL;
     struct mlist **split; /* TODO: why is this a double asterisk? */
@@ -100,6 +250,44 @@ static void test_merge_split(CuTest *tc) {
     test_teardown();
 }
 
+static void test_defer_messages(CuTest *tc) {
+    message_list *first = NULL, *second = NULL;
+    message_buffer buf = { 0 };
+    message_type *mtype;
+    message *m1, *m2, *m3;
+
+    test_setup();
+    mtype = mt_create(mt_new("custom", NULL), NULL, 0);
+    m1 = msg_message(mtype->name, "");
+    m2 = msg_message(mtype->name, "");
+    m3 = msg_message(mtype->name, "");
+    msg_defer_begin(&buf);
+    add_message(&first, m1);
+    add_message(&second, m2);
+    add_message(&first, m3);
+    msg_defer_end();
+    CuAssertPtrEquals(tc, NULL, first);
+    CuAssertPtrEquals(tc, NULL, second);
+    CuAssertIntEquals(tc, 2, m1->refcount);
+
+    msg_defer_flush(&buf);
+    CuAssertPtrEquals(tc, NULL, buf.items);
+    CuAssertPtrNotNull(tc, first);
+    CuAssertPtrNotNull(tc, second);
+    CuAssertPtrEquals(tc, m1, first->begin->msg);
+    CuAssertPtrEquals(tc, m3, first->begin->next->msg);
+    CuAssertPtrEquals(tc, m2, second->begin->msg);
+    CuAssertIntEquals(tc, 2, m1->refcount);
+    msg_release(m1);
+    msg_release(m2);
+    msg_release(m3);
+    free_messagelist(first->begin);
+    free(first);
+    free_messagelist(second->begin);
+    free(second);
+    test_teardown();
+}
+
 static void test_noerror(CuTest *tc) {
     unit *u;
     struct locale *lang;
@@ -123,7 +311,12 @@ CuSuite *get_messages_suite(void) {
     SUITE_ADD_TEST(suite, test_missing_message);
     SUITE_ADD_TEST(suite, test_missing_feedback);
     SUITE_ADD_TEST(suite, test_merge_split);
+    SUITE_ADD_TEST(suite, test_defer_messages);
+    SUITE_ADD_TEST(suite, test_defer_intern_parallel);
     SUITE_ADD_TEST(suite, test_message);
+    SUITE_ADD_TEST(suite, test_msg_handle);
+    SUITE_ADD_TEST(suite, test_msg_handle_parallel);
+    SUITE_ADD_TEST(suite, test_message_arena);
     SUITE_ADD_TEST(suite, test_noerror);
     return suite;
 }
@@ -12,9 +12,12 @@
 #include "util/keyword.h"
 #include <util/language.h>
 #include <util/log.h>
+#include <util/macros.h>
 #include <util/param.h>
 #include <util/parser.h>
+#include <util/workers.h>
 
+#include <stb_ds.h>
 #include <stream.h>
 #include <strings.h>
 
@@ -32,7 +35,11 @@
 order_data *odata_load(int id)
 {
     if (id > 0) {
-        return db_driver_order_load(id);
+        order_data *od;
+        workers_lock();
+        od = db_driver_order_load(id);
+        workers_unlock();
+        return od;
     }
     return NULL;
 }
@@ -40,7 +47,11 @@ order_data *odata_load(int id)
 int odata_save(order_data *od)
 {
     if (od->_str) {
-        return db_driver_order_save(od->_str);
+        int id;
+        workers_lock();
+        id = db_driver_order_save(od->_str);
+        workers_unlock();
+        return id;
     }
     return 0;
 }
@@ -76,21 +87,31 @@ void odata_addref(order_data *od)
     ++od->_refcount;
 }
 
+/* Identical order texts share an id in the swap arena, so an order is
+ * found by its address. orig may also be a copy, like u->thisorder, and
+ * then the first order with its id and command is replaced. */
 void replace_order(order ** dlist, order * orig, const order * src)
 {
+    order **dp, *dst;
+
     assert(src);
     assert(orig);
     assert(dlist);
-    while (*dlist != NULL) {
-        order *dst = *dlist;
-        if (dst->id == orig->id) {
-            order *cpy = copy_order(src);
-            *dlist = cpy;
-            cpy->next = dst->next;
-            dst->next = 0;
-            free_order(dst);
+    for (dp = dlist; *dp != NULL && *dp != orig; dp = &(*dp)->next);
+    if (*dp == NULL) {
+        for (dp = dlist; *dp != NULL; dp = &(*dp)->next) {
+            if ((*dp)->id == orig->id && (*dp)->command == orig->command) {
+                break;
+            }
         }
-        dlist = &(*dlist)->next;
+    }
+    dst = *dp;
+    if (dst != NULL) {
+        order *cpy = copy_order(src);
+        *dp = cpy;
+        cpy->next = dst->next;
+        dst->next = 0;
+        free_order(dst);
     }
 }
 
@@ -253,10 +274,51 @@ void free_orders(order ** olist)
     }
 }
 
+/* Order texts are split into tokens once, when the order is created,
+ * and init_order gives the parser the tokens instead of the text.
+ * The token lists are indexed by order data id. They only live for one
+ * turn: turn_end frees them, and orders without tokens are parsed from
+ * their text again, so memory stays bounded by one turn's orders. */
+static token_list **order_tokens;
+
+static void cache_tokens(int id, const char *str)
+{
+    workers_lock();
+    while (arrlen(order_tokens) <= id) {
+        arrput(order_tokens, NULL);
+    }
+    if (!order_tokens[id]) {
+        order_tokens[id] = tokenize(str);
+    }
+    workers_unlock();
+}
+
+static const token_list *find_tokens(int id)
+{
+    const token_list *tokens = NULL;
+    workers_lock();
+    if (id < arrlen(order_tokens)) {
+        tokens = order_tokens[id];
+    }
+    workers_unlock();
+    return tokens;
+}
+
+void free_order_tokens(void)
+{
+    ptrdiff_t i, len = arrlen(order_tokens);
+    assert(!workers_active());
+    for (i = 0; i != len; ++i) {
+        free(order_tokens[i]);
+    }
+    arrfree(order_tokens);
+}
+
 static int create_data(keyword_t kwd, const char *s,
     const struct locale *lang)
 {
     order_data data = { NULL, 0 };
+    int id;
 
     assert(kwd != NOKEYWORD);
 
@@ -271,7 +333,11 @@ static int create_data(keyword_t kwd, const char *s,
         }
     }
     data._str = s;
-    return odata_save(&data);
+    id = odata_save(&data);
+    if (id > 0) {
+        cache_tokens(id, s);
+    }
+    return id;
 }
 
 static void create_order_i(order *ord, keyword_t kwd, const char *sptr, bool persistent,
@@ -574,7 +640,7 @@ void push_order(order ** ordp, order * ord)
     *ordp = ord;
 }
 
-static order_data *parser_od;
+static THREAD_LOCAL order_data *parser_od;
 
 keyword_t init_order(const struct order *ord, const struct locale *lang)
 {
@@ -614,6 +680,11 @@ keyword_t init_order(const struct order *ord, const struct locale *lang)
         }
         else {
             const char *str;
+            const token_list *tokens = find_tokens(ord->id);
+            if (tokens) {
+                init_tokens_list(tokens);
+                return kwd;
+            }
             parser_od = odata_load(ord->id);
             if (parser_od) {
                 odata_addref(parser_od);
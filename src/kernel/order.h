@@ -18,8 +18,8 @@ extern "C" {
      * This structure contains one order given by a unit. These used to be
      * stored in string lists, but by storing them in order-structures,
      * it is possible to use reference-counting on them, reduce string copies,
-     * and reduce overall memory usage by sharing strings between orders (not
-     * implemented yet) saving approx. 50% of all string-related memory.
+     * and reduce overall memory usage by sharing strings between orders
+     * (the arena swap driver stores every distinct order text only once).
      */
 
 #define CMD_QUIET   0x010000
@@ -37,6 +37,7 @@ extern "C" {
     void odata_create(order_data **pdata, size_t len, const char *str);
     void odata_release(order_data * od);
     void odata_addref(order_data *od);
+    void free_order_tokens(void);
 
     typedef struct order {
         struct order *next;
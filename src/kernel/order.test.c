@@ -40,6 +40,35 @@ static void test_create_order(CuTest *tc) {
     test_teardown();
 }
 
+static void test_init_order_tokens(CuTest *tc) {
+    char cmd[32];
+    order *ord;
+    struct locale * lang;
+
+    test_setup();
+    lang = test_create_locale();
+
+    ord = create_order(K_GIVE, lang, "abc 'x y' 5");
+    CuAssertStrEquals(tc, "give abc 'x y' 5", get_command(ord, lang, cmd, sizeof(cmd)));
+    CuAssertIntEquals(tc, K_GIVE, init_order(ord, NULL));
+    CuAssertIntEquals(tc, 13368, getid());
+    CuAssertStrEquals(tc, "x y", getstrtoken());
+    CuAssertIntEquals(tc, 5, getint());
+    CuAssertTrue(tc, parser_end());
+    CuAssertIntEquals(tc, K_GIVE, init_order(ord, NULL));
+    CuAssertStrEquals(tc, "abc", getstrtoken());
+
+    /* without cached tokens, the order is parsed from its text */
+    free_order_tokens();
+    CuAssertIntEquals(tc, K_GIVE, init_order(ord, NULL));
+    CuAssertIntEquals(tc, 13368, getid());
+    CuAssertStrEquals(tc, "x y", getstrtoken());
+    CuAssertIntEquals(tc, 5, getint());
+    CuAssertTrue(tc, parser_end());
+    free_order(ord);
+    test_teardown();
+}
+
 static void test_parse_order(CuTest *tc) {
     char cmd[32];
     order *ord;
@@ -308,6 +337,33 @@ static void test_replace_order(CuTest *tc) {
     test_teardown();
 }
 
+/* identical orders may share their text, but only one is replaced */
+static void test_replace_order_identical(CuTest *tc) {
+    order *orders = NULL, *ord, *copy, *repl;
+    struct locale * lang;
+
+    test_setup();
+    lang = test_create_locale();
+    orders = create_order(K_MAKE, lang, "Schwert");
+    orders->next = ord = create_order(K_MAKE, lang, "Schwert");
+    CuAssertIntEquals(tc, orders->id, ord->id);
+    repl = create_order(K_ALLY, lang, NULL);
+    replace_order(&orders, ord, repl);
+    CuAssertIntEquals(tc, K_MAKE, getkeyword(orders));
+    CuAssertIntEquals(tc, K_ALLY, getkeyword(orders->next));
+    CuAssertPtrEquals(tc, NULL, orders->next->next);
+
+    /* a copy of an order replaces the first one like it */
+    copy = copy_order(orders);
+    replace_order(&orders, copy, repl);
+    CuAssertIntEquals(tc, K_ALLY, getkeyword(orders));
+    CuAssertIntEquals(tc, K_ALLY, getkeyword(orders->next));
+    free_order(copy);
+    free_orders(&orders);
+    free_order(repl);
+    test_teardown();
+}
+
 static void test_get_command(CuTest *tc) {
     struct locale * lang;
     order *ord;
@@ -643,6 +699,7 @@ CuSuite *get_order_suite(void)
     SUITE_ADD_TEST(suite, test_study_order_unknown_quoted);
     SUITE_ADD_TEST(suite, test_study_order_quoted);
     SUITE_ADD_TEST(suite, test_parse_order);
+    SUITE_ADD_TEST(suite, test_init_order_tokens);
     SUITE_ADD_TEST(suite, test_parse_parameters);
     SUITE_ADD_TEST(suite, test_parse_make);
     SUITE_ADD_TEST(suite, test_parse_autostudy);
@@ -651,6 +708,7 @@ CuSuite *get_order_suite(void)
     SUITE_ADD_TEST(suite, test_parse_maketemp);
     SUITE_ADD_TEST(suite, test_init_order);
     SUITE_ADD_TEST(suite, test_replace_order);
+    SUITE_ADD_TEST(suite, test_replace_order_identical);
     SUITE_ADD_TEST(suite, test_skip_token);
     SUITE_ADD_TEST(suite, test_getstrtoken);
     SUITE_ADD_TEST(suite, test_get_command);
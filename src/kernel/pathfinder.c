@@ -5,8 +5,13 @@
 #include "region.h"
 #include "terrain.h"
 
+#include <util/macros.h>
+
+#include <stb_ds.h>
+
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #define MAXDEPTH 1024
@@ -25,164 +30,286 @@ bool allowed_fly(const region * src, const region * r)
     return false;
 }
 
-typedef struct node {
-    struct node *next;
-    region *r;
-    struct node *prev;
-    int distance;
-} node;
+static void visit_init(pathfinder *pf)
+{
+    ptrdiff_t size = arrlen(pf->visits);
+    if (++pf->stamp == 0) {
+        /* the stamps wrapped around, forget all old searches */
+        memset(pf->visits, 0, sizeof(path_visit) * size);
+        pf->stamp = 1;
+    }
+    arrsetlen(pf->nodes, 0);
+    arrsetlen(pf->open, 0);
+}
 
-static node *node_garbage;
+static path_visit *visit_get(pathfinder *pf, const region *r)
+{
+    ptrdiff_t size = arrlen(pf->visits);
+    if ((ptrdiff_t)r->index >= size) {
+        ptrdiff_t len = r->index + 1024;
+        arrsetlen(pf->visits, len);
+        memset(pf->visits + size, 0, sizeof(path_visit) * (len - size));
+    }
+    return pf->visits + r->index;
+}
 
-void pathfinder_cleanup(void)
+static int node_add(pathfinder *pf, region *r, int prev, int distance, int cost)
+{
+    path_node node;
+    path_visit *visit = visit_get(pf, r);
+
+    node.r = r;
+    node.prev = prev;
+    node.distance = distance;
+    node.cost = cost;
+    node.closed = false;
+    arrput(pf->nodes, node);
+    visit->stamp = pf->stamp;
+    visit->node = (int)arrlen(pf->nodes) - 1;
+    return visit->node;
+}
+
+/* the node for r in the current search, or -1 */
+static int node_find(pathfinder *pf, const region *r)
 {
-    while (node_garbage) {
-        node *n = node_garbage;
-        node_garbage = n->next;
-        free(n);
+    const path_visit *visit = visit_get(pf, r);
+    return (visit->stamp == pf->stamp) ? visit->node : -1;
+}
+
+/* the heap of open nodes is ordered by cost, then by age */
+static bool heap_less(const pathfinder *pf, int a, int b)
+{
+    int ca = pf->nodes[a].cost, cb = pf->nodes[b].cost;
+    return ca < cb || (ca == cb && a < b);
+}
+
+static void heap_push(pathfinder *pf, int k)
+{
+    ptrdiff_t i = arrlen(pf->open);
+    arrput(pf->open, k);
+    while (i > 0) {
+        ptrdiff_t parent = (i - 1) / 2;
+        if (!heap_less(pf, pf->open[i], pf->open[parent])) {
+            break;
+        }
+        pf->open[i] = pf->open[parent];
+        pf->open[parent] = k;
+        i = parent;
     }
 }
 
-static node *new_node(region * r, int distance, node * prev)
+static int heap_pop(pathfinder *pf)
 {
-    node *n;
-    if (node_garbage != NULL) {
-        n = node_garbage;
-        node_garbage = n->next;
+    int result = pf->open[0];
+    ptrdiff_t i = 0, len = arrlen(pf->open) - 1;
+    pf->open[0] = pf->open[len];
+    arrsetlen(pf->open, len);
+    for (;;) {
+        ptrdiff_t c = 2 * i + 1;
+        int k;
+        if (c >= len) {
+            break;
+        }
+        if (c + 1 < len && heap_less(pf, pf->open[c + 1], pf->open[c])) {
+            ++c;
+        }
+        if (!heap_less(pf, pf->open[c], pf->open[i])) {
+            break;
+        }
+        k = pf->open[i];
+        pf->open[i] = pf->open[c];
+        pf->open[c] = k;
+        i = c;
     }
-    else {
-        n = malloc(sizeof(node));
-        if (!n) abort();
+    return result;
+}
+
+/* breadth-first search, returns the node of the target or -1 */
+static int search_bfs(pathfinder *pf, region *start, const region *target,
+    int maxlen, bool(*allowed) (const region *, const region *))
+{
+    int k;
+
+    node_add(pf, start, -1, 0, 0);
+    for (k = 0; k != arrlen(pf->nodes); ++k) {
+        region *r = pf->nodes[k].r;
+        int depth = pf->nodes[k].distance + 1;
+        int d;
+        if (depth > maxlen)
+            break;
+        for (d = 0; d != MAXDIRECTIONS; ++d) {
+            region *rn = rconnect(r, d);
+            if (rn && node_find(pf, rn) < 0 && allowed(r, rn)) {
+                int n = node_add(pf, rn, k, depth, depth);
+                if (rn == target) {
+                    return n;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/* A* search with the distance to the target as the estimate. That
+ * distance never overestimates the steps needed, so the path is as
+ * short as the one from search_bfs. Regions on another plane have a
+ * distance of INT_MAX, there is no path to or through them. */
+static int search_astar(pathfinder *pf, region *start, const region *target,
+    int maxlen, bool(*allowed) (const region *, const region *))
+{
+    int dist = distance(start, target);
+
+    if (dist == INT_MAX) {
+        return -1;
+    }
+    heap_push(pf, node_add(pf, start, -1, 0, dist));
+    while (arrlen(pf->open) > 0) {
+        int k = heap_pop(pf);
+        region *r = pf->nodes[k].r;
+        int depth = pf->nodes[k].distance + 1;
+        int d;
+
+        if (pf->nodes[k].closed || node_find(pf, r) != k) {
+            continue; /* we found a shorter way here */
+        }
+        if (r == target) {
+            return k;
+        }
+        pf->nodes[k].closed = true;
+        if (depth > maxlen)
+            continue;
+        for (d = 0; d != MAXDIRECTIONS; ++d) {
+            region *rn = rconnect(r, d);
+            if (rn) {
+                int n = node_find(pf, rn);
+                if (n >= 0 && (pf->nodes[n].closed || pf->nodes[n].distance <= depth)) {
+                    continue;
+                }
+                dist = distance(rn, target);
+                if (dist != INT_MAX && allowed(r, rn)) {
+                    heap_push(pf, node_add(pf, rn, k, depth, depth + dist));
+                }
+            }
+        }
     }
-    n->next = NULL;
-    n->prev = prev;
-    n->r = r;
-    n->distance = distance;
-    return n;
+    return -1;
+}
+
+void pathfinder_init(pathfinder *pf, bool astar)
+{
+    memset(pf, 0, sizeof(pathfinder));
+    pf->astar = astar;
 }
 
-static node *free_node(node * n)
+void pathfinder_done(pathfinder *pf)
 {
-    node *s = n->next;
-    n->next = node_garbage;
-    node_garbage = n;
-    return s;
+    arrfree(pf->visits);
+    arrfree(pf->nodes);
+    arrfree(pf->open);
 }
 
-static void free_nodes(node * root)
+int pathfinder_find(pathfinder *pf, region *start, const region *target,
+    int maxlen, bool(*allowed) (const region *, const region *),
+    region **path, size_t size)
 {
-    while (root != NULL) {
-        region *r = root->r;
-        freset(r, RF_MARK);
-        root = free_node(root);
+    int k, len;
+
+    if (start == target) {
+        k = -1;
+        len = 0;
     }
+    else {
+        visit_init(pf);
+        k = pf->astar ? search_astar(pf, start, target, maxlen, allowed)
+            : search_bfs(pf, start, target, maxlen, allowed);
+        if (k < 0) {
+            return -1;
+        }
+        len = pf->nodes[k].distance;
+    }
+    if (path) {
+        int i = len;
+        assert(size > (size_t)len + 1);
+        path[i + 1] = NULL;
+        if (k < 0) {
+            path[0] = start;
+        }
+        for (; k >= 0; k = pf->nodes[k].prev) {
+            path[i--] = pf->nodes[k].r;
+        }
+    }
+    return len;
 }
 
-struct selist *path_regions_in_range(struct region *handle_start, int maxdist,
-    bool(*allowed) (const struct region *, const struct region *))
+struct selist *pathfinder_in_range(pathfinder *pf, region *start, int maxdist,
+    bool(*allowed) (const region *, const region *))
 {
-    selist * rlist = NULL;
-    node *root = new_node(handle_start, 0, NULL);
-    node **handle_end = &root->next;
-    node *n = root;
+    selist *rlist = NULL;
+    int k;
 
-    while (n != NULL) {
-        region *r = n->r;
-        int depth = n->distance + 1;
+    visit_init(pf);
+    node_add(pf, start, -1, 0, 0);
+    /* the start is not marked, it is in the result if we can return to it */
+    visit_get(pf, start)->stamp = 0;
+    for (k = 0; k != arrlen(pf->nodes); ++k) {
+        region *r = pf->nodes[k].r;
+        int depth = pf->nodes[k].distance + 1;
         int d;
 
-        if (n->distance >= maxdist)
+        if (depth > maxdist)
             break;
         for (d = 0; d != MAXDIRECTIONS; ++d) {
             region *rn = rconnect(r, d);
             if (rn == NULL)
                 continue;
-            if (fval(rn, RF_MARK))
+            if (node_find(pf, rn) >= 0)
                 continue;               /* already been there */
             if (allowed && !allowed(r, rn))
                 continue;               /* can't go there */
 
             /* add the region to the list of available ones. */
             selist_push(&rlist, rn);
-
-            /* make sure we don't go here again, and put the region into the set for
-               further BFS'ing */
-            fset(rn, RF_MARK);
-            *handle_end = new_node(rn, depth, n);
-            handle_end = &(*handle_end)->next;
+            node_add(pf, rn, k, depth, depth);
         }
-        n = n->next;
     }
-    free_nodes(root);
-
     return rlist;
 }
 
-static region **internal_path_find(region * handle_start, const region * target,
-    int maxlen, bool(*allowed) (const region *, const region *))
+/* the old interface shares one search context per thread, worker
+ * threads free theirs with pathfinder_cleanup (see kernel_init) */
+static THREAD_LOCAL pathfinder default_pf;
+
+void pathfinder_cleanup(void)
 {
-    static region *path[MAXDEPTH + 2];    /* STATIC_RETURN: used for return, not across calls */
-    direction_t d = MAXDIRECTIONS;
-    node *root = new_node(handle_start, 0, NULL);
-    node **handle_end = &root->next;
-    node *n = root;
-    assert(maxlen <= MAXDEPTH);
-    fset(handle_start, RF_MARK);
+    pathfinder_done(&default_pf);
+}
 
-    while (n != NULL) {
-        region *r = n->r;
-        int depth = n->distance + 1;
-        if (n->distance >= maxlen)
-            break;
-        for (d = 0; d != MAXDIRECTIONS; ++d) {
-            region *rn = rconnect(r, d);
-            if (rn && !fval(rn, RF_MARK) && allowed(r, rn)) {
-                if (rn == target) {
-                    int i = depth;
-                    path[i + 1] = NULL;
-                    path[i] = rn;
-                    while (n) {
-                        path[--i] = n->r;
-                        n = n->prev;
-                    }
-                    break;
-                }
-                else {
-                    fset(rn, RF_MARK);
-                    *handle_end = new_node(rn, depth, n);
-                    handle_end = &(*handle_end)->next;
-                }
-            }
-        }
-        if (d != MAXDIRECTIONS) {
-            break;
-        }
-        n = n->next;
-    }
-    free_nodes(root);
-    if (d != MAXDIRECTIONS) {
-        return path;
-    }
-    return NULL;
+struct selist *path_regions_in_range(struct region *handle_start, int maxdist,
+    bool(*allowed) (const struct region *, const struct region *))
+{
+    default_pf.astar = false;
+    return pathfinder_in_range(&default_pf, handle_start, maxdist, allowed);
 }
 
 bool
 path_exists(region * handle_start, const region * target, int maxlen,
 bool(*allowed) (const region *, const region *))
 {
-    assert((!fval(handle_start, RF_MARK) && !fval(target, RF_MARK))
-        || !"Some Algorithm did not clear its RF_MARKs!");
-    if (handle_start == target)
-        return true;
-    if (internal_path_find(handle_start, target, maxlen, allowed) != NULL)
-        return true;
-    return false;
+    default_pf.astar = true;
+    return pathfinder_find(&default_pf, handle_start, target, maxlen, allowed, NULL, 0) >= 0;
 }
 
 region **path_find(region * handle_start, const region * target, int maxlen,
     bool(*allowed) (const region *, const region *))
 {
-    assert((!fval(handle_start, RF_MARK) && !fval(target, RF_MARK))
-        || !"Did you call path_init()?");
-    return internal_path_find(handle_start, target, maxlen, allowed);
+    static THREAD_LOCAL region *path[MAXDEPTH + 2];    /* STATIC_RETURN: used for return, not across calls */
+    assert(maxlen <= MAXDEPTH);
+    if (handle_start == target) {
+        return NULL;
+    }
+    default_pf.astar = false;
+    if (pathfinder_find(&default_pf, handle_start, target, maxlen, allowed, path, MAXDEPTH + 2) < 0) {
+        return NULL;
+    }
+    return path;
 }
@@ -2,7 +2,47 @@
 #ifndef H_KRNL_PATHFINDER
 #define H_KRNL_PATHFINDER
 
+#include <stdbool.h>
+#include <stddef.h>
+
 struct region;
+struct selist;
+
+/* A search context. Searches that use different contexts can run at the
+ * same time. Visited regions are marked with a stamp in an array that is
+ * indexed by region.index, and the memory is kept for the next search. */
+typedef struct path_visit {
+    unsigned int stamp;
+    int node;
+} path_visit;
+
+typedef struct path_node {
+    struct region *r;
+    int prev;
+    int distance;
+    int cost;
+    bool closed;
+} path_node;
+
+typedef struct pathfinder {
+    path_visit *visits;
+    path_node *nodes;
+    int *open;
+    unsigned int stamp;
+    bool astar;
+} pathfinder;
+
+void pathfinder_init(pathfinder *pf, bool astar);
+void pathfinder_done(pathfinder *pf);
+/* returns the length of the path, or -1. If path is not NULL, it gets
+ * the regions from start to target, followed by NULL. */
+int pathfinder_find(pathfinder *pf, struct region *start,
+    const struct region *target, int maxlen,
+    bool(*allowed) (const struct region *, const struct region *),
+    struct region **path, size_t size);
+struct selist *pathfinder_in_range(pathfinder *pf, struct region *start,
+    int maxdist, bool(*allowed) (const struct region *, const struct region *));
+
 
 struct region **path_find(struct region *handle_start,
     const struct region *target, int maxlen,
@@ -0,0 +1,126 @@
+#include "pathfinder.h"
+
+#include "plane.h"
+#include "region.h"
+
+#include <selist.h>
+
+#include <tests.h>
+#include <CuTest.h>
+
+#include <limits.h>
+#include <stddef.h>
+
+/* a 5x5 field of plains, with a wall of ocean at x=2 that is open at y=4 */
+static void create_field(void)
+{
+    int x, y;
+    for (y = 0; y != 5; ++y) {
+        for (x = 0; x != 5; ++x) {
+            if (x == 2 && y != 4) {
+                test_create_ocean(x, y);
+            }
+            else {
+                test_create_plain(x, y);
+            }
+        }
+    }
+}
+
+static void test_path_find(CuTest *tc) {
+    region *r1, *r2, **path;
+
+    test_setup();
+    r1 = test_create_plain(0, 0);
+    test_create_plain(1, 0);
+    r2 = test_create_plain(2, 0);
+    path = path_find(r1, r2, 2, allowed_walk);
+    CuAssertPtrNotNull(tc, path);
+    CuAssertPtrEquals(tc, r1, path[0]);
+    CuAssertPtrEquals(tc, findregion(1, 0), path[1]);
+    CuAssertPtrEquals(tc, r2, path[2]);
+    CuAssertPtrEquals(tc, NULL, path[3]);
+    CuAssertPtrEquals(tc, NULL, path_find(r1, r2, 1, allowed_walk));
+    CuAssertTrue(tc, path_exists(r1, r2, 2, allowed_walk));
+    CuAssertTrue(tc, !path_exists(r1, r2, 1, allowed_walk));
+    CuAssertTrue(tc, path_exists(r1, r1, 0, allowed_walk));
+    pathfinder_cleanup();
+    test_teardown();
+}
+
+static void test_pathfinder_astar(CuTest *tc) {
+    pathfinder bfs, astar;
+    region *r1, *r2, *path[32];
+    int i, len;
+
+    test_setup();
+    create_field();
+    r1 = findregion(0, 0);
+    r2 = findregion(4, 0);
+    pathfinder_init(&bfs, false);
+    pathfinder_init(&astar, true);
+    len = pathfinder_find(&bfs, r1, r2, 16, allowed_walk, NULL, 0);
+    CuAssertTrue(tc, len > 4);
+    CuAssertIntEquals(tc, len, pathfinder_find(&astar, r1, r2, 16, allowed_walk, path, 32));
+    CuAssertPtrEquals(tc, r1, path[0]);
+    CuAssertPtrEquals(tc, r2, path[len]);
+    CuAssertPtrEquals(tc, NULL, path[len + 1]);
+    for (i = 0; i != len; ++i) {
+        CuAssertIntEquals(tc, 1, distance(path[i], path[i + 1]));
+        CuAssertTrue(tc, allowed_walk(path[i], path[i + 1]));
+    }
+    CuAssertIntEquals(tc, -1, pathfinder_find(&astar, r1, r2, len - 1, allowed_walk, NULL, 0));
+    /* flying crosses the ocean */
+    CuAssertIntEquals(tc, 4, pathfinder_find(&astar, r1, r2, 16, allowed_fly, NULL, 0));
+    CuAssertIntEquals(tc, 4, pathfinder_find(&bfs, r1, r2, 16, allowed_fly, NULL, 0));
+    pathfinder_done(&bfs);
+    pathfinder_done(&astar);
+    test_teardown();
+}
+
+static void test_pathfinder_planes(CuTest *tc) {
+    pathfinder astar;
+    region *r1, *r2, *r3;
+
+    test_setup();
+    r1 = test_create_plain(0, 0);
+    r2 = test_create_plain(1, 0);
+    r3 = test_create_plain(2, 0);
+    create_new_plane(1, "Astralraum", 2, 4, 0, 0, 0);
+    CuAssertIntEquals(tc, INT_MAX, distance(r1, r3));
+    pathfinder_init(&astar, true);
+    CuAssertIntEquals(tc, -1, pathfinder_find(&astar, r1, r3, 16, allowed_fly, NULL, 0));
+    CuAssertIntEquals(tc, -1, pathfinder_find(&astar, r3, r1, 16, allowed_fly, NULL, 0));
+    CuAssertIntEquals(tc, 1, pathfinder_find(&astar, r1, r2, 16, allowed_fly, NULL, 0));
+    CuAssertIntEquals(tc, 1, pathfinder_find(&astar, r2, r1, 16, allowed_fly, NULL, 0));
+    pathfinder_done(&astar);
+    test_teardown();
+}
+
+static void test_path_regions_in_range(CuTest *tc) {
+    pathfinder pf;
+    selist *rlist;
+
+    test_setup();
+    create_field();
+    rlist = path_regions_in_range(findregion(1, 0), 1, allowed_walk);
+    CuAssertIntEquals(tc, 3, selist_length(rlist));
+    selist_free(rlist);
+    pathfinder_init(&pf, false);
+    rlist = pathfinder_in_range(&pf, findregion(1, 0), 1, allowed_fly);
+    CuAssertIntEquals(tc, 4, selist_length(rlist));
+    selist_free(rlist);
+    pathfinder_done(&pf);
+    pathfinder_cleanup();
+    test_teardown();
+}
+
+CuSuite *get_pathfinder_suite(void)
+{
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_path_find);
+    SUITE_ADD_TEST(suite, test_pathfinder_astar);
+    SUITE_ADD_TEST(suite, test_pathfinder_planes);
+    SUITE_ADD_TEST(suite, test_path_regions_in_range);
+    return suite;
+}
@@ -11,9 +11,14 @@
 
 #include <util/parser.h>
 #include <util/log.h>
+#include <util/macros.h>
+#include <util/workers.h>
+
+#include <stb_ds.h>
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define TODO_POOL
 #undef TODO_RESOURCES
@@ -133,6 +138,116 @@ int set_resvalue(unit * u, const item_type * itype, int value)
     return res->value;
 }
 
+/* The pool remembers, for each region and item, the units that have the
+ * item in their inventory, in the order of the region's units, so the
+ * pooled functions only look at units that can contribute. An entry is
+ * built again when items of its type were added to any list
+ * (items_changed), or units entered, left or were sorted in its region
+ * (units_changed). Units that have used up their items stay in the list
+ * until then. */
+typedef struct pool_key {
+    const struct region *r;
+    const struct item_type *itype;
+} pool_key;
+
+typedef struct pool_entry {
+    pool_key key;
+    int items_key;
+    int units_key;
+    unit **donors;
+} pool_entry;
+
+static THREAD_LOCAL pool_entry *pool_ledger;
+
+static void pool_ledger_free(void)
+{
+    ptrdiff_t i, len = hmlen(pool_ledger);
+    for (i = 0; i != len; ++i) {
+        arrfree(pool_ledger[i].donors);
+    }
+    hmfree(pool_ledger);
+}
+
+/* each worker thread builds its own ledger, and frees it when it exits */
+void pool_init(void)
+{
+    workers_atexit(pool_ledger_free);
+}
+
+void pool_done(void)
+{
+    pool_ledger_free();
+}
+
+static bool has_item(const unit *u, const item_type *itype)
+{
+    const item *itm;
+    if (u_race(u)->ec_flags & (ECF_STONEGOLEM | ECF_IRONGOLEM)) {
+        /* golems are made of stone or iron */
+        return true;
+    }
+    for (itm = u->items; itm; itm = itm->next) {
+        if (itm->type == itype) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* the units in r that may have some of rtype, or NULL if rtype is not
+ * an item that lives in the inventory */
+static unit **pool_donors(const region *r, const resource_type *rtype)
+{
+    pool_key key;
+    pool_entry *entry;
+    ptrdiff_t i;
+    bool stale = false;
+
+    if (!rtype->itype || (rtype->uchange && rtype->uchange != res_changeitem)) {
+        return NULL;
+    }
+    memset(&key, 0, sizeof(key));
+    key.r = r;
+    key.itype = rtype->itype;
+    i = pool_ledger ? hmgeti(pool_ledger, key) : -1;
+    if (i < 0) {
+        pool_entry create;
+        memset(&create, 0, sizeof(create));
+        create.key = key;
+        hmputs(pool_ledger, create);
+        i = hmgeti(pool_ledger, key);
+        stale = true;
+    }
+    entry = pool_ledger + i;
+    stale = items_changed(key.itype, &entry->items_key) || stale;
+    stale = units_changed(r, &entry->units_key) || stale;
+    if (stale) {
+        unit *u;
+        arrsetlen(entry->donors, 0);
+        for (u = r->units; u; u = u->next) {
+            if (has_item(u, key.itype)) {
+                arrput(entry->donors, u);
+            }
+        }
+    }
+    return entry->donors;
+}
+
+/* which parts of what v has can be used by u, or 0 if none */
+static int pool_mask(const unit *u, const unit *v, const faction *f, int mode)
+{
+    if (u == v) {
+        return 0;
+    }
+    if (v->faction == f) {
+        return (mode >> 3) & (GET_SLACK | GET_RESERVE);
+    }
+    if (alliedunit(v, f, HELP_MONEY)) {
+        return (mode >> 6) & (GET_SLACK | GET_RESERVE);
+    }
+    return 0;
+}
+
 int
 get_pooled(const unit * u, const resource_type * rtype, int mode,
 int count)
@@ -159,19 +274,24 @@ int count)
             use = slack;
     }
     if (rtype->flags & RTF_POOLED && mode & ~(GET_SLACK | GET_RESERVE)) {
-        for (v = r->units; v && use < count; v = v->next)
-            if (u != v) {
-                int mask;
-
-                if (v->faction == f) {
-                    mask = (mode >> 3) & (GET_SLACK | GET_RESERVE);
+        unit **donors = pool_donors(r, rtype);
+        if (donors) {
+            ptrdiff_t i, len = arrlen(donors);
+            for (i = 0; i != len && use < count; ++i) {
+                int mask = pool_mask(u, v = donors[i], f, mode);
+                if (mask) {
+                    use += get_pooled(v, rtype, mask, count - use);
                 }
-                else if (alliedunit(v, f, HELP_MONEY))
-                    mask = (mode >> 6) & (GET_SLACK | GET_RESERVE);
-                else
-                    continue;
-                use += get_pooled(v, rtype, mask, count - use);
             }
+        }
+        else {
+            for (v = r->units; v && use < count; v = v->next) {
+                int mask = pool_mask(u, v, f, mode);
+                if (mask) {
+                    use += get_pooled(v, rtype, mask, count - use);
+                }
+            }
+        }
     }
     return use;
 }
@@ -212,17 +332,22 @@ use_pooled(unit * u, const resource_type * rtype, int mode, int count)
     }
 
     if (rtype->flags & RTF_POOLED && mode & ~(GET_SLACK | GET_RESERVE)) {
-        for (v = r->units; use > 0 && v != NULL; v = v->next) {
-            if (u != v) {
-                int mask;
-                if (v->faction == f) {
-                    mask = (mode >> 3) & (GET_SLACK | GET_RESERVE);
+        unit **donors = pool_donors(r, rtype);
+        if (donors) {
+            ptrdiff_t i, len = arrlen(donors);
+            for (i = 0; i != len && use > 0; ++i) {
+                int mask = pool_mask(u, v = donors[i], f, mode);
+                if (mask) {
+                    use -= use_pooled(v, rtype, mask, use);
+                }
+            }
+        }
+        else {
+            for (v = r->units; use > 0 && v != NULL; v = v->next) {
+                int mask = pool_mask(u, v, f, mode);
+                if (mask) {
+                    use -= use_pooled(v, rtype, mask, use);
                 }
-                else if (alliedunit(v, f, HELP_MONEY))
-                    mask = (mode >> 6) & (GET_SLACK | GET_RESERVE);
-                else
-                    continue;
-                use -= use_pooled(v, rtype, mask, use);
             }
         }
     }
@@ -43,6 +43,9 @@ extern "C" {
 
     int set_resvalue(struct unit * u, const struct item_type * rtype, int value);
 
+    void pool_init(void);
+    void pool_done(void);
+
 #ifdef __cplusplus
 }
 #endif
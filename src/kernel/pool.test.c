@@ -112,6 +112,38 @@ void test_pool(CuTest *tc) {
     test_teardown();
 }
 
+static void test_pool_donors(CuTest *tc) {
+    unit *u1, *u2, *u3;
+    faction *f;
+    region *r;
+    struct resource_type *rtype;
+
+    test_setup();
+    rtype = rt_get_or_create("money");
+    rtype->flags |= RTF_POOLED;
+    it_get_or_create(rtype);
+    f = test_create_faction();
+    r = test_create_plain(0, 0);
+    u1 = test_create_unit(f, r);
+    u2 = test_create_unit(f, r);
+    u3 = test_create_unit(f, r);
+    i_change(&u2->items, rtype->itype, 100);
+    CuAssertIntEquals(tc, 100, get_pooled(u1, rtype, GET_DEFAULT, INT_MAX));
+    /* units that get new items are found */
+    i_change(&u3->items, rtype->itype, 50);
+    CuAssertIntEquals(tc, 150, get_pooled(u1, rtype, GET_DEFAULT, INT_MAX));
+    /* units that leave are not */
+    move_unit(u2, test_create_plain(1, 0), NULL);
+    CuAssertIntEquals(tc, 50, get_pooled(u1, rtype, GET_DEFAULT, INT_MAX));
+    /* units are used in the order of the region */
+    move_unit(u2, r, NULL);
+    CuAssertIntEquals(tc, 60, use_pooled(u1, rtype, GET_DEFAULT, 60));
+    CuAssertIntEquals(tc, 0, i_get(u3->items, rtype->itype));
+    CuAssertIntEquals(tc, 90, i_get(u2->items, rtype->itype));
+    CuAssertIntEquals(tc, 90, get_pooled(u1, rtype, GET_DEFAULT, INT_MAX));
+    test_teardown();
+}
+
 void test_pool_bug_2042(CuTest *tc) {
     unit *u1, *u2;
     faction *f;
@@ -215,6 +247,7 @@ CuSuite *get_pool_suite(void)
     SUITE_ADD_TEST(suite, test_pool_get_item);
     SUITE_ADD_TEST(suite, test_pool_bug_2042);
     SUITE_ADD_TEST(suite, test_pool_use);
+    SUITE_ADD_TEST(suite, test_pool_donors);
     SUITE_ADD_TEST(suite, test_change_resource);
     return suite;
 }
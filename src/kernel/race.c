@@ -26,6 +26,7 @@
 #include <util/umlaut.h>
 #include <util/language.h>
 #include <util/log.h>
+#include <util/macros.h>
 #include <util/rng.h>
 #include <util/variant.h>
 
@@ -509,7 +510,7 @@ const char* rc_name(const race * rc, name_t n, char *name, size_t size)
 
 const char *rc_name_s(const race * rc, name_t n)
 {
-    static char name[64];  /* FIXME: static return value */
+    static THREAD_LOCAL char name[64];  /* FIXME: static return value */
     return rc_name(rc, n, name, sizeof(name));
 }
 
@@ -525,7 +526,7 @@ const char *racename(const struct locale *loc, const unit * u, const race * rc)
     const char *str, *prefix = raceprefix(u);
 
     if (prefix != NULL) {
-        static char lbuf[80]; /* FIXME: static return value */
+        static THREAD_LOCAL char lbuf[80]; /* FIXME: static return value */
         sbstring sbs;
         char ch[2];
 
@@ -4,6 +4,7 @@
 #include "alliance.h"
 #include "building.h"
 #include "calendar.h"
+#include "callbacks.h"
 #include "config.h"
 #include "connection.h"
 #include "curse.h"
@@ -29,6 +30,7 @@
 
 #include <util/lists.h>
 #include <util/log.h>
+#include <util/macros.h>
 #include <util/resolve.h>
 #include <util/umlaut.h>
 #include <util/language.h>
@@ -116,8 +118,8 @@ const char *write_regionname(const region * r, const faction * f, char *buffer,
 
 const char *regionname(const region * r, const faction * f)
 {
-    static int index = 0;
-    static char buf[2][NAMESIZE];
+    static THREAD_LOCAL int index = 0;
+    static THREAD_LOCAL char buf[2][NAMESIZE];
     index = 1 - index;
     return write_regionname(r, f, buf[index], sizeof(buf[index]));
 }
@@ -200,66 +202,156 @@ attrib_type at_moveblock = {
     "moveblock", a_initmoveblock, NULL, NULL, a_writemoveblock, a_readmoveblock
 };
 
-#define coor_hashkey(x, y) (unsigned int)((x<<16) + y)
-#define RMAXHASH MAXREGIONS
-static region *regionhash[RMAXHASH];
-static int dummy_data;
-static region *dummy_ptr = (region *)& dummy_data;     /* a funny hack */
+/* Regions are found by their coordinates in square tiles of
+ * TILE_SIZE x TILE_SIZE regions, so that neighbours are close together
+ * in memory. The tiles are in an open hash table that grows with the
+ * world. Tiles are only freed with all the regions, which keeps the
+ * table free of tombstones, and lookups safe while reports are written
+ * in parallel. */
+#define TILE_BITS 4
+#define TILE_SIZE (1 << TILE_BITS)
+#define TILE_MASK (TILE_SIZE - 1)
+#define tile_coor(c) ((c) >> TILE_BITS)
+#define tile_slot(x, y) ((((y) & TILE_MASK) << TILE_BITS) | ((x) & TILE_MASK))
+
+typedef struct region_tile {
+    int tx, ty;
+    region *regions[TILE_SIZE * TILE_SIZE];
+} region_tile;
+
+static region_tile **tiles;
+static unsigned int tiles_size; /* a power of two */
+static unsigned int tiles_count;
+
+static unsigned int tile_hash(int tx, int ty)
+{
+    return ((unsigned int)tx * 0x9e3779b1u) ^ ((unsigned int)ty * 0x85ebca77u);
+}
+
+static region_tile **tile_bucket(region_tile **table, unsigned int size, int tx, int ty)
+{
+    unsigned int key = tile_hash(tx, ty) & (size - 1);
+    while (table[key] && (table[key]->tx != tx || table[key]->ty != ty)) {
+        key = (key + 1) & (size - 1);
+    }
+    return table + key;
+}
+
+static region_tile *find_tile(int tx, int ty)
+{
+    if (tiles) {
+        return *tile_bucket(tiles, tiles_size, tx, ty);
+    }
+    return NULL;
+}
+
+static region_tile *get_tile(int tx, int ty)
+{
+    region_tile **bucket;
+    if ((tiles_count + 1) * 2 > tiles_size) {
+        unsigned int i, size = tiles_size ? tiles_size * 2 : 64;
+        region_tile **table = calloc(size, sizeof(region_tile *));
+        if (!table) abort();
+        for (i = 0; i != tiles_size; ++i) {
+            region_tile *tile = tiles[i];
+            if (tile) {
+                *tile_bucket(table, size, tile->tx, tile->ty) = tile;
+            }
+        }
+        free(tiles);
+        tiles = table;
+        tiles_size = size;
+    }
+    bucket = tile_bucket(tiles, tiles_size, tx, ty);
+    if (!*bucket) {
+        region_tile *tile = calloc(1, sizeof(region_tile));
+        if (!tile) abort();
+        tile->tx = tx;
+        tile->ty = ty;
+        *bucket = tile;
+        ++tiles_count;
+    }
+    return *bucket;
+}
+
+static void free_tiles(void)
+{
+    unsigned int i;
+    for (i = 0; i != tiles_size; ++i) {
+        free(tiles[i]);
+    }
+    free(tiles);
+    tiles = NULL;
+    tiles_size = tiles_count = 0;
+}
 
 typedef struct uidhashentry {
     int uid;
     region *r;
 } uidhashentry;
-static uidhashentry uidhash[MAXREGIONS];
 
-struct region *findregionbyid(int uid)
+/* the uids of deleted regions stay in the table, so they are not reused */
+static uidhashentry *uidhash;
+static unsigned int uidhash_size; /* a power of two */
+static unsigned int uidhash_count;
+
+static uidhashentry *uid_bucket(uidhashentry *table, unsigned int size, int uid)
 {
-    int key = uid % MAXREGIONS;
-    while (uidhash[key].uid != 0 && uidhash[key].uid != uid) {
-        if (++key == MAXREGIONS) key = 0;
+    unsigned int key = (unsigned int)uid & (size - 1);
+    while (table[key].uid != 0 && table[key].uid != uid) {
+        key = (key + 1) & (size - 1);
     }
-    return uidhash[key].r;
+    return table + key;
 }
 
-#define DELMARKER dummy_ptr
+struct region *findregionbyid(int uid)
+{
+    if (uidhash) {
+        return uid_bucket(uidhash, uidhash_size, uid)->r;
+    }
+    return NULL;
+}
 
 static void unhash_uid(region * r)
 {
-    int key = r->uid % MAXREGIONS;
-    assert(r->uid);
-    while (uidhash[key].uid != 0 && uidhash[key].uid != r->uid) {
-        if (++key == MAXREGIONS) key = 0;
-    }
-    assert(uidhash[key].r == r);
-    uidhash[key].r = NULL;
+    uidhashentry *entry;
+    assert(r->uid && uidhash);
+    entry = uid_bucket(uidhash, uidhash_size, r->uid);
+    assert(entry->r == r);
+    entry->r = NULL;
 }
 
 static void rhash_uid(region * r)
 {
     int uid = r->uid;
+    if ((uidhash_count + 1) * 2 > uidhash_size) {
+        unsigned int i, size = uidhash_size ? uidhash_size * 2 : 1024;
+        uidhashentry *table = calloc(size, sizeof(uidhashentry));
+        if (!table) abort();
+        for (i = 0; i != uidhash_size; ++i) {
+            if (uidhash[i].uid != 0) {
+                *uid_bucket(table, size, uidhash[i].uid) = uidhash[i];
+            }
+        }
+        free(uidhash);
+        uidhash = table;
+        uidhash_size = size;
+    }
     for (;;) {
         if (uid != 0) {
-            int key = uid % MAXREGIONS;
-            while (uidhash[key].uid != 0 && uidhash[key].uid != uid) {
-                if (++key == MAXREGIONS) key = 0;
-            }
-            if (uidhash[key].uid == 0) {
-                uidhash[key].uid = uid;
-                uidhash[key].r = r;
+            uidhashentry *entry = uid_bucket(uidhash, uidhash_size, uid);
+            if (entry->uid == 0) {
+                entry->uid = uid;
+                entry->r = r;
+                ++uidhash_count;
                 break;
             }
-            assert(uidhash[key].r != r || !"duplicate registration");
+            assert(entry->r != r || !"duplicate registration");
         }
         r->uid = uid = genrand_int31();
     }
 }
 
-#define HASH_STATISTICS 1
-#if HASH_STATISTICS
-static int hash_requests;
-static int hash_misses;
-#endif
-
 void pnormalize(int *x, int *y, const plane * pl)
 {
     if (pl) {
@@ -280,37 +372,21 @@ void pnormalize(int *x, int *y, const plane * pl)
 
 static region *rfindhash(int x, int y)
 {
-    unsigned int rid = coor_hashkey(x, y);
-    int key = HASH1(rid, RMAXHASH), gk = HASH2(rid, RMAXHASH);
-#if HASH_STATISTICS
-    ++hash_requests;
-#endif
-    while (regionhash[key] != NULL && (regionhash[key] == DELMARKER
-        || regionhash[key]->x != x || regionhash[key]->y != y)) {
-        key = (key + gk) % RMAXHASH;
-#if HASH_STATISTICS
-        ++hash_misses;
-#endif
-    }
-    return regionhash[key];
+    region_tile *tile = find_tile(tile_coor(x), tile_coor(y));
+    return tile ? tile->regions[tile_slot(x, y)] : NULL;
 }
 
 void rhash(region * r)
 {
-    unsigned int rid = coor_hashkey(r->x, r->y);
-    int key = HASH1(rid, RMAXHASH), gk = HASH2(rid, RMAXHASH);
-    while (regionhash[key] != NULL && regionhash[key] != DELMARKER
-        && regionhash[key] != r) {
-        key = (key + gk) % RMAXHASH;
-    }
-    assert(regionhash[key] != r || !"trying to add the same region twice");
-    regionhash[key] = r;
+    region_tile *tile = get_tile(tile_coor(r->x), tile_coor(r->y));
+    region **slot = tile->regions + tile_slot(r->x, r->y);
+    assert(*slot != r || !"trying to add the same region twice");
+    *slot = r;
 }
 
 void runhash(region * r)
 {
-    unsigned int rid = coor_hashkey(r->x, r->y);
-    int key = HASH1(rid, RMAXHASH), gk = HASH2(rid, RMAXHASH);
+    region_tile *tile = find_tile(tile_coor(r->x), tile_coor(r->y));
     int d, di;
     for (d = 0, di = MAXDIRECTIONS / 2; d != MAXDIRECTIONS; ++d, ++di) {
         region *rc = r->connect[d];
@@ -321,11 +397,10 @@ void runhash(region * r)
             r->connect[d] = NULL;
         }
     }
-    while (regionhash[key] != NULL && regionhash[key] != r) {
-        key = (key + gk) % RMAXHASH;
+    assert((tile && tile->regions[tile_slot(r->x, r->y)] == r) || !"trying to remove a region that is not hashed");
+    if (tile) {
+        tile->regions[tile_slot(r->x, r->y)] = NULL;
     }
-    assert(regionhash[key] == r || !"trying to remove a unit that is not hashed");
-    regionhash[key] = DELMARKER;
 }
 
 region *r_connect(const region * r, direction_t dir)
@@ -342,7 +417,7 @@ region *r_connect(const region * r, direction_t dir)
     x = r->x + delta_x[dir];
     y = r->y + delta_y[dir];
     pnormalize(&x, &y, rplane(r));
-    result = rfindhash(x, y);
+    result = findregion(x, y);
     if (result) {
         rmodify->connect[dir] = result;
         result->connect[back[dir]] = rmodify;
@@ -352,7 +427,11 @@ region *r_connect(const region * r, direction_t dir)
 
 region *findregion(int x, int y)
 {
-    return rfindhash(x, y);
+    region *r = rfindhash(x, y);
+    if (!r && callbacks.load_region) {
+        r = callbacks.load_region(x, y);
+    }
+    return r;
 }
 
 /* Contributed by Hubert Mackenberg. Thanks.
@@ -453,6 +532,123 @@ int distance(const region * r1, const region * r2)
     return koor_distance(r1->x, r1->y, r2->x, r2->y);
 }
 
+int regions_in_rect(int minx, int miny, int maxx, int maxy,
+    void (*callback)(struct region *, void *), void *cbdata)
+{
+    int tx, ty, num = 0;
+    for (ty = tile_coor(miny); ty <= tile_coor(maxy); ++ty) {
+        for (tx = tile_coor(minx); tx <= tile_coor(maxx); ++tx) {
+            const region_tile *tile = find_tile(tx, ty);
+            if (tile) {
+                int x, y;
+                int x0 = (tx * TILE_SIZE < minx) ? minx : tx * TILE_SIZE;
+                int y0 = (ty * TILE_SIZE < miny) ? miny : ty * TILE_SIZE;
+                int x1 = (tx * TILE_SIZE + TILE_MASK > maxx) ? maxx : tx * TILE_SIZE + TILE_MASK;
+                int y1 = (ty * TILE_SIZE + TILE_MASK > maxy) ? maxy : ty * TILE_SIZE + TILE_MASK;
+                for (y = y0; y <= y1; ++y) {
+                    for (x = x0; x <= x1; ++x) {
+                        region *r = tile->regions[tile_slot(x, y)];
+                        if (r) {
+                            if (callback) callback(r, cbdata);
+                            ++num;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return num;
+}
+
+typedef struct radius_filter {
+    const region *center;
+    int mindist, maxdist;
+    void (*callback)(struct region *, void *);
+    void *cbdata;
+    int num;
+} radius_filter;
+
+static void cb_radius(region *r, void *cbdata)
+{
+    radius_filter *filter = (radius_filter *)cbdata;
+    const region *rc = filter->center;
+    const plane *pl = rplane(rc);
+    if (rplane(r) == pl) {
+        int dist = pl ? koor_distance_wrap_xy(rc->x, rc->y, r->x, r->y,
+            plane_width(pl), plane_height(pl))
+            : koor_distance_orig(rc->x, rc->y, r->x, r->y);
+        if (dist >= filter->mindist && dist <= filter->maxdist) {
+            if (filter->callback) filter->callback(r, filter->cbdata);
+            ++filter->num;
+        }
+    }
+}
+
+static int regions_in_rect_filtered(int minx, int miny, int maxx, int maxy,
+    const region *rc, int mindist, int maxdist,
+    void (*callback)(struct region *, void *), void *cbdata)
+{
+    radius_filter filter;
+    filter.center = rc;
+    filter.mindist = mindist;
+    filter.maxdist = maxdist;
+    filter.callback = callback;
+    filter.cbdata = cbdata;
+    filter.num = 0;
+    regions_in_rect(minx, miny, maxx, maxy, cb_radius, &filter);
+    return filter.num;
+}
+
+int regions_in_ring(const region *rc, int radius,
+    void (*callback)(struct region *, void *), void *cbdata)
+{
+    const plane *pl = rplane(rc);
+    int d, i, num = 0;
+    int x = rc->x, y = rc->y - radius;
+
+    if (radius == 0) {
+        if (callback) callback((region *)rc, cbdata);
+        return 1;
+    }
+    if (pl && (2 * radius >= plane_width(pl) || 2 * radius >= plane_height(pl))) {
+        /* the ring wraps around onto itself, visit each region once */
+        return regions_in_rect_filtered(pl->minx, pl->miny, pl->maxx, pl->maxy,
+            rc, radius, radius, callback, cbdata);
+    }
+    /* start south-west of the center, and walk around it */
+    for (d = 0; d != MAXDIRECTIONS; ++d) {
+        for (i = 0; i != radius; ++i) {
+            int nx = x, ny = y;
+            region *r;
+            pnormalize(&nx, &ny, pl);
+            r = findregion(nx, ny);
+            if (r && rplane(r) == pl) {
+                if (callback) callback(r, cbdata);
+                ++num;
+            }
+            x += delta_x[d];
+            y += delta_y[d];
+        }
+    }
+    return num;
+}
+
+int regions_in_radius(const region *rc, int radius,
+    void (*callback)(struct region *, void *), void *cbdata)
+{
+    if (rc->_plane || callbacks.load_region) {
+        /* planes wrap around, and regions that are not loaded are
+         * not in the tiles */
+        int k, num = 0;
+        for (k = 0; k <= radius; ++k) {
+            num += regions_in_ring(rc, k, callback, cbdata);
+        }
+        return num;
+    }
+    return regions_in_rect_filtered(rc->x - radius, rc->y - radius,
+        rc->x + radius, rc->y + radius, rc, 0, radius, callback, cbdata);
+}
+
 void free_regionlist(region_list * rl)
 {
     while (rl) {
@@ -794,10 +990,67 @@ int rsettrees(const region * r, int ageclass, int value)
     return r->land->trees[ageclass];
 }
 
+/* Regions and their land are allocated in chunks, in the order they are
+ * created, which is the order of the data file and of the regions list.
+ * Walking the list then reads memory front to back, and the land of
+ * the world is dense, without the oceans in between. */
+#define SLAB_CHUNK 1024
+
+typedef struct slab {
+    size_t size;
+    char **chunks;
+    int used;           /* objects taken from the last chunk */
+    void *freelist;
+} slab;
+
+static slab region_slab = { sizeof(region), NULL, 0, NULL };
+static slab land_slab = { sizeof(land_region), NULL, 0, NULL };
+
+static void *slab_alloc(slab *sl)
+{
+    void *obj;
+    if (sl->freelist) {
+        obj = sl->freelist;
+        sl->freelist = *(void **)obj;
+    }
+    else {
+        if (sl->chunks == NULL || sl->used == SLAB_CHUNK) {
+            char *chunk = malloc(sl->size * SLAB_CHUNK);
+            if (!chunk) abort();
+            arrput(sl->chunks, chunk);
+            sl->used = 0;
+        }
+        obj = arrlast(sl->chunks) + sl->size * sl->used++;
+    }
+    memset(obj, 0, sl->size);
+    return obj;
+}
+
+static void slab_free(slab *sl, void *obj)
+{
+    *(void **)obj = sl->freelist;
+    sl->freelist = obj;
+}
+
+static void slab_clear(slab *sl)
+{
+    ptrdiff_t i, len = arrlen(sl->chunks);
+    for (i = 0; i != len; ++i) {
+        free(sl->chunks[i]);
+    }
+    arrfree(sl->chunks);
+    sl->used = 0;
+    sl->freelist = NULL;
+}
+
+land_region *land_create(void)
+{
+    return (land_region *)slab_alloc(&land_slab);
+}
+
 region *region_create(int uid)
 {
-    region *r = (region *)calloc(1, sizeof(region));
-    assert(r);
+    region *r = (region *)slab_alloc(&region_slab);
     r->uid = uid;
     rhash_uid(r);
     return r;
@@ -858,7 +1111,7 @@ void free_land(land_region * lr)
     arrfree(lr->_demands);
     free(lr->name);
     free(lr->display);
-    free(lr);
+    slab_free(&land_slab, lr);
 }
 
 void region_setresource(region * r, const struct resource_type *rtype, int value)
@@ -975,12 +1228,14 @@ void free_region(region * r)
         free_ship(s);
     }
 
-    free(r);
+    slab_free(&region_slab, r);
 }
 
 void free_regions(void)
 {
-    memset(uidhash, 0, sizeof(uidhash));
+    free(uidhash);
+    uidhash = NULL;
+    uidhash_size = uidhash_count = 0;
     while (deleted_regions) {
         region *r = deleted_regions;
         deleted_regions = r->next;
@@ -992,6 +1247,9 @@ void free_regions(void)
         runhash(r);
         free_region(r);
     }
+    free_tiles();
+    slab_clear(&region_slab);
+    slab_clear(&land_slab);
     max_index = 0;
     last = NULL;
 }
@@ -1242,7 +1500,7 @@ void terraform_region(region * r, const terrain_type * terrain)
     }
     else {
         if (!r->land) {
-            r->land = calloc(1, sizeof(land_region));
+            r->land = land_create();
             create_land(r);
         }
         else {
@@ -11,7 +11,7 @@
 #define TREESIZE 8             /* space used by trees (in #peasants) */
 #define MAXTREES 100000000     /* bug 2360: some players are crazy */
 #define MAXLUXURIES 16         /* there must be no more than MAXLUXURIES kinds of luxury goods in any game */
-#define MAXREGIONS 524287      /* must be prime for hashing. 262139 was a little small */
+#define MAXREGIONS 524287      /* sanity limit for the number of regions in a data file */
 
 #define RF_CHAOTIC     (1<<0) /* persistent */
 #define RF_MALLORN     (1<<1) /* persistent */
@@ -114,9 +114,6 @@ typedef struct region {
     const struct terrain_type *terrain;
     struct rawmaterial *resources;
     struct region *connect[MAXDIRECTIONS];      /* use rconnect(r, dir) to access */
-    struct {
-        seen_mode mode;
-    } seen;
 } region;
 
 typedef struct region_list {
@@ -159,6 +156,20 @@ int koor_distance(int ax, int ay, int bx, int by);
 struct region *findregion(int x, int y);
 struct region *findregionbyid(int uid);
 
+/* Visit all regions in an area, without allocating memory. The callback
+ * must not create or remove regions. All functions return the number of
+ * regions visited; callback may be NULL to only count them. */
+/* regions with minx <= x <= maxx and miny <= y <= maxy, in memory order.
+ * Planes do not wrap, and only regions that are loaded are visited. */
+int regions_in_rect(int minx, int miny, int maxx, int maxy,
+    void (*callback)(struct region *, void *), void *cbdata);
+/* regions at exactly the given distance from r, on the same plane */
+int regions_in_ring(const struct region *r, int radius,
+    void (*callback)(struct region *, void *), void *cbdata);
+/* regions up to the given distance from r, on the same plane */
+int regions_in_radius(const struct region *r, int radius,
+    void (*callback)(struct region *, void *), void *cbdata);
+
 void rhash(struct region *r);
 void runhash(struct region *r);
 
@@ -235,6 +246,7 @@ struct region *r_connect(const struct region *, direction_t dir);
 #define rconnect(r, dir) ((r)->connect[dir]?(r)->connect[dir]:r_connect(r, (direction_t)dir))
 
 void free_regions(void);
+struct land_region *land_create(void);
 void free_land(struct land_region * lr);
 
 int region_get_morale(const region * r);
@@ -10,6 +10,7 @@
 #include "terrain.h"
 #include "terrainid.h"
 #include "item.h"
+#include "plane.h"
 
 
 #include <CuTest.h>
@@ -133,6 +134,106 @@ static void test_mourning(CuTest *tc) {
     test_teardown();
 }
 
+static void test_findregion(CuTest *tc) {
+    region *r;
+    int x, y, uid;
+
+    test_setup();
+    /* enough regions to grow the hash tables a few times */
+    for (y = -50; y != 50; ++y) {
+        for (x = -50; x != 50; ++x) {
+            test_create_region(x, y, NULL);
+        }
+    }
+    r = findregion(-17, 33);
+    CuAssertPtrNotNull(tc, r);
+    CuAssertIntEquals(tc, -17, r->x);
+    CuAssertIntEquals(tc, 33, r->y);
+    CuAssertPtrEquals(tc, r, findregionbyid(r->uid));
+    CuAssertPtrEquals(tc, NULL, findregion(50, 0));
+    uid = r->uid;
+    remove_region(&regions, r);
+    CuAssertPtrEquals(tc, NULL, findregion(-17, 33));
+    CuAssertPtrEquals(tc, NULL, findregionbyid(uid));
+    test_teardown();
+}
+
+static void test_region_storage(CuTest *tc) {
+    region *r1, *r2;
+    land_region *lr;
+    terrain_type *t_plain, *t_ocean;
+
+    test_setup();
+    t_plain = test_create_terrain("plain", LAND_REGION);
+    t_ocean = test_create_terrain("ocean", SEA_REGION);
+    /* regions are next to each other in memory, in the order of the list */
+    r1 = test_create_region(0, 0, t_plain);
+    r2 = test_create_region(1, 0, t_ocean);
+    CuAssertPtrEquals(tc, r1 + 1, r2);
+    CuAssertPtrEquals(tc, r2, r1->next);
+    /* the land of a flooded region is used again */
+    lr = r1->land;
+    terraform_region(r1, t_ocean);
+    CuAssertPtrEquals(tc, NULL, r1->land);
+    terraform_region(r2, t_plain);
+    CuAssertPtrEquals(tc, lr, r2->land);
+    test_teardown();
+}
+
+static void count_region(region *r, void *cbdata) {
+    int *count = (int *)cbdata;
+    ++*count;
+}
+
+static void test_regions_in_radius(CuTest *tc) {
+    region *r;
+    int x, y, count = 0;
+
+    test_setup();
+    for (y = -5; y <= 5; ++y) {
+        for (x = -5; x <= 5; ++x) {
+            test_create_region(x, y, NULL);
+        }
+    }
+    r = findregion(0, 0);
+    CuAssertIntEquals(tc, 1, regions_in_ring(r, 0, NULL, NULL));
+    CuAssertIntEquals(tc, 6, regions_in_ring(r, 1, NULL, NULL));
+    CuAssertIntEquals(tc, 12, regions_in_ring(r, 2, count_region, &count));
+    CuAssertIntEquals(tc, 12, count);
+    CuAssertIntEquals(tc, 37, regions_in_radius(r, 3, NULL, NULL));
+    CuAssertIntEquals(tc, 9, regions_in_rect(-1, -1, 1, 1, NULL, NULL));
+    CuAssertIntEquals(tc, 121, regions_in_rect(-10, -10, 10, 10, NULL, NULL));
+
+    /* holes in the map do not hide the regions behind them */
+    remove_region(&regions, findregion(1, 0));
+    CuAssertIntEquals(tc, 5, regions_in_ring(r, 1, NULL, NULL));
+    CuAssertIntEquals(tc, 36, regions_in_radius(r, 3, NULL, NULL));
+    test_teardown();
+}
+
+static void test_regions_in_radius_plane(CuTest *tc) {
+    region *r;
+    int x, y;
+
+    test_setup();
+    create_new_plane(1, "small", 10, 14, 10, 14, 0);
+    for (y = 10; y <= 14; ++y) {
+        for (x = 10; x <= 14; ++x) {
+            test_create_region(x, y, NULL);
+        }
+    }
+    /* outside of the plane */
+    test_create_region(15, 12, NULL);
+    r = findregion(12, 12);
+    CuAssertPtrNotNull(tc, rplane(r));
+    /* the plane wraps around */
+    CuAssertIntEquals(tc, 6, regions_in_ring(findregion(10, 10), 1, NULL, NULL));
+    CuAssertIntEquals(tc, 7, regions_in_radius(r, 1, NULL, NULL));
+    /* every region of the plane, once */
+    CuAssertIntEquals(tc, 25, regions_in_radius(r, 5, NULL, NULL));
+    test_teardown();
+}
+
 CuSuite *get_region_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
@@ -142,5 +243,9 @@ CuSuite *get_region_suite(void)
     SUITE_ADD_TEST(suite, test_mourning);
     SUITE_ADD_TEST(suite, test_region_getset_resource);
     SUITE_ADD_TEST(suite, test_region_get_owner);
+    SUITE_ADD_TEST(suite, test_findregion);
+    SUITE_ADD_TEST(suite, test_region_storage);
+    SUITE_ADD_TEST(suite, test_regions_in_radius);
+    SUITE_ADD_TEST(suite, test_regions_in_radius_plane);
     return suite;
 }
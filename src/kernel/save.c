@@ -9,6 +9,7 @@
 #include "attrib.h"
 #include "building.h"
 #include "calendar.h"
+#include "callbacks.h"
 #include "config.h"
 #include "connection.h"
 #include "event.h"
@@ -744,7 +745,7 @@ static void read_landregion(gamedata* data, region* r)
 {
     char name[NAMESIZE];
     int n, i;
-    r->land = calloc(1, sizeof(land_region));
+    r->land = land_create();
     READ_STR(data->store, name, sizeof(name));
     if (data->version <= NOWATCH_VERSION) {
         if (utf8_trim(name) != 0) {
@@ -1353,6 +1354,67 @@ void fix_shadows(void)
     }
 }
 
+static long long file_tell(FILE *F)
+{
+#ifdef _MSC_VER
+    return _ftelli64(F);
+#else
+    return (long long)ftello(F);
+#endif
+}
+
+static int file_seek(FILE *F, long long offset, int whence)
+{
+#ifdef _MSC_VER
+    return _fseeki64(F, offset, whence);
+#else
+    return fseeko(F, (off_t)offset, whence);
+#endif
+}
+
+#define REGION_INDEX_MAGIC 0x58444952 /* "RIDX" */
+
+/* the index is appended to the file after the game data:
+ * int count, long long offsets[count], long long start, int magic */
+static void write_region_index(FILE *F, const long long *offsets)
+{
+    long long start = file_tell(F);
+    int n = (int)arrlen(offsets), magic = REGION_INDEX_MAGIC;
+
+    fwrite(&n, sizeof(int), 1, F);
+    if (n > 0) {
+        fwrite(offsets, sizeof(long long), (size_t)n, F);
+    }
+    fwrite(&start, sizeof(start), 1, F);
+    fwrite(&magic, sizeof(int), 1, F);
+}
+
+int read_region_index(FILE *F, long long **offsets)
+{
+    long long start, pos = file_tell(F);
+    int n = -1, magic = 0;
+
+    if (file_seek(F, -(long long)(sizeof(start) + sizeof(magic)), SEEK_END) == 0
+        && fread(&start, sizeof(start), 1, F) == 1
+        && fread(&magic, sizeof(magic), 1, F) == 1
+        && magic == REGION_INDEX_MAGIC
+        && file_seek(F, start, SEEK_SET) == 0
+        && fread(&n, sizeof(int), 1, F) == 1
+        && n >= 0 && n < MAXREGIONS)
+    {
+        arrsetlen(*offsets, n);
+        if (n > 0 && fread(*offsets, sizeof(long long), (size_t)n, F) != (size_t)n) {
+            arrfree(*offsets);
+            n = -1;
+        }
+    }
+    else {
+        n = -1;
+    }
+    file_seek(F, pos, SEEK_SET);
+    return n;
+}
+
 int readgame(const char *filename)
 {
     int n = -2, stream_version;
@@ -1378,6 +1440,8 @@ int readgame(const char *filename)
         assert(gdata.version >= MIN_VERSION || !"unsupported data format");
         assert(gdata.version <= MAX_VERSION || !"unsupported data format");
 
+        /* a full load reads the regions in file order and has no use
+         * for the index, only readgame_lazy seeks with it */
         fstream_init(&strm, F);
         binstore_init(&store, &strm);
         gdata.store = &store;
@@ -1660,83 +1724,93 @@ static void fix_familiars(void (*callback)(unit *)) {
     }
 }
 
-static void read_regions(gamedata *data) {
+/* read one region with its buildings, ships and units, as written by
+ * write_game. Each of these blocks starts at an offset in the region index. */
+region *read_region_block(gamedata *data)
+{
     storage * store = data->store;
     const struct building_type *bt_lighthouse = bt_find("lighthouse");
     const struct race *rc_spell = rc_find("spell");
+    unit **up;
+    building **bp;
+    ship **shp;
     region *r;
-    int nread;
-
-    READ_INT(store, &nread);
-    assert(nread < MAXREGIONS && nread >= 0);
-
-    log_debug(" - Einzulesende Regionen: %d", nread);
-
-    while (--nread >= 0) {
-        unit **up;
-        building **bp;
-        ship **shp;
-        int p;
+    int p;
 
-        r = read_region(data);
+    r = read_region(data);
 
-        /* Burgen */
-        READ_INT(store, &p);
-        if (p > 0 && !r->land) {
-            log_debug("%s, uid=%d has %d %s", regionname(r, NULL), r->uid, p, (p == 1) ? "building" : "buildings");
-        }
-        bp = &r->buildings;
+    /* Burgen */
+    READ_INT(store, &p);
+    if (p > 0 && !r->land) {
+        log_debug("%s, uid=%d has %d %s", regionname(r, NULL), r->uid, p, (p == 1) ? "building" : "buildings");
+    }
+    bp = &r->buildings;
 
-        while (--p >= 0) {
-            building *b = *bp = read_building(data);
-            if (b->type == bt_lighthouse) {
-                r->flags |= RF_LIGHTHOUSE;
-            }
-            b->region = r;
-            bp = &b->next;
+    while (--p >= 0) {
+        building *b = *bp = read_building(data);
+        if (b->type == bt_lighthouse) {
+            r->flags |= RF_LIGHTHOUSE;
         }
-        /* Schiffe */
+        b->region = r;
+        bp = &b->next;
+    }
+    /* Schiffe */
 
-        READ_INT(store, &p);
-        shp = &r->ships;
+    READ_INT(store, &p);
+    shp = &r->ships;
 
-        while (--p >= 0) {
-            ship *sh = *shp = read_ship(data);
-            sh->region = r;
-            shp = &sh->next;
-        }
+    while (--p >= 0) {
+        ship *sh = *shp = read_ship(data);
+        sh->region = r;
+        shp = &sh->next;
+    }
 
-        *shp = NULL;
+    *shp = NULL;
 
-        /* Einheiten */
+    /* Einheiten */
 
-        READ_INT(store, &p);
-        up = &r->units;
+    READ_INT(store, &p);
+    up = &r->units;
 
-        while (--p >= 0) {
-            unit *u = read_unit(data);
+    while (--p >= 0) {
+        unit *u = read_unit(data);
 
-            if (data->version < NORCSPELL_VERSION && u_race(u) == rc_spell) {
-                set_observer(r, u->faction, get_level(u, SK_PERCEPTION), u->age);
-                u_setfaction(u, NULL);
-                free_unit(u);
-            }
-            else {
-                if (data->version < JSON_REPORT_VERSION) {
-                    if (u->_name && fval(u->faction, FFL_NPC)) {
-                        if (!u->_name[0] || unit_name_equals_race(u)) {
-                            unit_setname(u, NULL);
-                        }
+        if (data->version < NORCSPELL_VERSION && u_race(u) == rc_spell) {
+            set_observer(r, u->faction, get_level(u, SK_PERCEPTION), u->age);
+            u_setfaction(u, NULL);
+            free_unit(u);
+        }
+        else {
+            if (data->version < JSON_REPORT_VERSION) {
+                if (u->_name && fval(u->faction, FFL_NPC)) {
+                    if (!u->_name[0] || unit_name_equals_race(u)) {
+                        unit_setname(u, NULL);
                     }
                 }
-                assert(u->region == NULL);
-                u->region = r;
-                *up = u;
-                up = &u->next;
-                update_interval(u->faction, r);
             }
+            assert(u->region == NULL);
+            u->region = r;
+            *up = u;
+            up = &u->next;
+            units_moved(r);
+            update_interval(u->faction, r);
         }
     }
+    return r;
+}
+
+static void read_regions(gamedata *data) {
+    storage * store = data->store;
+    int nread;
+
+    READ_INT(store, &nread);
+    assert(nread < MAXREGIONS && nread >= 0);
+
+    log_debug(" - Einzulesende Regionen: %d", nread);
+
+    while (--nread >= 0) {
+        read_region_block(data);
+    }
 }
 
 static void init_factions(int data_version)
@@ -1806,7 +1880,8 @@ static void read_factions(gamedata * data)
     }
 }
 
-int read_game(gamedata *data)
+/* everything before the regions */
+static void read_game_head(gamedata *data)
 {
     storage * store = data->store;
 
@@ -1838,6 +1913,11 @@ int read_game(gamedata *data)
     read_alliances(data);
 
     read_factions(data);
+}
+
+int read_game(gamedata *data)
+{
+    read_game_head(data);
 
     /* Regionen */
 
@@ -1868,6 +1948,146 @@ int read_game(gamedata *data)
     return 0;
 }
 
+/* The lazy world: regions are read from an indexed data file when
+ * findregion or findunit first asks for them. It is meant for tools that
+ * only look at a part of a big world, and cannot be saved. Connections
+ * between regions (roads, walls) are not loaded. */
+typedef struct lazy_key {
+    int x, y;
+} lazy_key;
+
+static struct lazy_region {
+    lazy_key key;
+    ptrdiff_t value;
+} *lazy_regions;
+
+static struct {
+    gamedata data;
+    storage store;
+    bool *loaded;
+    ptrdiff_t scan; /* findunit has loaded all regions before this one */
+    bool busy;
+} lazy;
+
+static region *lazy_load(ptrdiff_t i)
+{
+    region *r;
+
+    assert(!lazy.loaded[i]);
+    lazy.loaded[i] = true;
+    lazy.busy = true;
+    file_seek(lazy.data.file, lazy.data.offsets[i], SEEK_SET);
+    r = read_region_block(&lazy.data);
+    lazy.busy = false;
+    return r;
+}
+
+static region *lazy_region(int x, int y)
+{
+    lazy_key key;
+    ptrdiff_t i;
+
+    if (lazy.busy) {
+        return NULL;
+    }
+    key.x = x;
+    key.y = y;
+    i = hmgeti(lazy_regions, key);
+    if (i < 0 || lazy.loaded[lazy_regions[i].value]) {
+        return NULL;
+    }
+    return lazy_load(lazy_regions[i].value);
+}
+
+static unit *lazy_unit(int no)
+{
+    ptrdiff_t n = arrlen(lazy.loaded);
+
+    if (lazy.busy) {
+        return NULL;
+    }
+    /* we do not know where the unit is, read regions until we find it */
+    while (lazy.scan < n) {
+        unit *u;
+        ptrdiff_t i = lazy.scan++;
+        if (!lazy.loaded[i]) {
+            lazy_load(i);
+            u = ufindhash(no);
+            if (u) {
+                return u;
+            }
+        }
+    }
+    return NULL;
+}
+
+void readgame_lazy_done(void)
+{
+    if (lazy.data.file) {
+        gamedata_done(&lazy.data);
+        fstream_done(&lazy.data.strm);
+        lazy.data.file = NULL;
+    }
+    hmfree(lazy_regions);
+    arrfree(lazy.loaded);
+    lazy.scan = 0;
+    callbacks.load_region = NULL;
+    callbacks.load_unit = NULL;
+}
+
+int readgame_lazy(const char *filename)
+{
+    int version, stream_version, n = -1;
+    char path[PATH_MAX];
+    long long *offsets = NULL;
+    faction *f;
+    FILE *F;
+    int i;
+
+    readgame_lazy_done();
+    path_join(datapath(), filename, path, sizeof(path));
+    F = fopen(path, "rb");
+    if (!F) {
+        perror(path);
+        return -1;
+    }
+    if (fread(&version, sizeof(int), 1, F) == 1
+        && fread(&stream_version, sizeof(int), 1, F) == 1
+        && stream_version == STREAM_VERSION
+        && version >= REGION_INDEX_VERSION && version <= MAX_VERSION)
+    {
+        n = read_region_index(F, &offsets);
+    }
+    if (n < 0) {
+        fclose(F);
+        log_info("%s has no region index, reading all of it", filename);
+        return readgame(filename);
+    }
+    log_debug("- reading %d regions from %s on demand", n, filename);
+    fstream_init(&lazy.data.strm, F);
+    gamedata_init(&lazy.data, &lazy.store, version);
+    lazy.data.file = F;
+    lazy.data.offsets = offsets;
+    READ_INT(&lazy.store, NULL); /* build */
+    read_game_head(&lazy.data);
+    /* without their units, we cannot tell if factions are alive */
+    for (f = factions; f; f = f->next) {
+        f->_alive = true;
+    }
+
+    for (i = 0; i != n; ++i) {
+        lazy_key key;
+        file_seek(F, offsets[i], SEEK_SET);
+        READ_INT(&lazy.store, &key.x);
+        READ_INT(&lazy.store, &key.y);
+        hmput(lazy_regions, key, i);
+        arrput(lazy.loaded, false);
+    }
+    callbacks.load_region = lazy_region;
+    callbacks.load_unit = lazy_unit;
+    return 0;
+}
+
 static void clear_npc_orders(faction *f)
 {
     if (f) {
@@ -1887,6 +2107,10 @@ int writegame(const char *filename)
     stream strm;
     FILE *F;
 
+    if (lazy.data.file) {
+        log_error("cannot save a world that was not read completely to %s", filename);
+        return -1;
+    }
     create_directories();
     path_join(datapath(), filename, path, sizeof(path));
     /* make sure we don't overwrite an existing file (hard links) */
@@ -1903,6 +2127,8 @@ int writegame(const char *filename)
 
     gdata.store = &store;
     gdata.version = RELEASE_VERSION;
+    gdata.file = F;
+    gdata.offsets = NULL;
     fwrite(&gdata.version, sizeof(int), 1, F);
     n = STREAM_VERSION;
     fwrite(&n, sizeof(int), 1, F);
@@ -1913,6 +2139,8 @@ int writegame(const char *filename)
     WRITE_INT(&store, version_no(eressea_version()));
     n = write_game(&gdata);
     binstore_done(&store);
+    write_region_index(F, gdata.offsets);
+    arrfree(gdata.offsets);
     fstream_done(&strm);
     return n;
 }
@@ -1964,6 +2192,9 @@ int write_game(gamedata *data) {
             log_debug(" - Schreibe Regionen: %d", n);
         }
         WRITE_SECTION(store);
+        if (data->file) {
+            arrput(data->offsets, file_tell(data->file));
+        }
         write_region(data, r);
 
         WRITE_INT(store, listlen(r->buildings));
@@ -2,6 +2,8 @@
 
 #include <stream.h>
 
+#include <stdio.h>
+
 struct attrib;
 struct item;
 struct storage;
@@ -22,6 +24,13 @@ struct gamedata;
 int readgame(const char *filename);
 int writegame(const char *filename);
 
+/* read-only: regions are loaded when findregion or findunit needs them.
+ * Only Lua scripts use it (eressea.read_game_lazy). The gmtool edits and
+ * saves the world, and the map writer walks every region, so both read
+ * the whole file with readgame. */
+int readgame_lazy(const char *filename);
+void readgame_lazy_done(void);
+
 int current_turn(void);
 
 void write_unit(struct gamedata *data, const struct unit *u);
@@ -41,6 +50,10 @@ struct ship *read_ship(struct gamedata *data);
 
 int write_game(struct gamedata *data);
 int read_game(struct gamedata *data);
+struct region *read_region_block(struct gamedata *data);
+
+/* reads the offsets of all regions from the end of a save file */
+int read_region_index(FILE *F, long long **offsets);
 
 /* test-only functions that give access to internal implementation details (BAD) */
 void _test_write_password(struct gamedata *data, const struct faction *f);
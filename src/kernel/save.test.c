@@ -29,6 +29,7 @@
 #include <util/password.h>
 #include <util/path.h>
 
+#include <filestream.h>
 #include <memstream.h>
 #include <storage.h>
 #include <stream.h>
@@ -37,6 +38,8 @@
 #include <CuTest.h>
 #include <tests.h>
 
+#include <stb_ds.h>
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -54,6 +57,88 @@ static void test_readwrite_data(CuTest * tc)
     test_teardown();
 }
 
+static void test_region_index(CuTest * tc)
+{
+    const char *filename = "test.dat";
+    char path[PATH_MAX];
+    long long *offsets = NULL;
+    gamedata data;
+    storage store;
+    region *r;
+    FILE *F;
+    int x, y;
+
+    test_setup();
+    test_create_unit(test_create_faction(), test_create_plain(0, 0));
+    test_create_plain(1, 0);
+    x = regions->next->x;
+    y = regions->next->y;
+    CuAssertIntEquals(tc, 0, writegame(filename));
+    path_join(datapath(), filename, path, sizeof(path));
+
+    F = fopen(path, "rb");
+    CuAssertPtrNotNull(tc, F);
+    CuAssertIntEquals(tc, 2, read_region_index(F, &offsets));
+    CuAssertTrue(tc, offsets[0] > 0);
+    CuAssertTrue(tc, offsets[0] < offsets[1]);
+
+    /* any region can be read from its offset */
+    free_regions();
+    fseek(F, (long)offsets[1], SEEK_SET);
+    fstream_init(&data.strm, F);
+    gamedata_init(&data, &store, RELEASE_VERSION);
+    r = read_region_block(&data);
+    CuAssertPtrNotNull(tc, r);
+    CuAssertIntEquals(tc, x, r->x);
+    CuAssertIntEquals(tc, y, r->y);
+    CuAssertPtrEquals(tc, r, findregion(x, y));
+    gamedata_done(&data);
+    fstream_done(&data.strm);
+    arrfree(offsets);
+
+    CuAssertIntEquals(tc, 0, remove(path));
+    test_teardown();
+}
+
+static void test_readgame_lazy(CuTest * tc)
+{
+    const char *filename = "test.dat";
+    char path[PATH_MAX];
+    faction *f;
+    region *r;
+    unit *u;
+    int fno, uno;
+
+    test_setup();
+    f = test_create_faction();
+    test_create_unit(f, test_create_plain(0, 0));
+    test_create_plain(1, 0);
+    u = test_create_unit(f, test_create_plain(5, 5));
+    fno = f->no;
+    uno = u->no;
+    CuAssertIntEquals(tc, 0, writegame(filename));
+    test_reset();
+
+    CuAssertIntEquals(tc, 0, readgame_lazy(filename));
+    CuAssertPtrNotNull(tc, f = findfaction(fno));
+    CuAssertPtrEquals(tc, NULL, f->units);
+    CuAssertPtrEquals(tc, NULL, regions);
+    CuAssertPtrNotNull(tc, r = findregion(1, 0));
+    CuAssertPtrEquals(tc, r, regions);
+    CuAssertPtrEquals(tc, NULL, r->next);
+    CuAssertPtrEquals(tc, NULL, findregion(2, 0));
+    CuAssertPtrNotNull(tc, u = findunit(uno));
+    CuAssertPtrEquals(tc, findregion(5, 5), u->region);
+    CuAssertPtrEquals(tc, f, u->faction);
+    /* an incomplete world cannot be saved */
+    CuAssertIntEquals(tc, -1, writegame(filename));
+    test_reset();
+
+    path_join(datapath(), filename, path, sizeof(path));
+    CuAssertIntEquals(tc, 0, remove(path));
+    test_teardown();
+}
+
 static void test_readwrite_unit(CuTest * tc)
 {
     gamedata data;
@@ -497,6 +582,8 @@ CuSuite *get_save_suite(void)
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, test_readwrite_attrib);
     SUITE_ADD_TEST(suite, test_readwrite_data);
+    SUITE_ADD_TEST(suite, test_region_index);
+    SUITE_ADD_TEST(suite, test_readgame_lazy);
     SUITE_ADD_TEST(suite, test_readwrite_unit);
     SUITE_ADD_TEST(suite, test_readwrite_faction);
     SUITE_ADD_TEST(suite, test_readwrite_region);
@@ -23,6 +23,7 @@
 #include <util/base36.h>
 #include <util/keyword.h>
 #include <util/language.h>
+#include <util/macros.h>
 #include <util/lists.h>
 #include <util/log.h>
 #include <util/message.h>
@@ -415,8 +416,8 @@ int shipspeed(const ship * sh, const unit * u)
 const char *shipname(const ship * sh)
 {
     typedef char name[OBJECTIDSIZE + 1];
-    static name idbuf[8];
-    static int nextbuf = 0;
+    static THREAD_LOCAL name idbuf[8];
+    static THREAD_LOCAL int nextbuf = 0;
     char *ibuf = idbuf[(++nextbuf) % 8];
     return write_shipname(sh, ibuf, sizeof(idbuf[0]));
 }
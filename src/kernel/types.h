@@ -46,7 +46,7 @@ enum {
   O_DEBUG,                      /* 32 */
   O_COMPRESS,                   /* 64 */
   O_NEWS,                       /* 128 */
-  O_UNUSED_8,
+  O_CRDELTA,                    /* 256 - computer report delta */
   O_ADRESSEN,                   /* 512 */
   O_BZIP2,                      /* 1024 - compress as bzip2 */
   O_SCORE,                      /* 2048 - punkte anzeigen? */
@@ -5,6 +5,7 @@
 #include "attrib.h"
 #include "building.h"
 #include "calendar.h"
+#include "callbacks.h"
 #include "connection.h"
 #include "curse.h"
 #include "event.h"
@@ -44,6 +45,7 @@
 #include <util/resolve.h>
 #include <util/rng.h>
 #include <util/variant.h>
+#include <util/workers.h>
 
 #include <storage.h>
 #include <strings.h>
@@ -57,6 +59,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
 
 #define BAGCAPACITY 20000   /* soviel passt in einen Bag of Holding */
 
@@ -92,10 +95,15 @@ attrib_type at_creator = {
 
 unit *findunit(int n)
 {
+    unit *u;
     if (n <= 0) {
         return NULL;
     }
-    return ufindhash(n);
+    u = ufindhash(n);
+    if (!u && callbacks.load_unit) {
+        u = callbacks.load_unit(n);
+    }
+    return u;
 }
 
 unit *findunitr(const region * r, int n)
@@ -168,6 +176,7 @@ typedef struct buddy {
 
 static buddy *get_friends(const unit * u, int *numfriends)
 {
+    static config_int rule_alliances = CONFIG_INT("rules.alliances", 0);
     buddy *friends = NULL;
     faction *f = u->faction;
     region *r = u->region;
@@ -177,7 +186,7 @@ static buddy *get_friends(const unit * u, int *numfriends)
     for (u2 = r->units; u2; u2 = u2->next) {
         if (u2->faction != f && u2->number > 0) {
             int allied = 0;
-            if (config_get_int("rules.alliances", 0) != 0) {
+            if (config_int_get(&rule_alliances) != 0) {
                 allied = (f->alliance && f->alliance == u2->faction->alliance);
             }
             else if (alliedunit(u, u2->faction, HELP_MONEY)
@@ -331,8 +340,37 @@ struct faction *dfindhash(int no) {
     return hmget(dead_hash, no);
 }
 
+/* counts changes to the units of a region, see units_changed. Regions
+ * share REGION_SLOTS counters, and changes to all regions are counted
+ * in u_moved_all. The sum of both only ever grows, and changes with
+ * either of them. */
+#define REGION_SLOTS 256
+static THREAD_LOCAL int u_moved[REGION_SLOTS];
+static THREAD_LOCAL int u_moved_all;
+
+void units_moved(const region *r)
+{
+    if (r) {
+        ++u_moved[r->index % REGION_SLOTS];
+    }
+    else {
+        ++u_moved_all;
+    }
+}
+
+bool units_changed(const region *r, int *cache_key)
+{
+    int moved = u_moved_all + u_moved[r->index % REGION_SLOTS];
+    if (*cache_key != moved) {
+        *cache_key = moved;
+        return true;
+    }
+    return false;
+}
+
 void erase_unit(unit** ulist, unit* u)
 {
+    units_moved(u->region);
     if (u->number) {
         set_number(u, 0);
     }
@@ -572,6 +610,7 @@ void set_level(struct unit * u, enum skill_t sk, unsigned int value)
     if (!skill_enabled(sk))
         return;
 
+    effskill_changed();
     if (value == 0) {
         remove_skill(u, sk);
         return;
@@ -753,7 +792,9 @@ void move_unit(unit * u, region * r, unit ** ulist)
     if (!ulist) {
         ulist = &r->units;
     }
+    units_moved(r);
     if (u->region) {
+        units_moved(u->region);
         leave_region(u);
         translist(&u->region->units, ulist, u);
     }
@@ -1157,16 +1198,124 @@ int get_modifier(const unit * u, enum skill_t sk, int level, const region * r, b
     return skill - bskill;
 }
 
+/* Combat and the reports ask for the same effective skills many times.
+ * Between effskill_memo_begin and effskill_memo_end, eff_skill remembers
+ * them in a table for each thread. The level, race, region and hunger
+ * are part of the key, changes to attributes and curses and calls to
+ * effskill_changed invalidate the whole table.
+ * Define DEBUG_EFFSKILL to check every remembered value. */
+#define SKILL_MEMOS 4096
+
+typedef struct skill_memo {
+    const unit *u;
+    const region *r;
+    const race *rc;
+    int no;
+    int stamp;
+    int level;
+    int value;
+    int flags;
+    skill_t sk;
+} skill_memo;
+
+static int skill_memo_generation;
+
+static THREAD_LOCAL struct {
+    int generation;
+    int stamp;
+    int attrib_key;
+    skill_memo *table;
+} skill_memos;
+
+static void skill_memo_free(void)
+{
+    free(skill_memos.table);
+    skill_memos.table = NULL;
+    skill_memos.generation = 0;
+}
+
+void effskill_memo_begin(void)
+{
+    if (++skill_memo_generation <= 0) {
+        skill_memo_generation = 1;
+    }
+    workers_atexit(skill_memo_free);
+}
+
+void effskill_memo_end(void)
+{
+    skill_memo_generation = 0;
+    skill_memo_free();
+}
+
+void effskill_changed(void)
+{
+    ++skill_memos.stamp;
+}
+
+static skill_memo *skill_memo_get(const unit *u, const skill *sv, const region *r)
+{
+    uintptr_t h;
+
+    if (skill_memo_generation == 0) {
+        return NULL;
+    }
+    if (skill_memos.generation != skill_memo_generation) {
+        if (!skill_memos.table) {
+            skill_memos.table = calloc(SKILL_MEMOS, sizeof(skill_memo));
+            if (!skill_memos.table) abort();
+        }
+        skill_memos.generation = skill_memo_generation;
+        ++skill_memos.stamp;
+    }
+    if (attrib_changed(&skill_memos.attrib_key)) {
+        ++skill_memos.stamp;
+    }
+    h = ((uintptr_t)u >> 4) ^ ((uintptr_t)r >> 4) * 31 ^ (uintptr_t)sv->id * 0x9e3779b9;
+    return skill_memos.table + (h & (SKILL_MEMOS - 1));
+}
+
+static bool skill_memo_match(const skill_memo *memo, const unit *u, const skill *sv, const region *r)
+{
+    return memo->stamp == skill_memos.stamp && memo->u == u && memo->no == u->no
+        && memo->r == r && memo->sk == sv->id && memo->level == sv->level
+        && memo->rc == u_race(u) && memo->flags == (u->flags & UFL_HUNGER);
+}
+
+static int eff_skill_calc(const unit * u, const skill *sv, const region *r)
+{
+    int mlevel = sv->level + get_modifier(u, sv->id, sv->level, r, false);
+    return (mlevel > 0) ? mlevel : 0;
+}
+
 int eff_skill(const unit * u, const skill *sv, const region *r)
 {
     assert(u);
     if (!r) r = u->region;
     if (sv && sv->level > 0) {
-        int mlevel = sv->level + get_modifier(u, sv->id, sv->level, r, false);
-
-        if (mlevel > 0) {
-            return mlevel;
+        skill_memo *memo = skill_memo_get(u, sv, r);
+        if (!memo) {
+            return eff_skill_calc(u, sv, r);
+        }
+        if (!skill_memo_match(memo, u, sv, r)) {
+            memo->u = u;
+            memo->r = r;
+            memo->rc = u_race(u);
+            memo->no = u->no;
+            memo->level = sv->level;
+            memo->flags = u->flags & UFL_HUNGER;
+            memo->sk = sv->id;
+            memo->value = eff_skill_calc(u, sv, r);
+            memo->stamp = skill_memos.stamp;
+        }
+#ifdef DEBUG_EFFSKILL
+        else if (memo->value != eff_skill_calc(u, sv, r)) {
+            log_error("effskill memo for %s, skill %d is %d, should be %d",
+                unitname(u), (int)sv->id, memo->value, eff_skill_calc(u, sv, r));
+            assert(!"effskill memo is out of date");
         }
+#endif
+        return memo->value;
     }
     return 0;
 }
@@ -1565,6 +1714,7 @@ void scale_number(unit * u, int n)
     if (n == u->number) {
         return;
     }
+    effskill_changed();
     if (u->number > 0) {
         if (n > 0) {
             u->hp = (long long)u->hp * n / u->number;
@@ -1665,8 +1815,8 @@ void remove_empty_units(void)
 }
 
 typedef char name[OBJECTIDSIZE + 1];
-static name idbuf[8];
-static int nextbuf = 0;
+static THREAD_LOCAL name idbuf[8];
+static THREAD_LOCAL int nextbuf = 0;
 
 /** Puts human-readable unit name, with number, like "Frodo (hobb)" into buffer */
 char *write_unitname(const unit * u, char *buffer, size_t size)
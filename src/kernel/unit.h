@@ -139,6 +139,15 @@ void transfermen(struct unit* src, struct unit* dst, int n);
 
 int eff_skill(const struct unit* u, const struct skill* sv, const struct region* r);
 int effskill_study(const struct unit* u, enum skill_t sk);
+void effskill_memo_begin(void);
+void effskill_memo_end(void);
+void effskill_changed(void);
+
+/* call units_moved when units enter, leave or are sorted within the
+ * units of region r without move_unit or remove_unit, or with NULL
+ * after changes to any region */
+void units_moved(const struct region *r);
+bool units_changed(const struct region *r, int *cache_key);
 
 int get_modifier(const struct unit* u, enum skill_t sk, int level,
     const struct region* r, bool noitem);
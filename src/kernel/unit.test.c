@@ -292,6 +292,35 @@ static void test_effskill_insects(CuTest *tc) {
     test_teardown();
 }
 
+static void test_effskill_memo(CuTest *tc) {
+    region *r;
+    unit *u;
+    race *rc;
+    attrib *a;
+
+    test_setup();
+    r = test_create_plain(0, 0);
+    u = test_create_unit(test_create_faction(), r);
+    set_level(u, SK_BUILDING, 2);
+    effskill_memo_begin();
+    CuAssertIntEquals(tc, 2, effskill(u, SK_BUILDING, r));
+    set_level(u, SK_BUILDING, 3);
+    CuAssertIntEquals(tc, 3, effskill(u, SK_BUILDING, r));
+    a = a_add(&u->attribs, make_skillmod(SK_BUILDING, NULL, 0.0, 1));
+    CuAssertIntEquals(tc, 4, effskill(u, SK_BUILDING, r));
+    a_remove(&u->attribs, a);
+    CuAssertIntEquals(tc, 3, effskill(u, SK_BUILDING, r));
+    fset(u, UFL_HUNGER);
+    CuAssertIntEquals(tc, 1, effskill(u, SK_BUILDING, r));
+    freset(u, UFL_HUNGER);
+    rc = test_create_race("smurf");
+    rc->bonus[SK_BUILDING] = 1;
+    u_setrace(u, rc);
+    CuAssertIntEquals(tc, 4, effskill(u, SK_BUILDING, r));
+    effskill_memo_end();
+    test_teardown();
+}
+
 static void test_skillmod(CuTest *tc) {
     unit *u;
     attrib *a;
@@ -1087,6 +1116,36 @@ static void test_getunit(CuTest* tc) {
     test_teardown();
 }
 
+static void test_units_changed(CuTest *tc) {
+    region *r1, *r2;
+    unit *u;
+    int key1 = 0, key2 = 0;
+
+    test_setup();
+    r1 = test_create_plain(0, 0);
+    r2 = test_create_plain(1, 0);
+    u = test_create_unit(test_create_faction(), r1);
+    units_changed(r1, &key1);
+    units_changed(r2, &key2);
+    CuAssertTrue(tc, !units_changed(r1, &key1));
+
+    /* a move changes the regions on both ends */
+    move_unit(u, r2, NULL);
+    CuAssertTrue(tc, units_changed(r1, &key1));
+    CuAssertTrue(tc, units_changed(r2, &key2));
+
+    /* other regions are not changed */
+    units_moved(r2);
+    CuAssertTrue(tc, !units_changed(r1, &key1));
+    CuAssertTrue(tc, units_changed(r2, &key2));
+
+    /* unless all of them are */
+    units_moved(NULL);
+    CuAssertTrue(tc, units_changed(r1, &key1));
+    CuAssertTrue(tc, units_changed(r2, &key2));
+    test_teardown();
+}
+
 CuSuite *get_unit_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
@@ -1114,6 +1173,7 @@ CuSuite *get_unit_suite(void)
     SUITE_ADD_TEST(suite, test_default_name);
     SUITE_ADD_TEST(suite, test_effskill);
     SUITE_ADD_TEST(suite, test_effskill_insects);
+    SUITE_ADD_TEST(suite, test_effskill_memo);
     SUITE_ADD_TEST(suite, test_skillmod);
     SUITE_ADD_TEST(suite, test_skill_hunger);
     SUITE_ADD_TEST(suite, test_skill_familiar);
@@ -1129,5 +1189,6 @@ CuSuite *get_unit_suite(void)
     SUITE_ADD_TEST(suite, test_maintenance_cost);
     SUITE_ADD_TEST(suite, test_max_heroes);
     SUITE_ADD_TEST(suite, test_getunit);
+    SUITE_ADD_TEST(suite, test_units_changed);
     return suite;
 }
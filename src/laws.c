@@ -76,6 +76,7 @@
 #include <util/rng.h>
 #include <util/umlaut.h>
 #include <util/unicode.h>
+#include <util/workers.h>
 
 /* attributes includes */
 #include <attributes/otherfaction.h>
@@ -130,8 +131,8 @@ param_t findparam_ex(const char *s, const struct locale * lang)
 
 int NewbieImmunity(void)
 {
-    int result = config_get_int("NewbieImmunity", 0);
-    return result;
+    static config_int immunity = CONFIG_INT("NewbieImmunity", 0);
+    return config_int_get(&immunity);
 }
 
 bool IsImmune(const faction * f, int age)
@@ -155,6 +156,8 @@ int NMRTimeout(void)
     return ini_timeout;
 }
 
+static config_int long_hunger = CONFIG_INT("hunger.long", 0);
+
 bool LongHunger(const struct unit *u)
 {
     if (u != NULL) {
@@ -163,7 +166,7 @@ bool LongHunger(const struct unit *u)
         if (u_race(u) == get_race(RC_DAEMON))
             return false;
     }
-    return config_get_int("hunger.long", 0) != 0;
+    return config_int_get(&long_hunger) != 0;
 }
 
 static bool RemoveNMRNewbie(void)
@@ -324,12 +327,14 @@ void peasant_migration(region * r)
 
 static double peasant_growth_factor(void)
 {
-    return config_get_flt("rules.peasants.growth.factor", 0.0001 * (double)PEASANTGROWTH);
+    static config_flt factor = CONFIG_FLT("rules.peasants.growth.factor", 0.0001 * (double)PEASANTGROWTH);
+    return config_flt_get(&factor);
 }
 
 static double peasant_luck_factor(void)
 {
-    return config_get_flt("rules.peasants.peasantluck.factor", PEASANTLUCK);
+    static config_flt factor = CONFIG_FLT("rules.peasants.peasantluck.factor", PEASANTLUCK);
+    return config_flt_get(&factor);
 }
 
 #define ROUND_BIRTHS(growth) (int)ceil(growth)
@@ -628,8 +633,9 @@ increased_growth(const region* r, const struct race *rc_elf) {
 static void
 growing_trees(region * r, const season_t current_season, const season_t last_weeks_season, int rules)
 {
+    static config_flt treeseeds = CONFIG_FLT("rules.treeseeds.chance", 0.005F);
     int grownup_trees, i, seeds;
-    double seedchance = config_get_flt("rules.treeseeds.chance", 0.005F);
+    double seedchance = config_flt_get(&treeseeds);
 
     if (current_season == SEASON_SUMMER || current_season == SEASON_AUTUMN) {
         const struct race* rc_elf = get_race(RC_ELF);
@@ -802,6 +808,7 @@ void immigration(void)
 
 void nmr_warnings(void)
 {
+    static config_int rule_alliances = CONFIG_INT("rules.alliances", 0);
     faction *f, *fa;
 #define HELP_NMR (HELP_GUARD|HELP_MONEY)
     for (f = factions; f; f = f->next) {
@@ -814,7 +821,7 @@ void nmr_warnings(void)
                 message *msg = NULL;
                 for (fa = factions; fa; fa = fa->next) {
                     int warn = 0;
-                    if (config_get_int("rules.alliances", 0) != 0) {
+                    if (config_int_get(&rule_alliances) != 0) {
                         if (f->alliance && f->alliance == fa->alliance) {
                             warn = 1;
                         }
@@ -1110,7 +1117,8 @@ static int mayboard(const unit * u, ship * sh)
 
 static bool CheckOverload(void)
 {
-    return config_get_int("rules.check_overload", 0) != 0;
+    static config_int check = CONFIG_INT("rules.check_overload", 0);
+    return config_int_get(&check) != 0;
 }
 
 int enter_ship(unit * u, struct order *ord, int id, bool report)
@@ -2653,13 +2661,15 @@ void sinkships(struct region * r)
                 if (fval(r->terrain, SEA_REGION)) {
                     if (!ship_crewed(sh, cap)) {
                         /* ship is at sea, but not enough people to control it */
-                        double dmg = config_get_flt("rules.ship.damage.nocrewocean", 0.3);
+                        static config_flt nocrewocean = CONFIG_FLT("rules.ship.damage.nocrewocean", 0.3);
+                        double dmg = config_flt_get(&nocrewocean);
                         damage_ship(sh, dmg);
                     }
                 }
                 else if (!cap) {
                     /* any ship lying around without an owner slowly rots */
-                    double dmg = config_get_flt("rules.ship.damage.nocrew", 0.05);
+                    static config_flt nocrew = CONFIG_FLT("rules.ship.damage.nocrew", 0.05);
+                    double dmg = config_flt_get(&nocrew);
                     damage_ship(sh, dmg);
                 }
             }
@@ -3341,7 +3351,9 @@ int claim_cmd(unit * u, struct order *ord)
 
 enum {
     PROC_THISORDER = 1 << 0,
-    PROC_LONGORDER = 1 << 1
+    PROC_LONGORDER = 1 << 1,
+    PROC_REGIONAL = 1 << 2, /* only touches its own region, may run in parallel */
+    PROC_RANDOM = 1 << 3 /* draws random numbers, must not run in parallel without per-region rng streams */
 };
 
 typedef enum processor_t { PR_GLOBAL, PR_REGION_PRE, PR_UNIT, PR_ORDER, PR_REGION_POST } processor_t;
@@ -3390,6 +3402,7 @@ static processor *add_proc(int priority, const char *name, processor_t type)
     proc->priority = priority;
     proc->type = type;
     proc->name = name;
+    proc->flags = 0;
     proc->next = *pproc;
     *pproc = proc;
     return proc;
@@ -3417,20 +3430,24 @@ void add_proc_global(int priority, void(*process) (void), const char *name)
     }
 }
 
-void add_proc_region(int priority, void(*process) (region *), const char *name)
+void add_proc_region(int priority, void(*process) (region *),
+    unsigned int flags, const char *name)
 {
     processor *proc = add_proc(priority, name, PR_REGION_PRE);
     if (proc) {
         proc->data.per_region.process = process;
+        proc->flags = flags;
     }
 }
 
 void
-add_proc_postregion(int priority, void(*process) (region *), const char *name)
+add_proc_postregion(int priority, void(*process) (region *),
+    unsigned int flags, const char *name)
 {
     processor *proc = add_proc(priority, name, PR_REGION_POST);
     if (proc) {
         proc->data.per_region.process = process;
+        proc->flags = flags;
     }
 }
 
@@ -3463,16 +3480,181 @@ bool long_order_allowed(const unit *u, bool flags_only)
     return true;
 }
 
+static void process_region(region *r, processor *pglobal, int prio)
+{
+    unit *u;
+    processor *pregion = pglobal;
+
+    while (pregion && pregion->priority == prio
+        && pregion->type == PR_REGION_PRE) {
+        pregion->data.per_region.process(r);
+        pregion = pregion->next;
+    }
+    if (pregion == NULL || pregion->priority != prio) {
+        return;
+    }
+
+    if (r->units) {
+        for (u = r->units; u; u = u->next) {
+            processor *porder, *punit = pregion;
+
+            if (IS_PAUSED(u->faction)) continue;
+
+            while (punit && punit->priority == prio && punit->type == PR_UNIT) {
+                punit->data.per_unit.process(u);
+                punit = punit->next;
+            }
+            if (punit == NULL || punit->priority != prio) {
+                continue;
+            }
+
+            porder = punit;
+            while (porder && porder->priority == prio && porder->type == PR_ORDER) {
+                order **ordp = &u->orders;
+                if (porder->flags & PROC_THISORDER) {
+                    ordp = &u->thisorder;
+                }
+                while (*ordp) {
+                    order *ord = *ordp;
+                    if (getkeyword(ord) == porder->data.per_order.kword) {
+                        if (porder->flags & PROC_LONGORDER) {
+                            if (u->number == 0) {
+                                ord = NULL;
+                            }
+                            else if (u_race(u) == get_race(RC_INSECT)
+                                && r_insectstalled(r)
+                                && !is_cursed(u->attribs, &ct_insectfur)) {
+                                ord = NULL;
+                            }
+                            else if (LongHunger(u)) {
+                                cmistake(u, ord, 224, MSG_MAGIC);
+                                ord = NULL;
+                            }
+                            else if (!long_order_allowed(u, false)) {
+                                ord = NULL;
+                            }
+                        }
+                        if (ord) {
+                            porder->data.per_order.process(u, ord);
+                            if (!u->orders) {
+                                /* GIVE UNIT or QUIT delete all orders of the unit, stop */
+                                break;
+                            }
+                        }
+                    }
+                    if (!ord || *ordp == ord) {
+                        ordp = &(*ordp)->next;
+                    }
+                }
+                porder = porder->next;
+            }
+        }
+    }
+
+    while (pregion && pregion->priority == prio
+        && pregion->type != PR_REGION_POST) {
+        pregion = pregion->next;
+    }
+
+    while (pregion && pregion->priority == prio
+        && pregion->type == PR_REGION_POST) {
+        pregion->data.per_region.process(r);
+        pregion = pregion->next;
+    }
+}
+
+/* a step can run on the worker pool if every non-global processor in it
+ * only touches the region it is called for. Random numbers must come
+ * from per-region streams, or the outcome depends on region order. */
+static bool is_regional_step(const processor *proc, int prio, bool streams)
+{
+    for (; proc && proc->priority == prio; proc = proc->next) {
+        if (proc->type != PR_GLOBAL) {
+            if (!(proc->flags & PROC_REGIONAL)) {
+                return false;
+            }
+            if (!streams && (proc->flags & PROC_RANDOM)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+typedef struct region_step {
+    region **regions;
+    message_buffer *buffers;
+    processor *pglobal;
+    int prio;
+    bool streams;
+} region_step;
+
+static void run_region_step(const region_step *step, region *r)
+{
+    if (step->streams) {
+        rng_stream rs;
+        rng_stream_init(&rs, step->prio, r->uid);
+        rng_stream_begin(&rs);
+        process_region(r, step->pglobal, step->prio);
+        rng_stream_end();
+    }
+    else {
+        process_region(r, step->pglobal, step->prio);
+    }
+}
+
+static void region_step_job(int index, void *udata)
+{
+    region_step *step = (region_step *)udata;
+
+    parser_pushstate();
+    msg_defer_begin(step->buffers + index);
+    run_region_step(step, step->regions[index]);
+    msg_defer_end();
+    reset_order();
+    parser_popstate();
+}
+
+/* Run one step for all regions on the worker pool. Messages are buffered
+ * per region and delivered in region order afterwards, so the message
+ * lists come out exactly as in a serial run. */
+static void process_regions_parallel(region_step *step)
+{
+    region *r;
+    int i, nregions = 0;
+
+    for (r = regions; r; r = r->next) {
+        ++nregions;
+    }
+    step->regions = malloc(sizeof(region *) * nregions);
+    step->buffers = calloc(nregions, sizeof(message_buffer));
+    if (!step->regions || !step->buffers) abort();
+    for (i = 0, r = regions; r; r = r->next) {
+        step->regions[i++] = r;
+    }
+    workers_run(nregions, region_step_job, step);
+    /* the workers have changed units this thread may remember */
+    units_moved(NULL);
+    for (i = 0; i != nregions; ++i) {
+        msg_defer_flush(step->buffers + i);
+    }
+    free(step->buffers);
+    free(step->regions);
+}
+
 /* per priority, execute processors in order from PR_GLOBAL down to PR_ORDER */
 void process(void)
 {
     processor *proc = processors;
     faction *f;
+    bool streams = config_get_int("game.rng.streams", 0) != 0;
 
+    config_threads();
     while (proc) {
         int prio = proc->priority;
         region *r;
         processor *pglobal = proc;
+        region_step step;
 
         log_debug("- Step %u", prio);
         while (proc && proc->priority == prio) {
@@ -3490,88 +3672,15 @@ void process(void)
             continue;
         }
 
-        for (r = regions; r; r = r->next) {
-            unit *u;
-            processor *pregion = pglobal;
-
-            while (pregion && pregion->priority == prio
-                && pregion->type == PR_REGION_PRE) {
-                pregion->data.per_region.process(r);
-                pregion = pregion->next;
-            }
-            if (pregion == NULL || pregion->priority != prio) {
-                continue;
-            }
-
-            if (r->units) {
-                for (u = r->units; u; u = u->next) {
-                    processor *porder, *punit = pregion;
-
-                    if (IS_PAUSED(u->faction)) continue;
-
-                    while (punit && punit->priority == prio && punit->type == PR_UNIT) {
-                        punit->data.per_unit.process(u);
-                        punit = punit->next;
-                    }
-                    if (punit == NULL || punit->priority != prio) {
-                        continue;
-                    }
-
-                    porder = punit;
-                    while (porder && porder->priority == prio && porder->type == PR_ORDER) {
-                        order **ordp = &u->orders;
-                        if (porder->flags & PROC_THISORDER) {
-                            ordp = &u->thisorder;
-                        }
-                        while (*ordp) {
-                            order *ord = *ordp;
-                            if (getkeyword(ord) == porder->data.per_order.kword) {
-                                if (porder->flags & PROC_LONGORDER) {
-                                    if (u->number == 0) {
-                                        ord = NULL;
-                                    }
-                                    else if (u_race(u) == get_race(RC_INSECT)
-                                        && r_insectstalled(r)
-                                        && !is_cursed(u->attribs, &ct_insectfur)) {
-                                        ord = NULL;
-                                    }
-                                    else if (LongHunger(u)) {
-                                        cmistake(u, ord, 224, MSG_MAGIC);
-                                        ord = NULL;
-                                    }
-                                    else if (!long_order_allowed(u, false)) {
-                                        ord = NULL;
-                                    }
-                                }
-                                if (ord) {
-                                    porder->data.per_order.process(u, ord);
-                                    if (!u->orders) {
-                                        /* GIVE UNIT or QUIT delete all orders of the unit, stop */
-                                        break;
-                                    }
-                                }
-                            }
-                            if (!ord || *ordp == ord) {
-                                ordp = &(*ordp)->next;
-                            }
-                        }
-                        porder = porder->next;
-                    }
-                }
-            }
-
-            while (pregion && pregion->priority == prio
-                && pregion->type != PR_REGION_POST) {
-                pregion = pregion->next;
-            }
-
-            while (pregion && pregion->priority == prio
-                && pregion->type == PR_REGION_POST) {
-                pregion->data.per_region.process(r);
-                pregion = pregion->next;
-            }
-            if (pregion == NULL || pregion->priority != prio) {
-                continue;
+        step.pglobal = pglobal;
+        step.prio = prio;
+        step.streams = streams;
+        if (workers_count() > 1 && is_regional_step(pglobal, prio, streams)) {
+            process_regions_parallel(&step);
+        }
+        else {
+            for (r = regions; r; r = r->next) {
+                run_region_step(&step, r);
             }
         }
     }
@@ -3638,7 +3747,8 @@ static void do_force_leave(region *r) {
 }
 
 bool rule_force_leave(int flags) {
-    int rules = config_get_int("rules.owners.force_leave", 0);
+    static config_int rule = CONFIG_INT("rules.owners.force_leave", 0);
+    int rules = config_int_get(&rule);
     return (rules&flags) == flags;
 }
 
@@ -3682,24 +3792,24 @@ void init_processor(void)
     }
 
     p += 10;
-    add_proc_region(p, do_contact, "Kontaktieren");
-    add_proc_order(p, K_MAIL, mail_cmd, 0, "Botschaften");
+    add_proc_region(p, do_contact, PROC_REGIONAL, "Kontaktieren");
+    add_proc_order(p, K_MAIL, mail_cmd, PROC_REGIONAL, "Botschaften");
 
     p += 10;                      /* all claims must be done before we can USE */
-    add_proc_region(p, enter_1, "Betreten (1. Versuch)");     /* for GIVE CONTROL */
+    add_proc_region(p, enter_1, 0, "Betreten (1. Versuch)");     /* for GIVE CONTROL */
     add_proc_order(p, K_USE, use_cmd, 0, "Benutzen");
 
     p += 10;                      /* in case it has any effects on alliance victories */
     add_proc_order(p, K_LEAVE, leave_cmd, 0, "Verlassen");
 
     p += 10;
-    add_proc_region(p, enter_1, "Betreten (2. Versuch)"); /* to allow a buildingowner to enter the castle pre combat */
+    add_proc_region(p, enter_1, 0, "Betreten (2. Versuch)"); /* to allow a buildingowner to enter the castle pre combat */
 
     p += 10;
     add_proc_global(p, do_battles, "Attackieren");
 
     p += 10;                      /* can't allow reserve before siege (weapons) */
-    add_proc_region(p, enter_1, "Betreten (3. Versuch)");  /* to claim a castle after a victory and to be able to DESTROY it in the same turn */
+    add_proc_region(p, enter_1, 0, "Betreten (3. Versuch)");  /* to claim a castle after a victory and to be able to DESTROY it in the same turn */
     if (config_get_int("rules.reserve.twophase", 0)) {
         add_proc_order(p, K_RESERVE, reserve_self, 0, "RESERVE (self)");
         p += 10;
@@ -3713,11 +3823,11 @@ void init_processor(void)
 
     p += 10;                      /* reset rng again before economics */
     if (rule_force_leave(FORCE_LEAVE_ALL)) {
-        add_proc_region(p, do_force_leave, "kick non-allies out of buildings/ships");
+        add_proc_region(p, do_force_leave, 0, "kick non-allies out of buildings/ships");
     }
-    add_proc_region(p, do_give, "Geben");
-    add_proc_region(p+1, recruit, "Rekrutieren");
-    add_proc_region(p+2, destroy, "Zerstoeren");
+    add_proc_region(p, do_give, 0, "Geben");
+    add_proc_region(p+1, recruit, PROC_RANDOM, "Rekrutieren");
+    add_proc_region(p+2, destroy, 0, "Zerstoeren");
     add_proc_unit(p, follow_cmds, "Folge auf Einheiten setzen");
     add_proc_order(p, K_QUIT, quit_cmd, 0, "Stirb");
 
@@ -3729,9 +3839,9 @@ void init_processor(void)
 
     p += 10;
     if (!keyword_disabled(K_PAY)) {
-        add_proc_order(p, K_PAY, pay_cmd, 0, "Gebaeudeunterhalt (BEZAHLE NICHT)");
+        add_proc_order(p, K_PAY, pay_cmd, PROC_REGIONAL, "Gebaeudeunterhalt (BEZAHLE NICHT)");
     }
-    add_proc_postregion(p, maintain_buildings, "Gebaeudeunterhalt");
+    add_proc_postregion(p, maintain_buildings, PROC_REGIONAL, "Gebaeudeunterhalt");
 
     if (!keyword_disabled(K_CAST)) {
         p += 10;
@@ -3739,31 +3849,31 @@ void init_processor(void)
     }
 
     p += 10;
-    add_proc_region(p, do_autostudy, "study automation");
+    add_proc_region(p, do_autostudy, 0, "study automation");
     add_proc_order(p, K_TEACH, teach_cmd, PROC_THISORDER | PROC_LONGORDER,
         "Lehren");
     p += 10;
-    add_proc_order(p, K_STUDY, study_cmd, PROC_THISORDER | PROC_LONGORDER,
-        "Lernen");
+    add_proc_order(p, K_STUDY, study_cmd,
+        PROC_THISORDER | PROC_LONGORDER | PROC_RANDOM, "Lernen");
 
     p += 10;
-    add_proc_order(p, K_MAKE, make_cmd, PROC_THISORDER | PROC_LONGORDER,
-        "Produktion");
-    add_proc_postregion(p, produce, "Arbeiten, Handel, Rekruten");
-    add_proc_postregion(p, split_allocations, "Produktion II");
+    add_proc_order(p, K_MAKE, make_cmd,
+        PROC_THISORDER | PROC_LONGORDER | PROC_RANDOM, "Produktion");
+    add_proc_postregion(p, produce, PROC_RANDOM, "Arbeiten, Handel, Rekruten");
+    add_proc_postregion(p, split_allocations, PROC_RANDOM, "Produktion II");
 
     p += 10;
-    add_proc_region(p, enter_2, "Betreten (4. Versuch)"); /* Once again after QUIT */
+    add_proc_region(p, enter_2, 0, "Betreten (4. Versuch)"); /* Once again after QUIT */
 
     p += 10;
-    add_proc_region(p, sinkships, "Schiffe sinken");
+    add_proc_region(p, sinkships, 0, "Schiffe sinken");
 
     p += 10;
     add_proc_global(p, movement, "Bewegungen");
 
     if (config_get_int("work.auto", 0)) {
         p += 10;
-        add_proc_region(p, auto_work, "Arbeiten (auto)");
+        add_proc_region(p, auto_work, 0, "Arbeiten (auto)");
     }
 
     p += 10;
@@ -3787,7 +3897,7 @@ void init_processor(void)
     p += 10;
 
     if (!keyword_disabled(K_SORT)) {
-        add_proc_region(p, do_sort, "Einheiten sortieren");
+        add_proc_region(p, do_sort, 0, "Einheiten sortieren");
     }
     add_proc_order(p, K_EXPEL, expel_cmd, 0, "Einheiten verjagen");
     if (!keyword_disabled(K_NUMBER)) {
@@ -3866,6 +3976,7 @@ void turn_end(void)
 
     /* am Ende der Auswertung die neuen Defaults zu den Befehlen dazu */
     update_defaults();
+    free_order_tokens();
 
     /* start the next week */
     ++turn;
@@ -3945,6 +4056,120 @@ cansee_unit(const unit * u, const region *r, const unit * target, int modifier)
     return CANSEE_DETECTED == see;
 }
 
+/* While the reports are written, units do not change. cansee then
+ * remembers the best perception of each faction in a region, and the
+ * stealth of the units it looks at. Every thread has its own cache, and
+ * cansee_cache_begin starts a new generation of them. */
+typedef struct observer_key {
+    const region *r;
+    const faction *f;
+} observer_key;
+
+typedef struct observers {
+    int count;          /* units of the faction in the region */
+    int watch;          /* best perception of those units */
+    int watch_amulet;   /* best perception of units with an amulet of true seeing */
+} observers;
+
+typedef struct seen_target {
+    int stealth;
+    int rings;
+} seen_target;
+
+static int cansee_generation;
+
+static THREAD_LOCAL struct {
+    int generation;
+    struct observer_entry {
+        observer_key key;
+        observers value;
+    } *observers;
+    struct target_entry {
+        const unit *key;
+        seen_target value;
+    } *targets;
+} cansee_cache;
+
+static void cansee_cache_free(void)
+{
+    hmfree(cansee_cache.observers);
+    hmfree(cansee_cache.targets);
+    cansee_cache.generation = 0;
+}
+
+void cansee_cache_begin(void)
+{
+    if (++cansee_generation <= 0) {
+        cansee_generation = 1;
+    }
+    workers_atexit(cansee_cache_free);
+}
+
+void cansee_cache_end(void)
+{
+    cansee_generation = 0;
+    cansee_cache_free();
+}
+
+static bool cansee_cache_valid(void)
+{
+    if (cansee_generation == 0) {
+        return false;
+    }
+    if (cansee_cache.generation != cansee_generation) {
+        cansee_cache_free();
+        cansee_cache.generation = cansee_generation;
+    }
+    return true;
+}
+
+static const observers *get_observers(const faction *f, const region *r)
+{
+    observer_key key;
+    ptrdiff_t i;
+
+    key.r = r;
+    key.f = f;
+    i = cansee_cache.observers ? hmgeti(cansee_cache.observers, key) : -1;
+    if (i < 0) {
+        const resource_type *rtype = get_resourcetype(R_AMULET_OF_TRUE_SEEING);
+        bool perception = skill_enabled(SK_PERCEPTION);
+        observers obs;
+        unit *u2;
+
+        obs.count = 0;
+        obs.watch = obs.watch_amulet = INT_MIN;
+        for (u2 = r->units; u2; u2 = u2->next) {
+            if (u2->faction == f) {
+                int watch = perception ? effskill(u2, SK_PERCEPTION, r) : 0;
+                ++obs.count;
+                if (watch > obs.watch) {
+                    obs.watch = watch;
+                }
+                if (rtype && watch > obs.watch_amulet && i_get(u2->items, rtype->itype) > 0) {
+                    obs.watch_amulet = watch;
+                }
+            }
+        }
+        hmput(cansee_cache.observers, key, obs);
+        i = hmgeti(cansee_cache.observers, key);
+    }
+    return &cansee_cache.observers[i].value;
+}
+
+static const seen_target *get_target(const unit *u)
+{
+    ptrdiff_t i = cansee_cache.targets ? hmgeti(cansee_cache.targets, u) : -1;
+    if (i < 0) {
+        seen_target t;
+        t.rings = invisible(u, NULL);
+        t.stealth = eff_stealth(u, u->region);
+        hmput(cansee_cache.targets, u, t);
+        i = hmgeti(cansee_cache.targets, u);
+    }
+    return &cansee_cache.targets[i].value;
+}
+
 /**
  * Determine if unit can be seen by faction.
  *
@@ -3962,7 +4187,7 @@ bool cansee(const faction *f, const region *r, const unit *u, int modifier)
 {
     unit *u2;
     int rings, stealth;
-    bool bsm, result;
+    bool bsm, result, cached;
 
     /* quick exits: */
     if (u->faction == f || omniscient(f)) {
@@ -3984,14 +4209,35 @@ bool cansee(const faction *f, const region *r, const unit *u, int modifier)
         return true;
     }
 
-    rings = invisible(u, NULL);
-    stealth = eff_stealth(u, r) - modifier;
+    cached = cansee_cache_valid();
+    if (cached && r == u->region) {
+        const seen_target *t = get_target(u);
+        rings = t->rings;
+        stealth = t->stealth - modifier;
+    }
+    else {
+        rings = invisible(u, NULL);
+        stealth = eff_stealth(u, r) - modifier;
+    }
 
     if (rings > 0 && rings < u->number && stealth <= 0) {
         return true;
     }
 
     result = bsm = big_sea_monster(u, r);
+    if (cached) {
+        const observers *obs = get_observers(f, r);
+        int watch;
+        if (obs->count == 0) {
+            return result;
+        }
+        /* the same decision that cansee_ex makes for every observer */
+        watch = (rings > 0 && rings >= u->number) ? obs->watch_amulet : obs->watch;
+        if (watch == INT_MIN) {
+            return false;
+        }
+        return bsm || !skill_enabled(SK_PERCEPTION) || stealth <= watch;
+    }
     for (u2 = r->units; u2; u2 = u2->next) {
         if (u2->faction == f) {
             enum cansee_t see = cansee_ex(u2, r, u, stealth, rings);
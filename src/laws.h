@@ -86,6 +86,9 @@ extern "C" {
 
     bool cansee(const struct faction * f, const struct region * r,
         const struct unit *u, int modifier);
+    /* while reports are written, cansee can cache what it learns */
+    void cansee_cache_begin(void);
+    void cansee_cache_end(void);
     bool cansee_unit(const struct unit *u, const struct region *r, const struct unit *who,
         int modifier);
     bool seefaction(const struct faction *f, const struct region *r,
@@ -33,6 +33,7 @@
 #include <util/message.h>
 #include <util/param.h>
 #include <util/rand.h>
+#include <util/rng.h>
 #include <util/variant.h>  // for variant, frac_make, frac_zero
 
 #include <CuTest.h>
@@ -41,6 +42,7 @@
 #include <assert.h>
 #include <stdbool.h>                 // for false, true, bool
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static void test_new_building_can_be_renamed(CuTest * tc)
@@ -2102,6 +2104,44 @@ static void test_cansee_ring(CuTest *tc) {
     test_teardown();
 }
 
+static void test_cansee_cache(CuTest *tc) {
+    unit *u, *u2, *u3;
+    item_type *iring, *isee;
+
+    test_setup();
+    u = test_create_unit(test_create_faction(), test_create_plain(0, 0));
+    u2 = test_create_unit(test_create_faction(), u->region);
+    u3 = test_create_unit(u->faction, u->region);
+    iring = test_create_itemtype("roi");
+    isee = test_create_itemtype("aots");
+    set_level(u2, SK_STEALTH, 2);
+    set_level(u, SK_PERCEPTION, 1);
+
+    cansee_cache_begin();
+    CuAssertTrue(tc, !cansee(u->faction, u->region, u2, 0));
+    CuAssertTrue(tc, cansee(u->faction, u->region, u2, 1));
+    /* the cache does not notice changes to the units */
+    set_level(u3, SK_PERCEPTION, 2);
+    CuAssertTrue(tc, !cansee(u->faction, u->region, u2, 0));
+    cansee_cache_end();
+    CuAssertTrue(tc, cansee(u->faction, u->region, u2, 0));
+
+    /* only units with an amulet see through rings */
+    i_change(&u2->items, iring, 1);
+    cansee_cache_begin();
+    CuAssertTrue(tc, !cansee(u->faction, u->region, u2, 0));
+    cansee_cache_begin();
+    i_change(&u->items, isee, 1);
+    CuAssertTrue(tc, !cansee(u->faction, u->region, u2, 0));
+    CuAssertTrue(tc, cansee(u->faction, u->region, u2, 1));
+    cansee_cache_begin();
+    i_change(&u3->items, isee, 1);
+    CuAssertTrue(tc, cansee(u->faction, u->region, u2, 0));
+    cansee_cache_end();
+
+    test_teardown();
+}
+
 static void test_cansee_sphere(CuTest *tc) {
     unit *u, *u2;
     item_type *itype[2];
@@ -2868,6 +2908,73 @@ static void test_transfer_faction(CuTest *tc) {
 }
 #endif
 
+/* one building per region, only some of the owners can pay for it, and
+ * every unit of the second faction contacts its neighbour */
+static void setup_turn_threads(void)
+{
+    faction *f1, *f2;
+    building_type *btype;
+    item_type *silver;
+    maintenance *req;
+    int x;
+
+    rng_init(42);
+    f1 = test_create_faction();
+    f2 = test_create_faction();
+    silver = test_create_silver();
+    btype = test_create_buildingtype("hort");
+    req = calloc(2, sizeof(maintenance));
+    req[0].number = 50;
+    req[0].rtype = silver->rtype;
+    btype->maintenance = req;
+    for (x = 0; x != 8; ++x) {
+        region *r = test_create_plain(x, 0);
+        unit *u1 = test_create_unit(f1, r);
+        unit *u2 = test_create_unit(f2, r);
+        u_set_building(u1, test_create_building(r, btype));
+        test_set_item(u1, silver, (x % 2) ? 100 : 10);
+        if (x % 3 == 0) {
+            unit_addorder(u1, create_order(K_PAY, f1->locale, "%s",
+                param_name(P_NOT, f1->locale)));
+        }
+        unit_addorder(u2, create_order(K_CONTACT, f2->locale, "%s %s",
+            param_name(P_UNIT, f2->locale), itoa36(u1->no)));
+    }
+}
+
+static void turn_result(char *buf, size_t size)
+{
+    const item_type *silver = get_resourcetype(R_SILVER)->itype;
+    region *r;
+    faction *f;
+    size_t len = 0;
+
+    for (r = regions; r && len < size; r = r->next) {
+        unit *u;
+        building *b;
+        for (u = r->units; u && len < size; u = u->next) {
+            len += snprintf(buf + len, size - len, "%s:%d ", itoa36(u->no),
+                i_get(u->items, silver));
+        }
+        for (b = r->buildings; b && len < size; b = b->next) {
+            len += snprintf(buf + len, size - len, "%s:%d ", itoa36(b->no),
+                b->flags & (BLD_DONTPAY | BLD_UNMAINTAINED));
+        }
+        if (len < size) {
+            len += test_messagetypes(buf + len, size - len, r->msgs);
+        }
+    }
+    for (f = factions; f && len < size; f = f->next) {
+        len += test_messagetypes(buf + len, size - len, f->msgs);
+    }
+    assert(len < size);
+}
+
+/* regional steps run on the worker pool, that must not change the turn */
+static void test_turn_threads(CuTest *tc) {
+    test_threads_agree(tc, setup_turn_threads, turn_process, turn_result);
+}
+
 CuSuite *get_laws_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
@@ -2942,6 +3049,7 @@ CuSuite *get_laws_suite(void)
     SUITE_ADD_TEST(suite, test_armedmen);
     SUITE_ADD_TEST(suite, test_cansee);
     SUITE_ADD_TEST(suite, test_cansee_ring);
+    SUITE_ADD_TEST(suite, test_cansee_cache);
     SUITE_ADD_TEST(suite, test_cansee_sphere);
     SUITE_ADD_TEST(suite, test_cansee_monsters);
     SUITE_ADD_TEST(suite, test_cansee_guard);
@@ -2968,6 +3076,7 @@ CuSuite *get_laws_suite(void)
     SUITE_ADD_TEST(suite, test_quit_transfer_hero);
     SUITE_ADD_TEST(suite, test_transfer_faction);
 #endif
+    SUITE_ADD_TEST(suite, test_turn_threads);
 
     return suite;
 }
@@ -172,7 +172,8 @@ void unit_add_spell(unit * u, struct spell * sp, int level)
 
 static double MagicRegeneration(void)
 {
-    return config_get_flt("magic.regeneration", 1.0);
+    static config_flt regeneration = CONFIG_FLT("magic.regeneration", 1.0);
+    return config_flt_get(&regeneration);
 }
 
 static double MagicPower(double force)
@@ -1213,7 +1214,8 @@ bool fumble(region * r, unit * u, const spell * sp, int cast_grade)
     int effsk = effskill(u, SK_MAGIC, r);
     struct building *b = inside_building(u);
     const struct building_type *btype = building_is_active(b) ? b->type : NULL;
-    int fumble_enabled = config_get_int("magic.fumble.enable", 1);
+    static config_int fumble_rule = CONFIG_INT("magic.fumble.enable", 1);
+    int fumble_enabled = config_int_get(&fumble_rule);
     sc_mage * mage;
 
     UNUSED_ARG(sp);
@@ -1403,7 +1405,8 @@ void regenerate_aura(void)
     double reg_aura;
     int regen;
     double mod;
-    int regen_enabled = config_get_int("magic.regeneration.enable", 1);
+    static config_int regen_rule = CONFIG_INT("magic.regeneration.enable", 1);
+    int regen_enabled = config_int_get(&regen_rule);
 
     if (!regen_enabled) return;
 
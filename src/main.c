@@ -82,6 +82,7 @@ static const char * valid_keys[] = {
     "game.dbname",
     "game.dbswap",
     "game.dbbatch",
+    "game.rulecache",
     "editor.color",
     "editor.codepage",
     "editor.population.",
@@ -386,7 +386,8 @@ int walkingcapacity(const struct unit *u, const capacities *cap)
     if (rbelt) {
         int belts = i_get(u->items, rbelt->itype);
         if (belts) {
-            int multi = config_get_int("rules.trollbelt.multiplier", STRENGTHMULTIPLIER);
+            static config_int trollbelt = CONFIG_INT("rules.trollbelt.multiplier", STRENGTHMULTIPLIER);
+            int multi = config_int_get(&trollbelt);
             if (belts > people) belts = people;
             n += belts * (multi - 1) * u_race(u)->capacity;
         }
@@ -559,6 +560,8 @@ static double overload(const region * r, ship * sh)
     }
 }
 
+static mt_handle mh_entermaelstrom = MT_HANDLE("entermaelstrom", "region ship damage sink");
+
 /* ------------------------------------------------------------- */
 
 static ship *do_maelstrom(region * r, unit * u)
@@ -575,14 +578,12 @@ static ship *do_maelstrom(region * r, unit * u)
     damage_ship(u->ship, 0.01 * damage);
 
     if (ship_damage_percent(sh) >= 100) {
-        ADDMSG(&u->faction->msgs, msg_message("entermaelstrom",
-            "region ship damage sink", r, sh, damage, 1));
+        ADDMSG(&u->faction->msgs, msg_handle(&mh_entermaelstrom, r, sh, damage, 1));
         sink_ship(sh);
         remove_ship(&sh->region->ships, sh);
         return NULL;
     }
-    ADDMSG(&u->faction->msgs, msg_message("entermaelstrom",
-        "region ship damage sink", r, sh, damage, 0));
+    ADDMSG(&u->faction->msgs, msg_handle(&mh_entermaelstrom, r, sh, damage, 0));
     return u->ship;
 }
 
@@ -717,22 +718,28 @@ static bool is_freezing(const unit * u)
     return true;
 }
 
+static mt_handle mh_detectforbidden = MT_HANDLE("detectforbidden", "unit region");
+static mt_handle mh_harbor_denied = MT_HANDLE("harbor_denied", "ship region");
+static mt_handle mh_sailnolandingstorm = MT_HANDLE("sailnolandingstorm", "ship region");
+static mt_handle mh_sailnolanding = MT_HANDLE("sailnolanding", "ship region");
+
 void deny_ship_entry(unit *u, struct region* current_point, struct region* next_point, int reason)
 {
     ship* sh = u->ship;
     faction* f = u->faction;
     if (reason == SA_INSECT_DENIED) {
-        ADDMSG(&f->msgs, msg_message("detectforbidden", "unit region", u, next_point));
+        ADDMSG(&f->msgs, msg_handle(&mh_detectforbidden, u, next_point));
     }
     else if (reason == SA_HARBOUR_DENIED) {
-        ADDMSG(&f->msgs, msg_message("harbor_denied", "ship region", sh, next_point));
+        ADDMSG(&f->msgs, msg_handle(&mh_harbor_denied, sh, next_point));
     }
     else if (lighthouse_guarded(current_point)) {
-        ADDMSG(&f->msgs, msg_message("sailnolandingstorm", "ship region", sh, next_point));
+        ADDMSG(&f->msgs, msg_handle(&mh_sailnolandingstorm, sh, next_point));
     }
     else {
-        double dmg = config_get_flt("rules.ship.damage.nolanding", 0.1);
-        ADDMSG(&f->msgs, msg_message("sailnolanding", "ship region", sh,
+        static config_flt nolanding = CONFIG_FLT("rules.ship.damage.nolanding", 0.1);
+        double dmg = config_flt_get(&nolanding);
+        ADDMSG(&f->msgs, msg_handle(&mh_sailnolanding, sh,
             next_point));
         if (reason != SA_HARBOUR_DISABLED) {
             damage_ship(sh, dmg);
@@ -816,23 +823,28 @@ static enum direction_t set_coast(ship * sh, region * r, region * rnext)
 }
 
 static double overload_start(void) {
-    return config_get_flt("rules.ship.overload.start", 1.1);
+    static config_flt value = CONFIG_FLT("rules.ship.overload.start", 1.1);
+    return config_flt_get(&value);
 }
 
 static double overload_worse(void) {
-    return config_get_flt("rules.ship.overload.worse", 1.5);
+    static config_flt value = CONFIG_FLT("rules.ship.overload.worse", 1.5);
+    return config_flt_get(&value);
 }
 
 static double overload_worst(void) {
-    return config_get_flt("rules.ship.overload.worst", 5.0);
+    static config_flt value = CONFIG_FLT("rules.ship.overload.worst", 5.0);
+    return config_flt_get(&value);
 }
 
 static double overload_default_damage(void) {
-    return config_get_flt("rules.ship.overload.damage.default", 0.05);
+    static config_flt value = CONFIG_FLT("rules.ship.overload.damage.default", 0.05);
+    return config_flt_get(&value);
 }
 
 static double overload_max_damage(void) {
-    return config_get_flt("rules.ship.overload.damage.max", 0.37);
+    static config_flt value = CONFIG_FLT("rules.ship.overload.damage.max", 0.37);
+    return config_flt_get(&value);
 }
 
 double damage_overload(double overload, double damage_max)
@@ -892,6 +904,9 @@ direction_t drift_target(ship *sh) {
     return result;
 }
 
+static mt_handle mh_massive_overload = MT_HANDLE("massive_overload", "ship");
+static mt_handle mh_shipsink = MT_HANDLE("shipsink", "ship");
+
 static void drifting_ships(region * r)
 {
     static int config;
@@ -960,13 +975,13 @@ static void drifting_ships(region * r)
             if (damage_max > 0) {
                 if (ovl >= overload_start()) {
                     damage_ship(sh, damage_overload(ovl, damage_max));
-                    msg_to_passengers(sh, &firstu, &lastu, msg_message("massive_overload", "ship", sh));
+                    msg_to_passengers(sh, &firstu, &lastu, msg_handle(&mh_massive_overload, sh));
                 }
                 else {
                     damage_ship(sh, damage_drift);
                 }
                 if (ship_damage_percent(sh) >= 100) {
-                    msg_to_passengers(sh, &firstu, &lastu, msg_message("shipsink", "ship", sh));
+                    msg_to_passengers(sh, &firstu, &lastu, msg_handle(&mh_shipsink, sh));
                     sink_ship(sh);
                     remove_ship(shp, sh);
                     continue;
@@ -993,6 +1008,9 @@ static bool is_present(region* r, unit* u)
     return (u && u->region == r);
 }
 
+static mt_handle mh_followfail_ship = MT_HANDLE("followfail_ship", "ship follower");
+static mt_handle mh_followdetect_ship = MT_HANDLE("followdetect_ship", "ship follower");
+
 static void caught_target_ship(region* r, unit* u)
 {
     attrib* a = a_find(u->attribs, &at_follow);
@@ -1005,17 +1023,19 @@ static void caught_target_ship(region* r, unit* u)
         unit* target = (unit*)a->data.v;
 
         if (target == u || r != target->region) {
-            ADDMSG(&u->faction->msgs, msg_message("followfail_ship",
-                "ship follower", target->ship, u->ship));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_followfail_ship, target->ship, u->ship));
         }
         else if (!alliedunit(target, u->faction, HELP_ALL)
             && cansee(target->faction, r, u, 0)) {
-            ADDMSG(&target->faction->msgs, msg_message("followdetect_ship",
-                "ship follower", target->ship, u->ship));
+            ADDMSG(&target->faction->msgs, msg_handle(&mh_followdetect_ship,
+                target->ship, u->ship));
         }
     }
 }
 
+static mt_handle mh_followfail = MT_HANDLE("followfail", "unit follower");
+static mt_handle mh_followdetect = MT_HANDLE("followdetect", "unit follower");
+
 static void caught_target(region * r, unit * u)
 {
     attrib *a = a_find(u->attribs, &at_follow);
@@ -1028,17 +1048,23 @@ static void caught_target(region * r, unit * u)
         unit *target = (unit *)a->data.v;
 
         if (target == u || !is_present(r, target)) {
-            ADDMSG(&u->faction->msgs, msg_message("followfail", "unit follower",
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_followfail,
                 target, u));
         }
         else if (!alliedunit(target, u->faction, HELP_ALL)
             && cansee(target->faction, r, u, 0)) {
-            ADDMSG(&target->faction->msgs, msg_message("followdetect",
-                "unit follower", target, u));
+            ADDMSG(&target->faction->msgs, msg_handle(&mh_followdetect, target, u));
         }
     }
 }
 
+static config_flt guard_base_prob = CONFIG_FLT("rules.guard.base_stop_prob", .3);
+static config_flt guard_skill_prob = CONFIG_FLT("rules.guard.skill_stop_prob", .1);
+static config_flt guard_amulet_prob = CONFIG_FLT("rules.guard.amulet_stop_prob", .1);
+static config_flt guard_number_stop_prob = CONFIG_FLT("rules.guard.guard_number_stop_prob", .001);
+static config_flt guard_castle_prob = CONFIG_FLT("rules.guard.castle_stop_prob", .1);
+static config_flt guard_region_type_prob = CONFIG_FLT("rules.guard.region_type_stop_prob", .1);
+
 static unit *bewegung_blockiert_von(unit * reisender, region * r)
 {
     unit *u;
@@ -1049,12 +1075,12 @@ static unit *bewegung_blockiert_von(unit * reisender, region * r)
     const struct resource_type *ramulet = get_resourcetype(R_AMULET_OF_TRUE_SEEING);
     const struct building_type *castle_bt = bt_find("castle");
 
-    double base_prob = config_get_flt("rules.guard.base_stop_prob", .3);
-    double skill_prob = config_get_flt("rules.guard.skill_stop_prob", .1);
-    double amulet_prob = config_get_flt("rules.guard.amulet_stop_prob", .1);
-    double guard_number_prob = config_get_flt("rules.guard.guard_number_stop_prob", .001);
-    double castle_prob = config_get_flt("rules.guard.castle_stop_prob", .1);
-    double region_type_prob = config_get_flt("rules.guard.region_type_stop_prob", .1);
+    double base_prob = config_flt_get(&guard_base_prob);
+    double skill_prob = config_flt_get(&guard_skill_prob);
+    double amulet_prob = config_flt_get(&guard_amulet_prob);
+    double guard_number_prob = config_flt_get(&guard_number_stop_prob);
+    double castle_prob = config_flt_get(&guard_castle_prob);
+    double region_type_prob = config_flt_get(&guard_region_type_prob);
 
     if (fval(u_race(reisender), RCF_ILLUSIONARY))
         return NULL;
@@ -1470,6 +1496,8 @@ static const region_list *reroute(unit * u, const region_list * route,
     return route;
 }
 
+static mt_handle mh_moveblocked = MT_HANDLE("moveblocked", "unit direction");
+
 static message *movement_error(unit * u, const char *token, order * ord,
     int error_code)
 {
@@ -1477,7 +1505,7 @@ static message *movement_error(unit * u, const char *token, order * ord,
     switch (error_code) {
     case E_MOVE_BLOCKED:
         d = get_direction(token, u->faction->locale);
-        return msg_message("moveblocked", "unit direction", u, d);
+        return msg_handle(&mh_moveblocked, u, d);
     case E_MOVE_NOREGION:
         return msg_feedback(u, ord, "unknowndirection", "dirname", token);
     }
@@ -1604,6 +1632,13 @@ static void var_create_regions(arg_regions *dst, const region_list * begin, int
     }
 }
 
+static mt_handle mh_moveblockedbyguard = MT_HANDLE("moveblockedbyguard", "unit region guard");
+static mt_handle mh_detectocean = MT_HANDLE("detectocean", "unit region terrain");
+static mt_handle mh_enterfail = MT_HANDLE("enterfail", "unit region");
+static mt_handle mh_regionowned = MT_HANDLE("regionowned", "unit region target");
+static mt_handle mh_illusionantimagic = MT_HANDLE("illusionantimagic", "unit");
+static mt_handle mh_travel = MT_HANDLE("travel", "unit mode start end regions");
+
 static const region_list *travel_route(unit * u, const capacities *cap,
     const region_list * route_begin, const region_list * route_end, order * ord,
     int mode)
@@ -1624,8 +1659,7 @@ static const region_list *travel_route(unit * u, const capacities *cap,
             && mode != TRAVEL_TRANSPORTED) {
             unit *wache = bewegung_blockiert_von(u, current);
             if (wache != NULL) {
-                ADDMSG(&u->faction->msgs, msg_message("moveblockedbyguard",
-                    "unit region guard", u, current, wache));
+                ADDMSG(&u->faction->msgs, msg_handle(&mh_moveblockedbyguard, u, current, wache));
                 break;
             }
         }
@@ -1637,8 +1671,8 @@ static const region_list *travel_route(unit * u, const capacities *cap,
                 /* Ozeanfelder koennen nur von Einheiten mit Schwimmen und ohne
                  * Pferde betreten werden. */
                 if (!(canswim(u) || canfly(u))) {
-                    ADDMSG(&u->faction->msgs, msg_message("detectocean",
-                        "unit region terrain", u, next, terrain_name(next)));
+                    ADDMSG(&u->faction->msgs, msg_handle(&mh_detectocean,
+                        u, next, terrain_name(next)));
                     break;
                 }
             } else {
@@ -1656,14 +1690,14 @@ static const region_list *travel_route(unit * u, const capacities *cap,
                 }
                 else if ((u_race(u)->flags & RCF_WALK) == 0) {
                     /* Spezialeinheiten, die nicht laufen koennen. */
-                    ADDMSG(&u->faction->msgs, msg_message("detectocean",
-                        "unit region terrain", u, next, terrain_name(next)));
+                    ADDMSG(&u->faction->msgs, msg_handle(&mh_detectocean,
+                        u, next, terrain_name(next)));
                     break;
                 }
                 else if (landing) {
                     /* wir sind diese woche angelandet */
-                    ADDMSG(&u->faction->msgs, msg_message("detectocean",
-                        "unit region terrain", u, next, terrain_name(next)));
+                    ADDMSG(&u->faction->msgs, msg_handle(&mh_detectocean,
+                        u, next, terrain_name(next)));
                     break;
                 }
             }
@@ -1682,15 +1716,13 @@ static const region_list *travel_route(unit * u, const capacities *cap,
 
         /* movement blocked by a wall or curse */
         if (reldir >= 0 && move_blocked(u, current, next)) {
-            ADDMSG(&u->faction->msgs, msg_message("enterfail",
-                "unit region", u, next));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_enterfail, u, next));
             break;
         }
 
         /* region ownership only: region owned by enemies */
         if (!entrance_allowed(u, next)) {
-            ADDMSG(&u->faction->msgs, msg_message("regionowned",
-                "unit region target", u, current, next));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_regionowned, u, current, next));
             break;
         }
 
@@ -1699,7 +1731,7 @@ static const region_list *travel_route(unit * u, const capacities *cap,
             curse *c = get_curse(next->attribs, &ct_antimagiczone);
             if (curse_active(c)) {
                 curse_changevigour(&next->attribs, c, (float)-u->number);
-                ADDMSG(&u->faction->msgs, msg_message("illusionantimagic", "unit", u));
+                ADDMSG(&u->faction->msgs, msg_handle(&mh_illusionantimagic, u));
                 set_number(u, 0);
                 break;
             }
@@ -1707,16 +1739,14 @@ static const region_list *travel_route(unit * u, const capacities *cap,
 
         /* terrain is marked as forbidden (curse, etc) */
         if (fval(next, RF_BLOCKED) || fval(next->terrain, FORBIDDEN_REGION)) {
-            ADDMSG(&u->faction->msgs, msg_message("detectforbidden",
-                "unit region", u, next));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_detectforbidden, u, next));
             break;
         }
 
         /* unit is an insect and cannot move into a glacier */
         if (u_race(u) == get_race(RC_INSECT)) {
             if (r_insectstalled(next) && is_freezing(u)) {
-                ADDMSG(&u->faction->msgs, msg_message("detectforbidden",
-                    "unit region", u, next));
+                ADDMSG(&u->faction->msgs, msg_handle(&mh_detectforbidden, u, next));
                 break;
             }
         }
@@ -1767,8 +1797,7 @@ static const region_list *travel_route(unit * u, const capacities *cap,
                 arp = &ar;
                 var_create_regions(arp, route_begin, steps - 1);
             }
-            ADDMSG(&u->faction->msgs, msg_message("travel",
-                "unit mode start end regions", u, walkmode, r, current, arp));
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_travel, u, walkmode, r, current, arp));
         }
 
         mark_travelthru(u, r, route_begin, iroute);
@@ -1851,6 +1880,8 @@ bool can_takeoff(const ship * sh, const region * from, const region * to)
     return true;
 }
 
+static mt_handle mh_harbor_trade = MT_HANDLE("harbor_trade", "unit items ship");
+
 void harbour_taxes(region *r, unit *captain, unit *harbourmaster)
 {
     item *itm;
@@ -1880,7 +1911,7 @@ void harbour_taxes(region *r, unit *captain, unit *harbourmaster)
     }
     if (trans) {
         message *msg =
-            msg_message("harbor_trade", "unit items ship", harbourmaster, trans,
+            msg_handle(&mh_harbor_trade, harbourmaster, trans,
                 sh);
         add_message(&captain->faction->msgs, msg);
         add_message(&harbourmaster->faction->msgs, msg);
@@ -1890,6 +1921,13 @@ void harbour_taxes(region *r, unit *captain, unit *harbourmaster)
     }
 }
 
+static mt_handle mh_sailforbidden = MT_HANDLE("sailforbidden", "ship region");
+static mt_handle mh_storm = MT_HANDLE("storm", "ship region sink");
+static mt_handle mh_shipnoshore = MT_HANDLE("shipnoshore", "ship region");
+static mt_handle mh_sailfail = MT_HANDLE("sailfail", "ship region");
+static mt_handle mh_shipfly = MT_HANDLE("shipfly", "ship from to");
+static mt_handle mh_shipsail = MT_HANDLE("shipsail", "ship from to");
+
 static void sail(unit * u, order * ord, bool drifting)
 {
     region_list *route = NULL;
@@ -1902,9 +1940,12 @@ static void sail(unit * u, order * ord, bool drifting)
     region *next_point = NULL;
     int error;
     int reason = SA_DENIED;
-    bool storms_enabled = drifting && (config_get_int("rules.ship.storms", 1) != 0);
-    double damage_storm = storms_enabled ? config_get_flt("rules.ship.damage_storm", 0.02) : 0.0;
-    int lighthouse_div = config_get_int("rules.storm.lighthouse.divisor", 0);
+    static config_int storms_rule = CONFIG_INT("rules.ship.storms", 1);
+    static config_flt storm_damage = CONFIG_FLT("rules.ship.damage_storm", 0.02);
+    static config_int lighthouse_divisor = CONFIG_INT("rules.storm.lighthouse.divisor", 0);
+    bool storms_enabled = drifting && (config_int_get(&storms_rule) != 0);
+    double damage_storm = storms_enabled ? config_flt_get(&storm_damage) : 0.0;
+    int lighthouse_div = config_int_get(&lighthouse_divisor);
     const char *token = getstrtoken();
     building *harbour = NULL;
 
@@ -1944,8 +1985,7 @@ static void sail(unit * u, order * ord, bool drifting)
         assert(sh == u->ship || !"ship has sunk, but we didn't notice it");
 
         if (fval(next_point->terrain, FORBIDDEN_REGION) || fval(next_point, RF_BLOCKED)) {
-            ADDMSG(&f->msgs, msg_message("sailforbidden",
-                "ship region", sh, next_point));
+            ADDMSG(&f->msgs, msg_handle(&mh_sailforbidden, sh, next_point));
             break;
         }
 
@@ -1991,7 +2031,7 @@ static void sail(unit * u, order * ord, bool drifting)
                             }
                         }
                         if (storm && rnext != NULL) {
-                            ADDMSG(&f->msgs, msg_message("storm", "ship region sink",
+                            ADDMSG(&f->msgs, msg_handle(&mh_storm,
                                 sh, next_point, ship_damage_percent(sh) >= 100));
 
                             damage_ship(sh, damage_storm);
@@ -2010,8 +2050,7 @@ static void sail(unit * u, order * ord, bool drifting)
             if (!fval(tthis, SEA_REGION)) {
                 if (!fval(tnext, SEA_REGION)) {
                     /* check that you're not traveling from one land region to another. */
-                    ADDMSG(&u->faction->msgs, msg_message("shipnoshore",
-                        "ship region", sh, next_point));
+                    ADDMSG(&u->faction->msgs, msg_handle(&mh_shipnoshore, sh, next_point));
                     break;
                 }
                 else {
@@ -2059,7 +2098,7 @@ static void sail(unit * u, order * ord, bool drifting)
         /* !flying_ship */
         /* Falls Blockade, endet die Seglerei hier */
         if (move_blocked(u, current_point, next_point)) {
-            ADDMSG(&u->faction->msgs, msg_message("sailfail", "ship region", sh,
+            ADDMSG(&u->faction->msgs, msg_handle(&mh_sailfail, sh,
                 current_point));
             break;
         }
@@ -2094,7 +2133,7 @@ static void sail(unit * u, order * ord, bool drifting)
 
     if (ship_damage_percent(sh) >= 100) {
         if (sh->region) {
-            ADDMSG(&f->msgs, msg_message("shipsink", "ship", sh));
+            ADDMSG(&f->msgs, msg_handle(&mh_shipsink, sh));
             sink_ship(sh);
             remove_ship(&sh->region->ships, sh);
         }
@@ -2118,11 +2157,11 @@ static void sail(unit * u, order * ord, bool drifting)
         }
         if (route) {
             if (is_cursed(sh->attribs, &ct_flyingship)) {
-                ADDMSG(&f->msgs, msg_message("shipfly", "ship from to", sh,
+                ADDMSG(&f->msgs, msg_handle(&mh_shipfly, sh,
                     starting_point, current_point));
             }
             else {
-                ADDMSG(&f->msgs, msg_message("shipsail", "ship from to", sh,
+                ADDMSG(&f->msgs, msg_handle(&mh_shipsail, sh,
                     starting_point, current_point));
             }
 
@@ -2152,6 +2191,8 @@ static void sail(unit * u, order * ord, bool drifting)
     free_regionlist(route);
 }
 
+static mt_handle mh_transport = MT_HANDLE("transport", "unit target start end");
+
 /* Segeln, Wandern, Reiten
 * when this routine returns a non-zero value, movement for the region needs
 * to be done again because of followers that got new MOVE orders.
@@ -2231,8 +2272,8 @@ static const region_list *travel_i(unit * u, const region_list * route_begin,
                             if (route_to != route_begin) {
                                 get_followers(ut, r, route_to, followers);
                             }
-                            ADDMSG(&ut->faction->msgs, msg_message("transport",
-                                "unit target start end", u, ut, r, ut->region));
+                            ADDMSG(&ut->faction->msgs, msg_handle(&mh_transport,
+                                u, ut, r, ut->region));
                             found = true;
                         }
                     }
@@ -2683,6 +2724,8 @@ void movement(void)
     move_pirates();
 }
 
+static mt_handle mh_unitnotfound_id = MT_HANDLE("unitnotfound_id", "unit region command id");
+
 /**
  * Override long orders with a FOLLOW order if target seems to be moving.
  */
@@ -2713,7 +2756,7 @@ void follow_cmds(unit * u)
                 }
                 id = read_unitid(u->faction, r);
                 if (id == u->no) {
-                    ADDMSG(&u->faction->msgs, msg_message("followfail", "unit follower",
+                    ADDMSG(&u->faction->msgs, msg_handle(&mh_followfail,
                         u, u));
                     continue;
                 }
@@ -2721,8 +2764,8 @@ void follow_cmds(unit * u)
                 if (id > 0) {
                     u2 = findunit(id);
                     if (!u2 || u2->region != r || !cansee(u->faction, r, u2, 0)) {
-                        ADDMSG(&u->faction->msgs, msg_message("unitnotfound_id",
-                            "unit region command id", u, r, ord, itoa36(id)));
+                        ADDMSG(&u->faction->msgs, msg_handle(&mh_unitnotfound_id,
+                            u, r, ord, itoa36(id)));
                         return;
                     }
 
@@ -65,6 +65,7 @@
 #include <util/language.h>
 #include <util/lists.h>
 #include <util/log.h>
+#include <util/macros.h>
 #include <util/message.h>
 #include <util/nrmessage.h>
 #include "util/param.h"
@@ -102,7 +103,7 @@ extern int months_per_year;
 
 static char *gamedate_season(const struct locale *lang)
 {
-    static char buf[256]; /* FIXME: static return value */
+    static THREAD_LOCAL char buf[256]; /* FIXME: static return value */
     gamedate gd;
 
     assert(weeknames);
@@ -893,7 +894,7 @@ static void report_roads(sbstring *sbs, const region *r, const faction* f, const
     }
 }
 
-static void report_region_description(struct stream *out, const region * r, faction * f, const bool see[])
+static void report_region_description(struct stream *out, const region * r, faction * f, seen_mode mode, const bool see[])
 {
     int n;
     int trees;
@@ -905,18 +906,18 @@ static void report_region_description(struct stream *out, const region * r, fact
     f_regionid(r, f, buf, sizeof(buf));
     sbs_adopt(&sbs, buf, sizeof(buf));
 
-    if (r->seen.mode == seen_travel) {
+    if (mode == seen_travel) {
         sbs_strcat(&sbs, " (");
         sbs_strcat(&sbs, LOC(f->locale, "see_travel"));
         sbs_strcat(&sbs, ")");
     }
-    else if (r->seen.mode == seen_neighbour) {
+    else if (mode == seen_neighbour) {
         sbs_strcat(&sbs, " (");
         sbs_strcat(&sbs, LOC(f->locale, "see_neighbour"));
         sbs_strcat(&sbs, ")");
     }
-    else if ((r->seen.mode == seen_lighthouse)
-        || (r->seen.mode == seen_lighthouse_land)) {
+    else if ((mode == seen_lighthouse)
+        || (mode == seen_lighthouse_land)) {
         sbs_strcat(&sbs, " (");
         sbs_strcat(&sbs, LOC(f->locale, "see_lighthouse"));
         sbs_strcat(&sbs, ")");
@@ -958,9 +959,9 @@ static void report_region_description(struct stream *out, const region * r, fact
     pump_paragraph(&sbs, out, REPORTWIDTH, false);
 
     /* iron & stone */
-    if (r->seen.mode >= seen_unit) {
+    if (mode >= seen_unit) {
         resource_report result[MAX_RAWMATERIALS];
-        int numresults = report_resources(r, result, f, r->seen.mode);
+        int numresults = report_resources(r, result, f, mode);
 
         for (n = 0; n < numresults; ++n) {
             if (result[n].number >= 0 && result[n].level >= 0) {
@@ -995,7 +996,7 @@ static void report_region_description(struct stream *out, const region * r, fact
             sbs_strcat(&sbs, LOC(f->locale, "nr_mourning"));
         }
     }
-    if (r->seen.mode >= seen_travel) {
+    if (mode >= seen_travel) {
         report_region_resource(&sbs, f->locale, get_resourcetype(R_SILVER), rmoney(r));
         /* Pferde */
         report_region_resource(&sbs, f->locale, get_resourcetype(R_HORSE), rhorses(r));
@@ -1102,7 +1103,7 @@ static void report_region_schemes(struct stream *out, const region * r, faction
     }
 }
 
-void report_region(struct stream *out, const region * r, faction * f)
+void report_region(struct stream *out, const region * r, faction * f, seen_mode mode)
 {
     int d, ne = 0;
     bool see[MAXDIRECTIONS];
@@ -1153,14 +1154,14 @@ void report_region(struct stream *out, const region * r, faction * f)
         }
     }
 
-    report_region_description(out, r, f, see);
-    if (see_schemes(r, r->seen.mode)) {
+    report_region_description(out, r, f, mode, see);
+    if (see_schemes(r, mode)) {
         report_region_schemes(out, r, f);
     }
     report_region_edges(out, r, f, edges, ne);
 }
 
-static void report_statistics(struct stream *out, const region * r, const faction * f)
+static void report_statistics(struct stream *out, const region * r, const faction * f, seen_mode mode)
 {
     int p = rpeasants(r);
     message *m;
@@ -1213,7 +1214,7 @@ static void report_statistics(struct stream *out, const region * r, const factio
     }
 
     /* info about units */
-    if (r->seen.mode >= seen_unit) {
+    if (mode >= seen_unit) {
         int number;
         item *itm, *items = NULL;
         unit *u;
@@ -1319,9 +1320,6 @@ int write_template(const char* filename, const char* bom, const faction* f, cons
         unit* u;
         int dh = 0;
 
-        if (r->seen.mode < seen_unit)
-            continue;
-
         for (u = r->units; u; u = u->next) {
             if (u->faction == f) {
                 const order* ord;
@@ -1578,7 +1576,7 @@ void report_allies(struct stream *out, size_t maxlen, const struct faction * f,
 
 static void rpline(struct stream *out)
 {
-    static char line[REPORTWIDTH + 1];
+    static THREAD_LOCAL char line[REPORTWIDTH + 1];
     if (line[0] != '-') {
         memset(line, '-', sizeof(line));
         line[REPORTWIDTH] = '\n';
@@ -2143,16 +2141,17 @@ report_plaintext(const char *filename, report_context * ctx,
     anyunits = 0;
 
     for (r = ctx->first; r != ctx->last; r = r->next) {
-        int stealthmod = stealth_modifier(r, f, r->seen.mode);
+        seen_mode mode = report_seen(ctx, r);
+        int stealthmod = stealth_modifier(r, f, mode);
         ship *sh = r->ships;
 
-        if (r->seen.mode >= seen_lighthouse_land) {
+        if (mode >= seen_lighthouse_land) {
             rpline(out);
             newline(out);
-            report_region(out, r, f);
+            report_region(out, r, f, mode);
         }
 
-        if (r->seen.mode >= seen_unit) {
+        if (mode >= seen_unit) {
             anyunits = 1;
             if (markets_module() && r->land) {
                 report_market(out, r, f);
@@ -2163,15 +2162,15 @@ report_plaintext(const char *filename, report_context * ctx,
             report_guards(out, r, f);
             report_travelthru(out, r, f);
             if (wants_stats) {
-                report_statistics(out, r, f);
+                report_statistics(out, r, f, mode);
             }
         }
-        else if (r->seen.mode >= seen_lighthouse) {
+        else if (mode >= seen_lighthouse) {
             report_travelthru(out, r, f);
         }
 
         /* Nachrichten an REGION in der Region */
-        if (r->seen.mode >= seen_lighthouse) {
+        if (mode >= seen_lighthouse) {
             message_list *mlist = r_getmessages(r, f);
             if (mlist) {
                 struct mlist **split = merge_messages(mlist, r->msgs);
@@ -2186,7 +2185,7 @@ report_plaintext(const char *filename, report_context * ctx,
 
             /* report all units. they are pre-sorted in an efficient manner */
             u = r->units;
-            if (r->seen.mode >= seen_travel) {
+            if (mode >= seen_travel) {
                 building *b = r->buildings;
                 while (b) {
                     while (b && (!u || u->building != b)) {
@@ -2196,8 +2195,8 @@ report_plaintext(const char *filename, report_context * ctx,
                     if (b) {
                         nr_building(out, r, b, f);
                         while (u && u->building == b) {
-                            if (visible_unit(u, f, stealthmod, r->seen.mode)) {
-                                nr_unit(out, f, u, 6, r->seen.mode);
+                            if (visible_unit(u, f, stealthmod, mode)) {
+                                nr_unit(out, f, u, 6, mode);
                             }
                             u = u->next;
                         }
@@ -2210,8 +2209,8 @@ report_plaintext(const char *filename, report_context * ctx,
                 u = u->next;
             }
             while (u && !u->ship) {
-                if (visible_unit(u, f, stealthmod, r->seen.mode)) {
-                    nr_unit(out, f, u, 4, r->seen.mode);
+                if (visible_unit(u, f, stealthmod, mode)) {
+                    nr_unit(out, f, u, 4, mode);
                 }
                 assert(!u->building);
                 u = u->next;
@@ -2224,8 +2223,8 @@ report_plaintext(const char *filename, report_context * ctx,
                 if (sh) {
                     nr_ship(out, r, sh, f, u);
                     while (u && u->ship == sh) {
-                        if (visible_unit(u, f, stealthmod, r->seen.mode)) {
-                            nr_unit(out, f, u, 6, r->seen.mode);
+                        if (visible_unit(u, f, stealthmod, mode)) {
+                            nr_unit(out, f, u, 6, mode);
                         }
                         u = u->next;
                     }
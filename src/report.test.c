@@ -108,8 +108,7 @@ static void test_report_region(CuTest *tc) {
     set_level(u, SK_QUARRYING, 1);
 
     region_setname(r, "1234567890123456789012345678901234567890");
-    r->seen.mode = seen_travel;
-    report_region(&out, r, f);
+    report_region(&out, r, f, seen_travel);
     out.api->write(out.handle, "", 1);
     out.api->rewind(out.handle);
     CuAssertIntEquals(tc, EOF, out.api->read(out.handle, buf, sizeof(buf)));
@@ -117,8 +116,7 @@ static void test_report_region(CuTest *tc) {
 
     out.api->rewind(out.handle);
     region_setname(r, "12345678901234567890123456789012345678901234567890123456789012345678901234567890");
-    r->seen.mode = seen_travel;
-    report_region(&out, r, f);
+    report_region(&out, r, f, seen_travel);
     out.api->write(out.handle, "", 1);
     out.api->rewind(out.handle);
     CuAssertIntEquals(tc, EOF, out.api->read(out.handle, buf, sizeof(buf)));
@@ -126,16 +124,14 @@ static void test_report_region(CuTest *tc) {
 
     out.api->rewind(out.handle);
     region_setname(r, "Hodor");
-    r->seen.mode = seen_travel;
-    report_region(&out, r, f);
+    report_region(&out, r, f, seen_travel);
     out.api->write(out.handle, "", 1);
     out.api->rewind(out.handle);
     CuAssertIntEquals(tc, EOF, out.api->read(out.handle, buf, sizeof(buf)));
     CuAssertStrEquals(tc, "Hodor (0,0) (durchgereist), Ebene, 3/2 Blumen, 5 Bauern, 2 Silber, 7 Pferde.\n", buf);
 
     out.api->rewind(out.handle);
-    r->seen.mode = seen_unit;
-    report_region(&out, r, f);
+    report_region(&out, r, f, seen_unit);
     out.api->write(out.handle, "", 1);
     out.api->rewind(out.handle);
     CuAssertIntEquals(tc, EOF, out.api->read(out.handle, buf, sizeof(buf)));
@@ -146,8 +142,7 @@ static void test_report_region(CuTest *tc) {
     r->land->peasants = 1;
     r->land->horses = 1;
     r->land->money = 1;
-    r->seen.mode = seen_unit;
-    report_region(&out, r, f);
+    report_region(&out, r, f, seen_unit);
     out.api->write(out.handle, "", 1);
     out.api->rewind(out.handle);
     CuAssertIntEquals(tc, EOF, out.api->read(out.handle, buf, sizeof(buf)));
@@ -161,7 +156,7 @@ static void test_report_region(CuTest *tc) {
     rsettrees(r, 2, 0);
 
     out.api->rewind(out.handle);
-    report_region(&out, r, f);
+    report_region(&out, r, f, seen_unit);
     out.api->write(out.handle, "", 1);
     out.api->rewind(out.handle);
     CuAssertIntEquals(tc, EOF, out.api->read(out.handle, buf, sizeof(buf)));
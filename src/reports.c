@@ -58,9 +58,11 @@
 #include "util/log.h"
 #include "util/macros.h"
 #include "util/message.h"
+#include "util/nrmessage.h"
 #include "util/path.h"
 #include "util/password.h"
 #include "util/translation.h"
+#include "util/workers.h"
 
 #include <selist.h>
 #include <stream.h>
@@ -120,7 +122,7 @@ const char *options[MAXOPTIONS] = {
     "DEBUG",
     "ZIPPED",
     "ZEITUNG",                    /* Option hat Sonderbehandlung! */
-    NULL,
+    "CRDELTA",
     "ADRESSEN",
     "BZIP2",
     "PUNKTE",
@@ -140,8 +142,8 @@ bool omniscient(const faction *f)
 static char *groupid(const struct group *g, const struct faction *f)
 {
     typedef char name[OBJECTIDSIZE + 1];
-    static name idbuf[8];
-    static int nextbuf = 0;
+    static THREAD_LOCAL name idbuf[8];
+    static THREAD_LOCAL int nextbuf = 0;
     char *buf = idbuf[(++nextbuf) % 8];
     sprintf(buf, "%s (%s)", g->name, itoa36(f->no));
     return buf;
@@ -971,7 +973,7 @@ void bufunit_depr(const faction * f, const unit * u, enum seen_mode mode,
 void split_paragraph(strlist ** SP, const char *s, unsigned int indent, unsigned int width, char mark)
 {
     bool firstline;
-    static char buf[REPORTWIDTH + 1]; /* FIXME: static buffer, artificial limit */
+    static THREAD_LOCAL char buf[REPORTWIDTH + 1]; /* FIXME: static buffer, artificial limit */
     size_t len = strlen(s);
 
     assert(width <= REPORTWIDTH);
@@ -1132,13 +1134,14 @@ void get_addresses(report_context * ctx)
 
     /* find the first region that this faction can see */
     for (r = ctx->first; r != ctx->last; r = r->next) {
-        if (r->seen.mode > seen_none) break;
+        if (report_seen(ctx, r) > seen_none) break;
     }
 
     for (; r != NULL; r = r->next) {
-        if (r->seen.mode >= seen_lighthouse) {
-            int stealthmod = stealth_modifier(r, ctx->f, r->seen.mode);
-            if (r->seen.mode == seen_lighthouse) {
+        seen_mode mode = report_seen(ctx, r);
+        if (mode >= seen_lighthouse) {
+            int stealthmod = stealth_modifier(r, ctx->f, mode);
+            if (mode == seen_lighthouse) {
                 unit *u = r->units;
                 for (; u; u = u->next) {
                     faction *sf = visible_faction(ctx->f, u, get_otherfaction(u));
@@ -1152,12 +1155,12 @@ void get_addresses(report_context * ctx)
                     }
                 }
             }
-            else if (r->seen.mode == seen_travel) {
+            else if (mode == seen_travel) {
                 /* when we travel through a region, then we must add
                  * the factions of any units we saw */
                 add_travelthru_addresses(r, ctx->f, &flist, stealthmod);
             }
-            else if (r->seen.mode > seen_travel) {
+            else if (mode > seen_travel) {
                 const unit *u = r->units;
                 while (u != NULL) {
                     if (u->faction != ctx->f) {
@@ -1195,15 +1198,37 @@ typedef struct report_type {
 
 static report_type *report_types;
 
+/* report types are kept in the order of their option bits, whatever
+ * order they are registered in. The delta CR is written from the CR,
+ * and must come after it. */
 void register_reporttype(const char *extension, report_fun write, int flag)
 {
+    report_type **rtp = &report_types;
     report_type *type = (report_type *)malloc(sizeof(report_type));
     if (!type) abort();
     type->extension = extension;
     type->write = write;
     type->flag = flag;
-    type->next = report_types;
-    report_types = type;
+    while (*rtp && (*rtp)->flag < flag) {
+        rtp = &(*rtp)->next;
+    }
+    type->next = *rtp;
+    *rtp = type;
+}
+
+void unregister_reporttype(const char *extension)
+{
+    report_type **rtp = &report_types;
+    while (*rtp) {
+        report_type *rt = *rtp;
+        if (strcmp(rt->extension, extension) == 0) {
+            *rtp = rt->next;
+            free(rt);
+        }
+        else {
+            rtp = &rt->next;
+        }
+    }
 }
 
 void reports_done(void) {
@@ -1215,93 +1240,87 @@ void reports_done(void) {
     }
 }
 
-size_t get_regions_distance_arr(region *rc, int radius, region *result[], size_t size)
+struct region_array {
+    region **result;
+    size_t size, len;
+};
+
+static void cb_region_array(region *r, void *cbdata)
 {
-    size_t n = 1, i;
-
-    if (size > 0) {
-        result[0] = rc;
-        fset(rc, RF_MARK);
-    }
-    for (i = 0; i != n; ++i) {
-        region *r;
-        int dist;
-
-        r = result[i];
-        dist = distance(rc, r);
-        if (dist < radius) {
-            region *adj[MAXDIRECTIONS];
-            int d;
-
-            get_neighbours(r, adj);
-            for (d = 0; d != MAXDIRECTIONS; ++d) {
-                r = adj[d];
-                if (r) {
-                    if (size > n) {
-                        if (!fval(r, RF_MARK) && dist < distance(rc, r)) {
-                            result[n++] = r;
-                            fset(r, RF_MARK);
-                        }
-                    }
-                    else {
-                        return -1;
-                    }
-                }
-            }
-        }
+    struct region_array *arr = (struct region_array *)cbdata;
+    if (arr->len < arr->size) {
+        arr->result[arr->len] = r;
     }
-    for (i = 0; i != n; ++i) {
-        freset(result[i], RF_MARK);
+    ++arr->len;
+}
+
+/* the regions are ordered by distance, starting with rc */
+size_t get_regions_distance_arr(region *rc, int radius, region *result[], size_t size)
+{
+    struct region_array arr;
+    int k;
+
+    arr.result = result;
+    arr.size = size;
+    arr.len = 0;
+    for (k = 0; k <= radius; ++k) {
+        regions_in_ring(rc, k, cb_region_array, &arr);
     }
-    return n;
+    return (arr.len > size) ? (size_t)-1 : arr.len;
+}
+
+static void cb_region_push(region *r, void *cbdata)
+{
+    region ***arr = (region ***)cbdata;
+    arrpush(*arr, r);
 }
 
 region **get_regions_distance(region * root, int radius)
 {
-    region** arr = NULL;
-    ptrdiff_t qi;
+    region **arr = NULL;
+    int k;
 
-    arrpush(arr, root);
-    fset(root, RF_MARK);
+    for (k = 0; k <= radius; ++k) {
+        regions_in_ring(root, k, cb_region_push, &arr);
+    }
+    return arr;
+}
 
-    for (qi = 0; qi != arrlen(arr); ++qi) {
-        region *r = arr[qi];
-        region *next[MAXDIRECTIONS];
-        int d;
-        get_neighbours(r, next);
+struct seen_region {
+    unsigned int key;
+    seen_mode value;
+};
 
-        for (d = 0; d != MAXDIRECTIONS; ++d) {
-            if (next[d] && !fval(next[d], RF_MARK) && distance(next[d], root) <= radius) {
-                r = next[d];
-                arrpush(arr, r);
-                fset(r, RF_MARK);
-            }
+seen_mode report_seen(const report_context *ctx, const region *r)
+{
+    struct seen_region *seen = ctx->seen;
+    if (seen) {
+        ptrdiff_t i = hmgeti(seen, r->index);
+        if (i >= 0) {
+            return seen[i].value;
         }
     }
-    for (qi = arrlen(arr); qi > 0; --qi) {
-        region *r = arr[qi - 1];
-        freset(r, RF_MARK);
-    }
-    return arr;
+    return seen_none;
 }
 
-static void add_seen(region *r, seen_mode mode) {
-    if (r->seen.mode < mode) {
-        r->seen.mode = mode;
+static void add_seen(report_context *ctx, region *r, seen_mode mode) {
+    if (report_seen(ctx, r) < mode) {
+        hmput(ctx->seen, r->index, mode);
     }
 }
 
-static void add_seen_nb(faction *f, region *r, seen_mode mode) {
+static void add_seen_nb(report_context *ctx, region *r, seen_mode mode) {
+    faction *f = ctx->f;
     region *first = r, *last = r;
-    add_seen(r, mode);
+    add_seen(ctx, r, mode);
     if (mode > seen_neighbour) {
         region *next[MAXDIRECTIONS];
         int d;
         get_neighbours(r, next);
         for (d = 0; d != MAXDIRECTIONS; ++d) {
             region *rn = next[d];
-            if (rn && rn->seen.mode < seen_neighbour) {
-                rn->seen.mode = seen_neighbour;
+            if (rn && report_seen(ctx, rn) < seen_neighbour) {
+                hmput(ctx->seen, rn->index, seen_neighbour);
                 if (first->index > rn->index) first = rn;
                 if (last->index < rn->index) last = rn;
             }
@@ -1311,39 +1330,24 @@ static void add_seen_nb(faction *f, region *r, seen_mode mode) {
     update_interval(f, last);
 }
 
-static void add_seen_lighthouse(region *r, faction *f)
+static void add_seen_lighthouse(report_context *ctx, region *r)
 {
     if (r->terrain->flags & SEA_REGION) {
-        add_seen_nb(f, r, seen_lighthouse);
+        add_seen_nb(ctx, r, seen_lighthouse);
     }
     else {
-        add_seen_nb(f, r, seen_lighthouse_land);
+        add_seen_nb(ctx, r, seen_lighthouse_land);
     }
 }
 
-static void add_seen_from_lighthouses(faction* f, region** arr, size_t len)
+static void cb_add_seen_lighthouse(region *r, void *cbdata)
 {
-    size_t i;
-    for (i = 0; i != len; ++i) {
-        add_seen_lighthouse(arr[i], f);
-    }
+    add_seen_lighthouse((report_context *)cbdata, r);
 }
 
-static void prepare_lighthouse(faction *f, region *r, int range)
+static void prepare_lighthouse(report_context *ctx, region *r, int range)
 {
-    if (range > 3) {
-        region ** arr = get_regions_distance(r, range);
-        add_seen_from_lighthouses(f, arr, arrlenu(arr));
-        arrfree(arr);
-    }
-    else {
-        region *result[64];
-        size_t n;
-
-        n = get_regions_distance_arr(r, range, result, 64);
-        assert(n > 0 && n <= 64);
-        add_seen_from_lighthouses(f, result, n);
-    }
+    regions_in_radius(r, range, cb_add_seen_lighthouse, ctx);
 }
 
 static region *lastregion(faction * f)
@@ -1367,9 +1371,9 @@ static region *firstregion(faction * f)
 }
 
 static void cb_add_seen(region *r, const unit *u, void *cbdata) {
-    faction *f = (faction *)cbdata;
-    if (u->faction == f) {
-        add_seen_nb(f, r, seen_travel);
+    report_context *ctx = (report_context *)cbdata;
+    if (u->faction == ctx->f) {
+        add_seen_nb(ctx, r, seen_travel);
     }
 }
 
@@ -1402,7 +1406,7 @@ void report_warnings(faction *f, int now)
     }
 }
 
-/** set region.seen based on visibility by one faction.
+/** set ctx->seen based on visibility by one faction.
  *
  * this function may also update ctx->last and ctx->first for potential
  * lighthouses and travelthru reports
@@ -1410,19 +1414,19 @@ void report_warnings(faction *f, int now)
 void prepare_report(report_context *ctx, faction *f, const char *password)
 {
     region *r;
-    static int config;
-    static bool rule_region_owners;
-    static bool rule_lighthouse_units;
+    bool rule_region_owners = false;
+    bool rule_lighthouse_units = false;
     const struct building_type *bt_lighthouse = bt_find("lighthouse");
 
     /* Insekten-Winter-Warnung */
     report_warnings(f, turn);
 
-    if (bt_lighthouse && config_changed(&config)) {
+    if (bt_lighthouse) {
         rule_region_owners = config_token("rules.region_owner_pay_building", bt_lighthouse->_name);
         rule_lighthouse_units = config_get_int("rules.lighthouse.unit_capacity", 0) != 0;
     }
 
+    ctx->seen = NULL;
     ctx->password = password;
     ctx->f = f;
     ctx->report_time = time(NULL);
@@ -1440,7 +1444,7 @@ void prepare_report(report_context *ctx, faction *f, const char *password)
             if (fval(r, RF_OBSERVER)) {
                 int skill = get_observer(r, f);
                 if (skill >= 0) {
-                    add_seen_nb(f, r, seen_spell);
+                    add_seen_nb(ctx, r, seen_spell);
                 }
             }
             if (fval(r, RF_LIGHTHOUSE)) {
@@ -1460,7 +1464,7 @@ void prepare_report(report_context *ctx, faction *f, const char *password)
             for (u = r->units; u; u = u->next) {
                 /* if we have any unit in this region, then we get seen_unit access */
                 if (u->faction == f) {
-                    add_seen_nb(f, r, seen_unit);
+                    add_seen_nb(ctx, r, seen_unit);
                     /* units inside the lighthouse get range based on their perception
                      * or the size, if perception is not a skill
                      */
@@ -1492,11 +1496,11 @@ void prepare_report(report_context *ctx, faction *f, const char *password)
             }
             if (range > 0) {
                 /* we are in at least one lighthouse. add the regions we can see from here! */
-                prepare_lighthouse(f, r, range);
+                prepare_lighthouse(ctx, r, range);
             }
 
-            if (fval(r, RF_TRAVELUNIT) && r->seen.mode < seen_travel) {
-                travelthru_map(r, cb_add_seen, f);
+            if (fval(r, RF_TRAVELUNIT) && report_seen(ctx, r) < seen_travel) {
+                travelthru_map(r, cb_add_seen, ctx);
             }
         }
     }
@@ -1508,11 +1512,8 @@ void prepare_report(report_context *ctx, faction *f, const char *password)
 }
 
 void finish_reports(report_context *ctx) {
-    region *r;
     selist_free(ctx->addresses);
-    for (r = ctx->first; r != ctx->last; r = r->next) {
-        r->seen.mode = seen_none;
-    }
+    hmfree(ctx->seen);
 }
 
 int write_reports(faction * f, int options, const char *password)
@@ -1605,12 +1606,27 @@ int init_reports(void)
     return 0;
 }
 
+typedef struct report_job {
+    faction *f;
+    bool newpassword;
+    char password[PASSWORD_MAXSIZE];
+    int error;
+} report_job;
+
+static void write_reports_job(int index, void *udata)
+{
+    report_job *job = (report_job *)udata + index;
+    job->error = write_reports(job->f, job->f->options,
+        job->newpassword ? job->password : NULL);
+}
+
 int reports(const char *filename)
 {
     faction *f;
     FILE *mailit = NULL;
     int retval = 0;
-    char buffer[PASSWORD_MAXSIZE];
+    report_job *jobs = NULL;
+    ptrdiff_t i, njobs;
 
     log_info("Writing reports for turn %d:", turn);
     report_donations();
@@ -1623,21 +1639,42 @@ int reports(const char *filename)
         }
     }
 
+    /* new passwords change the faction, so they are made before any
+     * reports are written */
     for (f = factions; f; f = f->next) {
         if (f->email && !fval(f, FFL_NPC)) {
-            char* password = NULL;
+            report_job *job = arraddnptr(jobs, 1);
+            job->f = f;
+            job->newpassword = false;
+            job->error = 0;
             if (f->lastorders == 0 || faction_age(f) <= 1) {
                 /* neue Parteien, oder solche die noch NIE einen Zug gemacht haben,
                  * kriegen ein neues Passwort: */
-                password = faction_genpassword(f, buffer);
+                faction_genpassword(f, job->password);
+                job->newpassword = true;
             }
-            int error = write_reports(f, f->options, password);
-            if (error)
-                retval = error;
-            if (mailit)
-                write_script(mailit, f);
         }
     }
+    njobs = arrlen(jobs);
+    config_threads();
+    nrt_compile();
+    cansee_cache_begin();
+    effskill_memo_begin();
+    if (njobs > 0) {
+        /* the first report is written on this thread, so the lazily
+         * initialized rule caches are set up before the workers start */
+        write_reports_job(0, jobs);
+        workers_run((int)njobs - 1, write_reports_job, jobs + 1);
+    }
+    effskill_memo_end();
+    cansee_cache_end();
+    for (i = 0; i != njobs; ++i) {
+        if (jobs[i].error)
+            retval = jobs[i].error;
+        if (mailit)
+            write_script(mailit, jobs[i].f);
+    }
+    arrfree(jobs);
     if (mailit)
         fclose(mailit);
     return retval;
@@ -1739,7 +1776,7 @@ static void var_free_regions(variant x) /*-V524 */
 const char *trailinto(const region * r, const struct locale *lang)
 {
     if (r) {
-        static char ref[32];
+        static THREAD_LOCAL char ref[32];
         const char *s;
         const char *tname = terrain_name(r);
         size_t sz;
@@ -1779,7 +1816,7 @@ f_regionid(const region * r, const faction * f, char *buffer, size_t size)
 
 static char *f_regionid_s(const region * r, const faction * f)
 {
-    static char buf[NAMESIZE + 20]; /* FIXME: static return value */
+    static THREAD_LOCAL char buf[NAMESIZE + 20]; /* FIXME: static return value */
 
     f_regionid(r, f, buf, sizeof(buf));
     return buf;
@@ -2153,7 +2190,7 @@ static void eval_regions(struct opstack **stack, const void *userdata)
 
 const char *get_mailcmd(const struct locale *loc)
 {
-    static char result[64]; /* FIXME: static return buffer */
+    static THREAD_LOCAL char result[64]; /* FIXME: static return buffer */
     snprintf(result, sizeof(result), "%s %d %s", game_mailcmd(), game_id(), LOC(loc, "mailcmd"));
     return result;
 }
@@ -2348,6 +2385,10 @@ void register_reports(void)
     register_argtype("resources", var_free_resources, var_copy_resources, VAR_VOIDPTR);
     register_argtype("items", var_free_resources, var_copy_items, VAR_VOIDPTR);
     register_argtype("regions", var_free_regions, var_copy_regions, VAR_VOIDPTR);
+    find_argtype("string")->flags = ARG_STRING;
+    /* region names are written in the coordinates of the viewer */
+    find_argtype("region")->flags = ARG_VIEWER;
+    find_argtype("regions")->flags = ARG_VIEWER;
 
     /* register functions that turn message contents to readable strings */
     add_function("alliance", &eval_alliance);
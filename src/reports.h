@@ -54,6 +54,12 @@ extern "C" {
 
     int stealth_modifier(const struct region *r, const struct faction *f, enum seen_mode mode);
 
+    /* Reports are written on the worker pool, one context per faction.
+     * Everything a writer learns about its faction's view of the world
+     * (regions it sees, addresses) lives in its own context, and the
+     * game data is only read while reports are written. report_seen
+     * looks the region up in a hash map that stb_ds writes to on every
+     * lookup, so a context must not be shared between threads. */
     typedef struct report_context {
         struct faction *f;
         struct selist *addresses;
@@ -61,6 +67,7 @@ extern "C" {
         void *userdata;
         time_t report_time;
         const char *password;
+        struct seen_region *seen; /* visibility of regions, by region index */
     } report_context;
 
     typedef struct output_context {
@@ -71,11 +78,13 @@ extern "C" {
     void prepare_report(report_context *ctx, struct faction *f, const char *password);
     void finish_reports(report_context *ctx);
     void get_addresses(report_context * ctx);
+    enum seen_mode report_seen(const report_context *ctx, const struct region *r);
 
     typedef int(*report_fun) (const char *filename, report_context * ctx,
         const char *charset);
     void register_reporttype(const char *extension, report_fun write,
         int flag);
+    void unregister_reporttype(const char *extension);
 
     void bufunit_depr(const struct faction *f, const struct unit *u, enum seen_mode mode,
         char *buf, size_t size);
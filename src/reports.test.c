@@ -34,7 +34,10 @@
 #include <CuTest.h>
 #include <tests.h>
 
+#include <assert.h>
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -447,6 +450,125 @@ static void test_arg_resources(CuTest *tc) {
     test_teardown();
 }
 
+#define SEEN_FACTIONS 4
+static char seen_text[SEEN_FACTIONS][1024];
+
+static void seen_printf(char *buf, const char *format, ...)
+{
+    size_t len = strlen(buf);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf + len, sizeof(seen_text[0]) - len, format, args);
+    va_end(args);
+}
+
+/* a report that lists what its faction sees, and whom it can write to */
+static int report_visibility(const char *filename, report_context *ctx, const char *bom)
+{
+    faction *f;
+    region *r;
+    char *buf;
+    int i = 0;
+
+    (void)filename;
+    (void)bom;
+    for (f = factions; f != ctx->f; f = f->next) {
+        ++i;
+    }
+    assert(i < SEEN_FACTIONS);
+    buf = seen_text[i];
+    buf[0] = '\0';
+    for (r = ctx->first; r != ctx->last; r = r->next) {
+        unit *u;
+        seen_printf(buf, "%d,%d:%d", r->x, r->y, (int)report_seen(ctx, r));
+        for (u = r->units; u; u = u->next) {
+            if (cansee(ctx->f, r, u, 0)) {
+                seen_printf(buf, " %d", u->no);
+            }
+        }
+        seen_printf(buf, ";");
+    }
+    seen_printf(buf, " %d", selist_length(ctx->addresses));
+    return 0;
+}
+
+static void setup_reports_threads(void)
+{
+    faction *f[SEEN_FACTIONS];
+    int i, x, y;
+
+    for (i = 0; i != SEEN_FACTIONS; ++i) {
+        f[i] = test_create_faction();
+        f[i]->options = 1 << O_DEBUG;
+    }
+    for (x = 0; x != 3; ++x) {
+        for (y = 0; y != 3; ++y) {
+            region *r = test_create_plain(x, y);
+            if ((x + y) % 2 == 0) {
+                test_create_unit(f[(x + 2 * y) % SEEN_FACTIONS], r);
+            }
+        }
+    }
+    memset(seen_text, 0, sizeof(seen_text));
+}
+
+static void write_seen_reports(void)
+{
+    register_reporttype("seen", report_visibility, 1 << O_DEBUG);
+    reports(NULL);
+    unregister_reporttype("seen");
+}
+
+static void seen_result(char *buf, size_t size)
+{
+    size_t len = 0;
+    int i;
+    for (i = 0; i != SEEN_FACTIONS && len < size; ++i) {
+        if (seen_text[i][0] != '\0') {
+            len += snprintf(buf + len, size - len, "%d[%s] ", i, seen_text[i]);
+        }
+    }
+    assert(len < size);
+}
+
+/* every report writer has its own view of the world, so the reports
+ * do not depend on the number of threads that write them */
+static void test_reports_threads(CuTest *tc) {
+    test_threads_agree(tc, setup_reports_threads, write_seen_reports, seen_result);
+}
+
+static char written[16];
+
+static int report_first(const char *filename, report_context *ctx, const char *bom)
+{
+    (void)filename; (void)ctx; (void)bom;
+    str_strlcpy(written + strlen(written), "1", sizeof(written) - strlen(written));
+    return 0;
+}
+
+static int report_second(const char *filename, report_context *ctx, const char *bom)
+{
+    (void)filename; (void)ctx; (void)bom;
+    str_strlcpy(written + strlen(written), "2", sizeof(written) - strlen(written));
+    return 0;
+}
+
+static void test_reporttype_order(CuTest *tc) {
+    faction *f;
+
+    test_setup();
+    f = test_create_faction();
+    /* types are written in the order of their option bits */
+    register_reporttype("second", report_second, 1 << O_DEBUG);
+    register_reporttype("first", report_first, 1 << O_REPORT);
+    written[0] = '\0';
+    write_reports(f, (1 << O_REPORT) | (1 << O_DEBUG), NULL);
+    unregister_reporttype("first");
+    unregister_reporttype("second");
+    CuAssertStrEquals(tc, "12", written);
+    test_teardown();
+}
+
 static void test_newbie_password_message(CuTest *tc) {
     report_context ctx;
     faction *f;
@@ -485,16 +607,16 @@ static void test_prepare_travelthru(CuTest *tc) {
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, r3, ctx.last);
     CuAssertPtrEquals(tc, f, ctx.f);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_travel, r2->seen.mode);
-    CuAssertIntEquals(tc, seen_none, r3->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_travel, report_seen(&ctx, r2));
+    CuAssertIntEquals(tc, seen_none, report_seen(&ctx, r3));
     finish_reports(&ctx);
-    CuAssertIntEquals(tc, seen_none, r2->seen.mode);
+    CuAssertIntEquals(tc, seen_none, report_seen(&ctx, r2));
 
     prepare_report(&ctx, f2, NULL);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_neighbour, r2->seen.mode);
-    CuAssertIntEquals(tc, seen_unit, r3->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx, r2));
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r3));
     CuAssertPtrEquals(tc, f2, ctx.f);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
@@ -502,6 +624,30 @@ static void test_prepare_travelthru(CuTest *tc) {
     test_teardown();
 }
 
+static void test_prepare_report_concurrent(CuTest *tc) {
+    report_context ctx1, ctx2;
+    faction *f1, *f2;
+    region *r1, *r2;
+
+    test_setup();
+    f1 = test_create_faction();
+    f2 = test_create_faction();
+    r1 = test_create_plain(0, 0);
+    r2 = test_create_plain(1, 0);
+    test_create_unit(f1, r1);
+    test_create_unit(f2, r2);
+    prepare_report(&ctx1, f1, NULL);
+    prepare_report(&ctx2, f2, NULL);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx1, r1));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx1, r2));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx2, r1));
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx2, r2));
+    finish_reports(&ctx1);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx2, r2));
+    finish_reports(&ctx2);
+    test_teardown();
+}
+
 static void test_get_addresses(CuTest *tc) {
     report_context ctx;
     faction *f, *f2, *f1;
@@ -637,9 +783,9 @@ void test_prepare_lighthouse_range(CuTest *tc) {
     prepare_report(&ctx, u1->faction, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse_land, r2->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse, r3->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_lighthouse_land, report_seen(&ctx, r2));
+    CuAssertIntEquals(tc, seen_lighthouse, report_seen(&ctx, r3));
     finish_reports(&ctx);
 
     /* super lighthouse, huge range of 6 */
@@ -652,9 +798,9 @@ void test_prepare_lighthouse_range(CuTest *tc) {
     prepare_report(&ctx, u1->faction, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse, r2->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse, r3->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_lighthouse, report_seen(&ctx, r2));
+    CuAssertIntEquals(tc, seen_lighthouse, report_seen(&ctx, r3));
     finish_reports(&ctx);
 
     test_teardown();
@@ -693,15 +839,15 @@ void test_prepare_lighthouse_capacity(CuTest *tc) {
     prepare_report(&ctx, u1->faction, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse, r2->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_lighthouse, report_seen(&ctx, r2));
     finish_reports(&ctx);
 
     prepare_report(&ctx, u2->faction, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_neighbour, r2->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx, r2));
     finish_reports(&ctx);
 
     /* lighthouse capacity is # of units, not people: */
@@ -709,8 +855,8 @@ void test_prepare_lighthouse_capacity(CuTest *tc) {
     prepare_report(&ctx, u2->faction, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse, r2->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_lighthouse, report_seen(&ctx, r2));
     finish_reports(&ctx);
 
     test_teardown();
@@ -743,10 +889,10 @@ static void test_prepare_lighthouse(CuTest *tc) {
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse, r2->seen.mode);
-    CuAssertIntEquals(tc, seen_neighbour, r3->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse_land, r4->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_lighthouse, report_seen(&ctx, r2));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx, r3));
+    CuAssertIntEquals(tc, seen_lighthouse_land, report_seen(&ctx, r4));
     finish_reports(&ctx);
     test_teardown();
 }
@@ -788,9 +934,9 @@ static void test_prepare_lighthouse_owners(CuTest *tc)
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_lighthouse, r2->seen.mode);
-    CuAssertIntEquals(tc, seen_neighbour, r3->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_lighthouse, report_seen(&ctx, r2));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx, r3));
     finish_reports(&ctx);
     test_teardown();
 }
@@ -807,23 +953,23 @@ static void test_prepare_report(CuTest *tc) {
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, NULL, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_none, r->seen.mode);
+    CuAssertIntEquals(tc, seen_none, report_seen(&ctx, r));
     finish_reports(&ctx);
 
     test_create_unit(f, r);
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, r, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r));
     finish_reports(&ctx);
-    CuAssertIntEquals(tc, seen_none, r->seen.mode);
+    CuAssertIntEquals(tc, seen_none, report_seen(&ctx, r));
 
     r = test_create_region(2, 0, 0);
     CuAssertPtrEquals(tc, r, regions->next);
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, regions, ctx.first);
     CuAssertPtrEquals(tc, r, ctx.last);
-    CuAssertIntEquals(tc, seen_none, r->seen.mode);
+    CuAssertIntEquals(tc, seen_none, report_seen(&ctx, r));
     finish_reports(&ctx);
     test_teardown();
 }
@@ -842,8 +988,8 @@ static void test_seen_neighbours(CuTest *tc) {
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_neighbour, r2->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx, r2));
     finish_reports(&ctx);
     test_teardown();
 }
@@ -869,9 +1015,9 @@ static void test_seen_travelthru(CuTest *tc) {
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_travel, r2->seen.mode);
-    CuAssertIntEquals(tc, seen_neighbour, r3->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_travel, report_seen(&ctx, r2));
+    CuAssertIntEquals(tc, seen_neighbour, report_seen(&ctx, r3));
     finish_reports(&ctx);
     test_teardown();
 }
@@ -947,8 +1093,8 @@ static void test_report_far_vision(CuTest *tc) {
     prepare_report(&ctx, f, NULL);
     CuAssertPtrEquals(tc, r1, ctx.first);
     CuAssertPtrEquals(tc, NULL, ctx.last);
-    CuAssertIntEquals(tc, seen_unit, r1->seen.mode);
-    CuAssertIntEquals(tc, seen_spell, r2->seen.mode);
+    CuAssertIntEquals(tc, seen_unit, report_seen(&ctx, r1));
+    CuAssertIntEquals(tc, seen_spell, report_seen(&ctx, r2));
     finish_reports(&ctx);
     test_teardown();
 }
@@ -1167,6 +1313,94 @@ static void test_eval_functions(CuTest *tc)
     test_teardown();
 }
 
+static void test_render_retranslated(CuTest *tc)
+{
+    message *msg;
+    char buf[64];
+    struct locale *lang, *other;
+
+    test_setup();
+    lang = test_create_locale();
+    other = get_or_create_locale("other");
+    locale_setstring(lang, "nr_news", "$name");
+    locale_setstring(other, "nr_news", "Yo $name");
+    nrt_register(mt_create_va(mt_new("nr_news", NULL), "name:string", MT_NEW_END));
+    nrt_compile();
+
+    msg = msg_message("nr_news", "name", "Hodor");
+    nr_render(msg, lang, buf, sizeof(buf), NULL);
+    CuAssertStrEquals(tc, "Hodor", buf);
+    /* the template is compiled again for the new text */
+    locale_setstring(lang, "nr_news", "Hi $name");
+    nr_render(msg, lang, buf, sizeof(buf), NULL);
+    CuAssertStrEquals(tc, "Hi Hodor", buf);
+    /* only the changed locale is compiled again */
+    locale_setstring(other, "nr_news", "Hey $name");
+    nrt_compile();
+    nr_render(msg, other, buf, sizeof(buf), NULL);
+    CuAssertStrEquals(tc, "Hey Hodor", buf);
+    nr_render(msg, lang, buf, sizeof(buf), NULL);
+    CuAssertStrEquals(tc, "Hi Hodor", buf);
+    msg_release(msg);
+    test_teardown();
+}
+
+static void test_shared_messages(CuTest *tc)
+{
+    message *msg;
+    faction *f1, *f2;
+    char buf[64];
+    struct locale *lang;
+
+    test_setup();
+    lang = test_create_locale();
+    locale_setstring(lang, "nr_news", "$name");
+    nrt_register(mt_create_va(mt_new("nr_news", NULL), "name:string", MT_NEW_END));
+    f1 = test_create_faction();
+    f2 = test_create_faction();
+    f1->locale = f2->locale = lang;
+
+    msg_arena_open();
+    msg = msg_message("nr_news", "name", "Hodor");
+    add_message(&f1->msgs, msg);
+    msg_release(msg);
+    msg = msg_message("nr_news", "name", "Hodor");
+    add_message(&f2->msgs, msg);
+    msg_release(msg);
+    msg = f1->msgs->begin->msg;
+    CuAssertPtrEquals(tc, msg, f2->msgs->begin->msg);
+
+    nr_render(msg, lang, buf, sizeof(buf), f1);
+    CuAssertStrEquals(tc, "Hodor", buf);
+    /* the second faction gets the text that was rendered for the first */
+    locale_setstring(lang, "nr_news", "Hodor!");
+    nr_render(msg, lang, buf, sizeof(buf), f2);
+    CuAssertStrEquals(tc, "Hodor", buf);
+    CuAssertTrue(tc, msg->shared);
+
+    /* news for only one faction is not cached */
+    msg = msg_message("nr_news", "name", "Arya");
+    add_message(&f1->msgs, msg);
+    msg_release(msg);
+    msg = f1->msgs->begin->next->msg;
+    CuAssertTrue(tc, !msg->shared);
+    locale_setstring(lang, "nr_news", "$name!");
+    nr_render(msg, lang, buf, sizeof(buf), f1);
+    CuAssertStrEquals(tc, "Arya!", buf);
+    locale_setstring(lang, "nr_news", "$name");
+    nr_render(msg, lang, buf, sizeof(buf), f1);
+    CuAssertStrEquals(tc, "Arya", buf);
+
+    free_messagelist(f1->msgs->begin);
+    free(f1->msgs);
+    f1->msgs = NULL;
+    free_messagelist(f2->msgs->begin);
+    free(f2->msgs);
+    f2->msgs = NULL;
+    msg_arena_close();
+    test_teardown();
+}
+
 static void test_reports_genpassword(CuTest *tc) {
     faction *f;
     int pwid;
@@ -1209,6 +1443,7 @@ CuSuite* get_reports_suite(void)
     SUITE_ADD_TEST(suite, test_prepare_lighthouse_capacity);
     SUITE_ADD_TEST(suite, test_prepare_lighthouse_range);
     SUITE_ADD_TEST(suite, test_prepare_travelthru);
+    SUITE_ADD_TEST(suite, test_prepare_report_concurrent);
     SUITE_ADD_TEST(suite, test_get_addresses);
     SUITE_ADD_TEST(suite, test_get_addresses_fstealth);
     SUITE_ADD_TEST(suite, test_get_addresses_travelthru);
@@ -1229,6 +1464,10 @@ CuSuite* get_reports_suite(void)
     SUITE_ADD_TEST(suite, test_newbie_warning);
     SUITE_ADD_TEST(suite, test_visible_unit);
     SUITE_ADD_TEST(suite, test_eval_functions);
+    SUITE_ADD_TEST(suite, test_reporttype_order);
+    SUITE_ADD_TEST(suite, test_reports_threads);
+    SUITE_ADD_TEST(suite, test_render_retranslated);
+    SUITE_ADD_TEST(suite, test_shared_messages);
     SUITE_ADD_TEST(suite, test_reports_genpassword);
     return suite;
 }
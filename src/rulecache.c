@@ -0,0 +1,311 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "rulecache.h"
+
+#include "kernel/config.h"
+
+#include "util/log.h"
+#include "util/path.h"
+
+#include <stb_ds.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RULECACHE_VERSION 2
+
+/* The file is the header, then the events as runs of kind, number of
+ * arguments and one string offset for each argument, then the strings.
+ * Offsets are relative to the start of the strings, and are turned into
+ * pointers into the mapped file when the events are replayed. */
+typedef struct rc_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint32_t nevents;
+    uint32_t size;
+} rc_header;
+
+struct rc_writer {
+    char path[PATH_MAX];
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint32_t *events;
+    char *strings;
+};
+
+static uint64_t fnv_hash(uint64_t hash, const char *data, size_t len)
+{
+    size_t i;
+    for (i = 0; i != len; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* a cache file is current if the size and modification time of its
+ * source have not changed. Hashing the contents meant reading every
+ * source file in full at each start, which is what the cache is meant
+ * to avoid. An edit in the same second that keeps the size is missed,
+ * delete the cache directory after such changes. */
+static int source_stat(const char *source, uint64_t *size, int64_t *mtime)
+{
+    struct stat st;
+
+    if (stat(source, &st) != 0) {
+        errno = 0;
+        return -1;
+    }
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return 0;
+}
+
+/* cache files are named for the hash of the source path, since rulesets
+ * in different directories use the same file names */
+const char *rulecache_path(const char *source, char *buf, size_t size)
+{
+    const char *dir = config_get("game.rulecache");
+    char name[32];
+
+    if (!dir) {
+        return NULL;
+    }
+    snprintf(name, sizeof(name), "%016llx.rc",
+        (unsigned long long)fnv_hash(14695981039346656037ULL, source, strlen(source)));
+    return path_join(dir, name, buf, size);
+}
+
+static char *map_file(const char *path, size_t *size)
+{
+#ifndef _WIN32
+    struct stat st;
+    void *data;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        errno = 0;
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        errno = 0;
+        return NULL;
+    }
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        errno = 0;
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return data;
+#else
+    FILE *F = fopen(path, "rb");
+    char *data;
+    long len;
+
+    if (!F) {
+        errno = 0;
+        return NULL;
+    }
+    fseek(F, 0, SEEK_END);
+    len = ftell(F);
+    rewind(F);
+    data = (len > 0) ? malloc((size_t)len) : NULL;
+    if (data && fread(data, 1, (size_t)len, F) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(F);
+    *size = (size_t)len;
+    return data;
+#endif
+}
+
+static void unmap_file(char *data, size_t size)
+{
+#ifndef _WIN32
+    munmap(data, size);
+#else
+    (void)size;
+    free(data);
+#endif
+}
+
+/* check every event before the first one is replayed, a file that ends
+ * early must not leave half a ruleset behind */
+static bool events_valid(const uint32_t *events, uint32_t nevents, uint32_t size)
+{
+    uint32_t i = 0;
+    while (i < nevents) {
+        uint32_t a, nargs;
+        if (nevents - i < 2) {
+            return false;
+        }
+        nargs = events[i + 1];
+        if (nargs > RC_MAXARGS || nevents - i - 2 < nargs) {
+            return false;
+        }
+        for (a = 0; a != nargs; ++a) {
+            if (events[i + 2 + a] >= size) {
+                return false;
+            }
+        }
+        i += 2 + nargs;
+    }
+    return true;
+}
+
+int rulecache_replay(const char *source, rc_event event, void *data)
+{
+    char path[PATH_MAX];
+    const rc_header *head;
+    const uint32_t *events;
+    const char *strings;
+    char *file;
+    size_t size;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint32_t i;
+
+    if (!rulecache_path(source, path, sizeof(path))
+        || source_stat(source, &source_size, &source_mtime) != 0) {
+        return -1;
+    }
+    file = map_file(path, &size);
+    if (!file) {
+        return -1;
+    }
+    head = (const rc_header *)file;
+    if (size < sizeof(rc_header) || memcmp(head->magic, "ERC", 4) != 0
+        || head->version != RULECACHE_VERSION
+        || head->source_size != source_size || head->source_mtime != source_mtime
+        || size != sizeof(rc_header) + (size_t)head->nevents * sizeof(uint32_t) + head->size
+        || head->size == 0) {
+        unmap_file(file, size);
+        return -1;
+    }
+    events = (const uint32_t *)(file + sizeof(rc_header));
+    strings = (const char *)(events + head->nevents);
+    if (strings[head->size - 1] != 0 || !events_valid(events, head->nevents, head->size)) {
+        log_warning("ignoring damaged rule cache %s for %s", path, source);
+        unmap_file(file, size);
+        return -1;
+    }
+    log_debug("replaying %s from %s", source, path);
+    for (i = 0; i < head->nevents;) {
+        const char *args[RC_MAXARGS + 1];
+        uint32_t a, nargs = events[i + 1];
+        for (a = 0; a != nargs; ++a) {
+            args[a] = strings + events[i + 2 + a];
+        }
+        args[nargs] = NULL;
+        event((int)events[i], args, (int)nargs, data);
+        i += 2 + nargs;
+    }
+    unmap_file(file, size);
+    return 0;
+}
+
+struct rc_writer *rulecache_begin(const char *source)
+{
+    struct rc_writer *w;
+    char path[PATH_MAX];
+    uint64_t source_size;
+    int64_t source_mtime;
+
+    if (!rulecache_path(source, path, sizeof(path))
+        || source_stat(source, &source_size, &source_mtime) != 0) {
+        return NULL;
+    }
+    w = calloc(1, sizeof(struct rc_writer));
+    if (!w) abort();
+    memcpy(w->path, path, sizeof(path));
+    w->source_size = source_size;
+    w->source_mtime = source_mtime;
+    return w;
+}
+
+void rulecache_add(struct rc_writer *w, int kind, const char **args, int nargs)
+{
+    int a;
+
+    assert(nargs >= 0 && nargs <= RC_MAXARGS);
+    arrput(w->events, (uint32_t)kind);
+    arrput(w->events, (uint32_t)nargs);
+    for (a = 0; a != nargs; ++a) {
+        size_t len = strlen(args[a]) + 1;
+        arrput(w->events, (uint32_t)arrlen(w->strings));
+        memcpy(arraddnptr(w->strings, len), args[a], len);
+    }
+}
+
+static void writer_free(struct rc_writer *w)
+{
+    arrfree(w->events);
+    arrfree(w->strings);
+    free(w);
+}
+
+void rulecache_abort(struct rc_writer *w)
+{
+    writer_free(w);
+}
+
+/* written under a temporary name and renamed, so that a server that
+ * starts at the same time never sees half a file */
+int rulecache_commit(struct rc_writer *w)
+{
+    char tmp[PATH_MAX + 8];
+    rc_header head;
+    FILE *F;
+    int result = -1;
+
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, "ERC", 4);
+    head.version = RULECACHE_VERSION;
+    head.source_size = w->source_size;
+    head.source_mtime = w->source_mtime;
+    head.nevents = (uint32_t)arrlen(w->events);
+    head.size = (uint32_t)arrlen(w->strings);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", w->path);
+    F = fopen(tmp, "wb");
+    if (F) {
+        fwrite(&head, sizeof(head), 1, F);
+        fwrite(w->events, sizeof(uint32_t), head.nevents, F);
+        fwrite(w->strings, 1, head.size, F);
+        if (fclose(F) == 0) {
+#ifdef _WIN32
+            remove(w->path);
+#endif
+            if (rename(tmp, w->path) == 0) {
+                result = 0;
+            }
+        }
+    }
+    if (result != 0) {
+        log_warning("could not write rule cache %s: %s", w->path, strerror(errno));
+        errno = 0;
+        remove(tmp);
+    }
+    writer_free(w);
+    return result;
+}
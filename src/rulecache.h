@@ -0,0 +1,50 @@
+#pragma once
+#ifndef H_GC_RULECACHE
+#define H_GC_RULECACHE
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /* Compiled ruleset sources.
+     * While an XML or PO file of the ruleset is parsed, the events of its
+     * parser (elements with their attributes, or translations) are
+     * recorded. They are written to a cache file in the directory given
+     * by game.rulecache, together with the size and modification time of
+     * the source. Later runs map that file in one go and replay the events
+     * from it, instead of parsing the source, as long as those still
+     * match. Without
+     * game.rulecache, nothing is cached. */
+
+#define RC_MAXARGS 64
+
+    enum {
+        RC_START,   /* element name, then attribute names and values */
+        RC_END,     /* element name */
+        RC_STRING   /* msgid, msgstr, and an optional msgctxt */
+    };
+
+    typedef void (*rc_event)(int kind, const char **args, int nargs,
+        void *data);
+
+    struct rc_writer;
+
+    /* the cache file for source, or NULL if there is no cache directory */
+    const char *rulecache_path(const char *source, char *buf, size_t size);
+
+    /* returns 0 if the source was replayed from its cache file */
+    int rulecache_replay(const char *source, rc_event event, void *data);
+
+    /* returns NULL if there is no cache directory */
+    struct rc_writer *rulecache_begin(const char *source);
+    void rulecache_add(struct rc_writer *w, int kind, const char **args,
+        int nargs);
+    int rulecache_commit(struct rc_writer *w);
+    void rulecache_abort(struct rc_writer *w);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,181 @@
+#include "rulecache.h"
+#include "exparse.h"
+#include "jsonconf.h"
+
+#include <kernel/config.h>
+#include <kernel/item.h>
+
+#include <util/language.h>
+
+#include <strings.h>
+
+#include <tests.h>
+#include <cJSON.h>
+#include <CuTest.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct replay_log {
+    int count;
+    char text[256];
+} replay_log;
+
+static void log_event(int kind, const char **args, int nargs, void *data)
+{
+    replay_log *log = (replay_log *)data;
+    size_t len = strlen(log->text);
+    int a;
+
+    len += snprintf(log->text + len, sizeof(log->text) - len, "%d", kind);
+    for (a = 0; a != nargs; ++a) {
+        len += snprintf(log->text + len, sizeof(log->text) - len, " %s", args[a]);
+    }
+    str_strlcpy(log->text + len, ";", sizeof(log->text) - len);
+    ++log->count;
+}
+
+static void write_source(const char *filename, const char *text)
+{
+    FILE *F = fopen(filename, "wb");
+    fputs(text, F);
+    fclose(F);
+}
+
+static void test_rulecache_replay(CuTest *tc) {
+    struct rc_writer *w;
+    const char *args[3] = { "resource", "name", "iron" };
+    char path[PATH_MAX];
+    replay_log events;
+
+    test_setup();
+    write_source("rules.xml", "<eressea><resource name=\"iron\"/></eressea>");
+    CuAssertPtrEquals(tc, NULL, rulecache_begin("rules.xml"));
+    config_set("game.rulecache", ".");
+    CuAssertPtrNotNull(tc, rulecache_path("rules.xml", path, sizeof(path)));
+    remove(path);
+    errno = 0;
+
+    memset(&events, 0, sizeof(events));
+    CuAssertIntEquals(tc, -1, rulecache_replay("rules.xml", log_event, &events));
+    w = rulecache_begin("rules.xml");
+    CuAssertPtrNotNull(tc, w);
+    rulecache_add(w, RC_START, args, 3);
+    rulecache_add(w, RC_END, args, 1);
+    CuAssertIntEquals(tc, 0, rulecache_commit(w));
+
+    CuAssertIntEquals(tc, 0, rulecache_replay("rules.xml", log_event, &events));
+    CuAssertIntEquals(tc, 2, events.count);
+    CuAssertStrEquals(tc, "0 resource name iron;1 resource;", events.text);
+
+    /* a changed source is parsed again */
+    write_source("rules.xml", "<eressea><resource name=\"copper\"/></eressea>");
+    CuAssertIntEquals(tc, -1, rulecache_replay("rules.xml", log_event, &events));
+    CuAssertIntEquals(tc, 2, events.count);
+
+    CuAssertIntEquals(tc, 0, remove(path));
+    CuAssertIntEquals(tc, 0, remove("rules.xml"));
+    test_teardown();
+}
+
+static void check_iron(CuTest *tc)
+{
+    const resource_type *rtype = rt_find("iron");
+    CuAssertPtrNotNull(tc, rtype);
+    CuAssertPtrNotNull(tc, rtype->itype);
+    CuAssertIntEquals(tc, 500, rtype->itype->weight);
+    CuAssertIntEquals(tc, 10, rtype->itype->score);
+    CuAssertPtrNotNull(tc, rt_find("stone"));
+}
+
+static void test_rulecache_xml(CuTest *tc) {
+    char path[PATH_MAX];
+    replay_log events;
+
+    test_setup();
+    write_source("rules.xml", "<eressea><resources>"
+        "<resource name=\"iron\"><item weight=\"500\" score=\"10\"/></resource>"
+        "<resource name=\"stone\"/>"
+        "</resources></eressea>");
+    config_set("game.rulecache", ".");
+    rulecache_path("rules.xml", path, sizeof(path));
+    remove(path);
+    errno = 0;
+
+    /* parsed from the source, and recorded */
+    CuAssertIntEquals(tc, 0, exparse_readfile("rules.xml"));
+    check_iron(tc);
+    memset(&events, 0, sizeof(events));
+    CuAssertIntEquals(tc, 0, rulecache_replay("rules.xml", log_event, &events));
+    CuAssertIntEquals(tc, 10, events.count);
+    test_teardown();
+
+    /* replayed from the cache, the same types come out */
+    test_setup();
+    config_set("game.rulecache", ".");
+    CuAssertPtrEquals(tc, NULL, rt_find("iron"));
+    CuAssertIntEquals(tc, 0, exparse_readfile("rules.xml"));
+    check_iron(tc);
+
+    CuAssertIntEquals(tc, 0, remove(path));
+    CuAssertIntEquals(tc, 0, remove("rules.xml"));
+    test_teardown();
+}
+
+static void read_po_config(void)
+{
+    cJSON *json = cJSON_Parse("{\"include\": [\"rules.de.po\"]}");
+    json_config(json);
+    cJSON_Delete(json);
+}
+
+static void check_po(CuTest *tc)
+{
+    const struct locale *lang = get_locale("de");
+    CuAssertPtrNotNull(tc, lang);
+    CuAssertStrEquals(tc, "Eisen", locale_getstring(lang, "iron"));
+    CuAssertStrEquals(tc, "Stein", locale_getstring(lang, mkname("resource", "stone")));
+}
+
+static void test_rulecache_po(CuTest *tc) {
+    char path[PATH_MAX];
+    replay_log events;
+
+    test_setup();
+    write_source("rules.de.po", "msgid \"iron\"\nmsgstr \"Eisen\"\n\n"
+        "msgctxt \"resource\"\nmsgid \"stone\"\nmsgstr \"Stein\"\n");
+    config_set("game.rulecache", ".");
+    rulecache_path("rules.de.po", path, sizeof(path));
+    remove(path);
+    errno = 0;
+
+    /* parsed from the source, and recorded */
+    read_po_config();
+    check_po(tc);
+    memset(&events, 0, sizeof(events));
+    CuAssertIntEquals(tc, 0, rulecache_replay("rules.de.po", log_event, &events));
+    CuAssertStrEquals(tc, "2 iron Eisen;2 stone Stein resource;", events.text);
+    test_teardown();
+
+    /* replayed from the cache, the same strings come out */
+    test_setup();
+    config_set("game.rulecache", ".");
+    CuAssertPtrEquals(tc, NULL, get_locale("de"));
+    read_po_config();
+    check_po(tc);
+
+    CuAssertIntEquals(tc, 0, remove(path));
+    CuAssertIntEquals(tc, 0, remove("rules.de.po"));
+    test_teardown();
+}
+
+CuSuite *get_rulecache_suite(void)
+{
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_rulecache_replay);
+    SUITE_ADD_TEST(suite, test_rulecache_xml);
+    SUITE_ADD_TEST(suite, test_rulecache_po);
+    return suite;
+}
@@ -117,6 +117,7 @@ void do_sort(region *r)
         for (u = r->units; u; u = u->next) {
             freset(u, UFL_MARK);
         }
+        units_moved(r);
     }
 }
 
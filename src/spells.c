@@ -5657,6 +5657,8 @@ int sp_movecastle(castorder * co)
         }
         u = unext;
     }
+    units_moved(r);
+    units_moved(target_region);
 
     if ((is_building_type(b->type, "caravan") || is_building_type(b->type, "dam")
         || is_building_type(b->type, "tunnel"))) {
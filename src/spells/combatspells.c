@@ -810,6 +810,7 @@ int sp_chaosrow(struct castorder * co)
                 assert(!"unknown combatrow");
             }
             assert(statusrow(df->status) == row);
+            side_troops_changed(df->side);
             df->side->size[row] += df->alive;
             if (u_race(df->unit)->battle_flags & BF_NOBLOCK) {
                 df->side->nonblockers[row] += df->alive;
@@ -1322,6 +1323,7 @@ int sp_reanimate(struct castorder * co)
              * oder weggelaufene ist t.fighter->hitpoints[tf->alive] */
             tf->person[tf->alive].hp = 2;
             ++tf->alive;
+            side_troops_changed(tf->side);
             ++tf->side->size[SUM_ROW];
             ++tf->side->size[tf->unit->status + 1];
             ++tf->side->healed;
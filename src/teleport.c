@@ -42,29 +42,66 @@ static region *tpregion(const region * r)
     return rt;
 }
 
-int regions_in_range(const region * r, int radius, bool(*valid) (const region *), region *result[])
+struct valid_regions {
+    const region *center;
+    int width, height;
+    bool(*valid) (const region *);
+    region **result;
+    int num;
+};
+
+static int wrap_offset(int d, int size)
 {
-    int x, y, num = 0;
-    const struct plane *pl = rplane(r);
-    for (x = -radius; x <= +radius; ++x) {
-        for (y = -radius; y <= radius; ++y) {
-            int dist = koor_distance(0, 0, x, y);
-
-            if (dist <= radius) {
-                region *rn;
-                int nx = r->x + x, ny = r->y + y;
-                pnormalize(&nx, &ny, pl);
-                rn = findregion(nx, ny);
-                if (rn != NULL && (valid == NULL || valid(rn))) {
-                    if (result) {
-                        result[num] = rn;
-                    }
-                    ++num;
-                }
+    if (size) {
+        d %= size;
+        if (d > size / 2) d -= size;
+        else if (d < -size / 2) d += size;
+    }
+    return d;
+}
+
+/* the results are ordered by their x, then y offset from the center,
+ * like the loops this used to be. Callers pick from the result with
+ * rng_int(), and reports list it in this order. */
+static bool region_before(const struct valid_regions *vr, const region *r1,
+    const region *r2)
+{
+    int dx1 = wrap_offset(r1->x - vr->center->x, vr->width);
+    int dx2 = wrap_offset(r2->x - vr->center->x, vr->width);
+    if (dx1 != dx2) {
+        return dx1 < dx2;
+    }
+    return wrap_offset(r1->y - vr->center->y, vr->height)
+        < wrap_offset(r2->y - vr->center->y, vr->height);
+}
+
+static void cb_valid_region(region *r, void *cbdata)
+{
+    struct valid_regions *vr = (struct valid_regions *)cbdata;
+    if (vr->valid == NULL || vr->valid(r)) {
+        if (vr->result) {
+            int i = vr->num;
+            for (; i > 0 && region_before(vr, r, vr->result[i - 1]); --i) {
+                vr->result[i] = vr->result[i - 1];
             }
+            vr->result[i] = r;
         }
+        ++vr->num;
     }
-    return num;
+}
+
+int regions_in_range(const region * r, int radius, bool(*valid) (const region *), region *result[])
+{
+    struct valid_regions vr;
+    const struct plane *pl = rplane(r);
+    vr.center = r;
+    vr.width = plane_width(pl);
+    vr.height = plane_height(pl);
+    vr.valid = valid;
+    vr.result = result;
+    vr.num = 0;
+    regions_in_radius(r, radius, cb_valid_region, &vr);
+    return vr.num;
 }
 
 int get_astralregions(const region * r, bool(*valid) (const region *), region *result[])
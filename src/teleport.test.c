@@ -36,9 +36,36 @@ static void test_update_teleport(CuTest *tc) {
     test_teardown();
 }
 
+static void test_regions_in_range_order(CuTest *tc) {
+    region *r, *result[32];
+    int x, y, i = 0, n;
+
+    test_setup();
+    for (y = -3; y <= 3; ++y) {
+        for (x = -3; x <= 3; ++x) {
+            test_create_plain(x, y);
+        }
+    }
+    r = findregion(0, 0);
+    n = regions_in_range(r, 2, NULL, result);
+    CuAssertIntEquals(tc, 19, n);
+    CuAssertIntEquals(tc, n, regions_in_range(r, 2, NULL, NULL));
+    /* by x offset, then by y offset */
+    for (x = -2; x <= 2; ++x) {
+        for (y = -2; y <= 2; ++y) {
+            if (koor_distance(0, 0, x, y) <= 2) {
+                CuAssertPtrEquals(tc, findregion(x, y), result[i++]);
+            }
+        }
+    }
+    CuAssertIntEquals(tc, n, i);
+    test_teardown();
+}
+
 CuSuite *get_teleport_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, test_update_teleport);
+    SUITE_ADD_TEST(suite, test_regions_in_range_order);
     return suite;
 }
@@ -92,6 +92,8 @@ int RunAllTests(int argc, char *argv[])
     ADD_SUITE(log);
     ADD_SUITE(variant);
     ADD_SUITE(rand);
+    ADD_SUITE(workers);
+    ADD_SUITE(translation);
     /* items */
     ADD_SUITE(xerewards);
     /* kernel */
@@ -112,6 +114,7 @@ int RunAllTests(int argc, char *argv[])
     ADD_SUITE(magicresistance);
     ADD_SUITE(regioncurse);
     ADD_SUITE(messages);
+    ADD_SUITE(pathfinder);
     ADD_SUITE(plane);
     ADD_SUITE(pool);
     ADD_SUITE(reports);
@@ -130,6 +133,7 @@ int RunAllTests(int argc, char *argv[])
     ADD_SUITE(calendar);
     ADD_SUITE(contact);
     ADD_SUITE(creport);
+    ADD_SUITE(crdelta);
     ADD_SUITE(defaults);
     ADD_SUITE(donations);
     ADD_SUITE(economy);
@@ -150,6 +154,7 @@ int RunAllTests(int argc, char *argv[])
     ADD_SUITE(recruit);
     ADD_SUITE(renumber);
     ADD_SUITE(report);
+    ADD_SUITE(rulecache);
     ADD_SUITE(shock);
     ADD_SUITE(sort);
     ADD_SUITE(spy);
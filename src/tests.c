@@ -40,6 +40,7 @@
 #include "util/rand.h"
 #include "util/stats.h"
 #include "util/variant.h"      // for variant, VAR_VOIDPTR, VAR_INT
+#include "util/workers.h"
 
 #include <strings.h>
 
@@ -567,6 +568,19 @@ const char * test_get_messagetype(const message *msg) {
     return get_messagetype_name(msg);
 }
 
+/* the names of the message types, each followed by a blank */
+size_t test_messagetypes(char *buf, size_t size, const message_list *msgs)
+{
+    size_t len = 0;
+    if (msgs) {
+        const struct mlist *ml;
+        for (ml = msgs->begin; ml && len < size; ml = ml->next) {
+            len += snprintf(buf + len, size - len, "%s ", test_get_messagetype(ml->msg));
+        }
+    }
+    return len;
+}
+
 struct message * test_find_messagetype_ex(struct message_list *msgs, const char *name, struct message *prev)
 {
     struct mlist *ml;
@@ -651,6 +665,36 @@ void test_clear_region_messages(struct region *r)
     }
 }
 
+#define THREADS_RESULTSIZE 8192
+
+static void threads_play(int threads, void (*setup)(void), void (*play)(void),
+    void (*result)(char *buf, size_t size), char *buf)
+{
+    test_setup();
+    config_set_int("game.threads", threads);
+    setup();
+    play();
+    workers_set_count(1);
+    buf[0] = '\0';
+    result(buf, THREADS_RESULTSIZE);
+    test_teardown();
+}
+
+void test_threads_agree(CuTest *tc, void (*setup)(void), void (*play)(void),
+    void (*result)(char *buf, size_t size))
+{
+    char *serial = malloc(THREADS_RESULTSIZE);
+    char *parallel = malloc(THREADS_RESULTSIZE);
+
+    if (!serial || !parallel) abort();
+    threads_play(1, setup, play, result, serial);
+    threads_play(4, setup, play, result, parallel);
+    CuAssertTrue(tc, serial[0] != '\0');
+    CuAssertStrEquals(tc, serial, parallel);
+    free(serial);
+    free(parallel);
+}
+
 void assert_message(CuTest * tc, message *msg, char *name, int numpar) {
     const message_type *mtype = msg->type;
     assert(mtype);
@@ -1,6 +1,8 @@
 #ifndef ERESSEA_TESTS_H
 #define ERESSEA_TESTS_H
 
+#include <stddef.h>
+
 #define ASSERT_DBL_DELTA 0.001
 
 enum param_t;
@@ -66,12 +68,18 @@ struct message *test_get_last_message(struct message_list *mlist);
 void test_clear_messages(struct faction *f);
 void test_clear_region_messages(struct region *r);
 void test_clear_messagelist(struct message_list **msgs);
+size_t test_messagetypes(char *buf, size_t size, const struct message_list *msgs);
 void assert_message(struct CuTest * tc, struct message *msg, char *name, int numpar);
 
 void assert_pointer_parameter(struct CuTest * tc, struct message *msg, int index, void *arg);
 void assert_int_parameter(struct CuTest * tc, struct message *msg, int index, int arg);
 void assert_string_parameter(struct CuTest * tc, struct message *msg, int index, const char *arg);
 
+/* plays the same game with one thread and with four (game.threads), and
+ * asserts that result describes both games the same way */
+void test_threads_agree(struct CuTest *tc, void (*setup)(void),
+    void (*play)(void), void (*result)(char *buf, size_t size));
+
 void disabled_test(void *suite, void (*)(struct CuTest *), const char *name);
 
 #define DISABLE_TEST(SUITE, TEST) disabled_test(SUITE, TEST, #TEST)
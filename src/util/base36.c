@@ -1,4 +1,5 @@
 #include "base36.h"
+#include "macros.h"
 
 #include <assert.h>
 #include <stdio.h>
@@ -96,9 +97,9 @@ const char *itoa36_r(int i, char *result, size_t len)
  
 const char *itoab(int i, int base)
 {
-    static char sstr[80];
+    static THREAD_LOCAL char sstr[80];
     char *s;
-    static int index = 0;         /* STATIC_XCALL: used across calls */
+    static THREAD_LOCAL int index = 0;         /* STATIC_XCALL: used across calls */
 
     s = sstr + (index * 20);
     index = (index + 1) & 3;      /* quick for % 4 */
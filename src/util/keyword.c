@@ -6,6 +6,7 @@
 #include "language.h"
 #include "umlaut.h"
 #include "log.h"
+#include "macros.h"
 #include "strings.h"
 
 #include <critbit.h>
@@ -15,7 +16,7 @@
 
 const char * keyword(keyword_t kwd)
 {
-    static char result[32]; /* FIXME: static return value */
+    static THREAD_LOCAL char result[32]; /* FIXME: static return value */
     if (kwd==NOKEYWORD || keywords[kwd] == NULL) {
         return NULL;
     }
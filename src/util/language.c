@@ -4,6 +4,7 @@
 #include "language.h"
 
 #include "log.h"
+#include "macros.h"
 #include "strings.h"
 #include "umlaut.h"
 #include "assert.h"
@@ -26,12 +27,28 @@ typedef struct locale {
     unsigned int index;
     struct locale *next;
     unsigned int hashkey;
+    int version;
     struct locale_str *strings[SMAXHASH];
 } locale;
 
 locale *default_locale;
 locale *locales;
 
+static int locale_cache_key = 1;
+
+int locales_version(void)
+{
+    return locale_cache_key;
+}
+
+/* versions of a locale are taken from locale_cache_key, so they are
+ * never reused, not even by a new locale with the same index */
+int locale_version(const locale *lang)
+{
+    assert(lang);
+    return lang->version;
+}
+
 unsigned int locale_index(const locale * lang)
 {
     assert(lang);
@@ -72,6 +89,7 @@ locale *get_or_create_locale(const char *name)
     l->index = nextlocaleindex++;
     assert(nextlocaleindex <= MAXLOCALES);
     if (default_locale == NULL) default_locale = l;
+    l->version = ++locale_cache_key;
     return l;
 }
 
@@ -207,12 +225,14 @@ void locale_setstring(locale * lang, const char *key, const char *value)
         find->hashkey = hkey;
         find->key = str_strdup(key);
         find->str = str_strdup(value);
+        lang->version = ++locale_cache_key;
     }
     else {
         if (strcmp(find->str, value) != 0) {
             log_warning("multiple translations for key %s\n", key);
             free(find->str);
             find->str = str_strdup(value);
+            lang->version = ++locale_cache_key;
         }
     }
 }
@@ -272,7 +292,7 @@ char *mkname_buf(const char *space, const char *name, char *buffer)
 
 const char *mkname(const char *space, const char *name)
 {
-    static char zBuffer[128]; /* FIXME: static return value */
+    static THREAD_LOCAL char zBuffer[128]; /* FIXME: static return value */
     return mkname_buf(space, name, zBuffer);
 }
 
@@ -373,6 +393,7 @@ void reset_locales(void) {
 
 void free_locales(void) {
     locale_init = 0;
+    ++locale_cache_key;
     while (locales) {
         int i, index = locales->index;
         locale * next = locales->next;
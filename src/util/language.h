@@ -35,6 +35,10 @@ extern "C" {
     const char *locale_plural(const struct locale *lang, const char *key, int n, bool warn);
     unsigned int locale_index(const struct locale *lang);
     const char *locale_name(const struct locale *lang);
+    /* changes whenever a locale or one of its strings is added or replaced */
+    int locales_version(void);
+    /* changes whenever one of the strings of lang is added or replaced */
+    int locale_version(const struct locale *lang);
 
     const char *mkname(const char *namespc, const char *key);
     char *mkname_buf(const char *namespc, const char *key, char *buffer);
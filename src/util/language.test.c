@@ -25,10 +25,32 @@ static void test_make_locales(CuTest *tc)
     test_teardown();
 }
 
+static void test_locale_version(CuTest *tc)
+{
+    struct locale *aa, *bb;
+    int va, vb;
+
+    test_setup();
+    aa = get_or_create_locale("aa");
+    bb = get_or_create_locale("bb");
+    va = locale_version(aa);
+    vb = locale_version(bb);
+    CuAssertTrue(tc, va != vb);
+    locale_setstring(bb, "hello", "Hallo");
+    CuAssertIntEquals(tc, va, locale_version(aa));
+    CuAssertTrue(tc, vb < locale_version(bb));
+    vb = locale_version(bb);
+    /* the same text again is no change */
+    locale_setstring(bb, "hello", "Hallo");
+    CuAssertIntEquals(tc, vb, locale_version(bb));
+    test_teardown();
+}
+
 CuSuite *get_language_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, test_language);
     SUITE_ADD_TEST(suite, test_make_locales);
+    SUITE_ADD_TEST(suite, test_locale_version);
     return suite;
 }
@@ -5,6 +5,7 @@
 
 #include "path.h"
 #include "lists.h"
+#include "macros.h"
 #include "strings.h"
 #include "unicode.h"
 
@@ -145,9 +146,9 @@ static const char *log_prefix(int level) {
 
 static int check_dupe(const char *format, int level)
 {
-    static int last_type; /* STATIC_XCALL: used across calls */
-    static char last_message[32] = { 0 }; /* STATIC_XCALL: used across calls */
-    static int dupes = 0;         /* STATIC_XCALL: used across calls */
+    static THREAD_LOCAL int last_type; /* STATIC_XCALL: used across calls */
+    static THREAD_LOCAL char last_message[32] = { 0 }; /* STATIC_XCALL: used across calls */
+    static THREAD_LOCAL int dupes = 0;         /* STATIC_XCALL: used across calls */
     if (strncmp(last_message, format, sizeof(last_message)) == 0) {
         /* TODO: C6054: String 'last_message' might not be zero - terminated. */
         ++dupes;
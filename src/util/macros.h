@@ -1 +1,10 @@
 #define UNUSED_ARG(x) (void)(x)
+
+/* storage class for per-thread state (parser, scratch buffers, etc.) */
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
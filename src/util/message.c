@@ -2,10 +2,15 @@
 
 #include "strings.h"
 #include "log.h"
+#include "macros.h"
 #include "selist.h"
+#include "workers.h"
+
+#include <stb_ds.h>
 
 /* libc includes */
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,6 +36,7 @@ variant(*copy_arg) (variant), variant_type type)
     atype->release = free_arg;
     atype->copy = copy_arg;
     atype->vtype = type;
+    atype->flags = 0;
     argtypes = atype;
 }
 
@@ -59,6 +65,12 @@ static unsigned int mt_id(const message_type * mtype)
 
 #define MT_MAXHASH 1021
 static selist *messagetypes[MT_MAXHASH];
+static int mt_cache_key = 1;
+
+int mt_version(void)
+{
+    return mt_cache_key;
+}
 
 static void mt_register(message_type * mtype) {
     unsigned int hash = str_hash(mtype->name) % MT_MAXHASH;
@@ -66,6 +78,7 @@ static void mt_register(message_type * mtype) {
 
     if (selist_set_insert(qlp, mtype, NULL)) {
         mtype->key = mt_id(mtype);
+        ++mt_cache_key;
     }
 }
 
@@ -209,7 +222,224 @@ static void free_arg(const arg_type * atype, variant data)
         atype->release(data);
 }
 
-message *msg_create(const struct message_type *mtype, variant args[])
+/* Each thread fills its own block of the arena, and takes the lock only
+ * to add a new block to the list. A block that belongs to an earlier
+ * arena is recognized by its key and not used again. The first block of
+ * a thread is small, and each further one twice the size of the last, so
+ * the worker threads of a short parallel step do not each take 1MB. */
+#define MSG_BLOCKMIN (1 << 14)
+#define MSG_BLOCKMAX (1 << 20)
+
+static char **arena_blocks;
+static int arena_key;
+static int arena_count;
+
+static THREAD_LOCAL struct arena_block {
+    char *data;
+    size_t used, size;
+    int key;
+} arena_block;
+
+/* The intern table is open addressing with linear probing, and holds a
+ * reference to each of its messages until the arena is closed. Only the
+ * main thread interns, so neither the lookup nor the reference counts of
+ * interned messages need the lock. Messages that workers add during
+ * parallel steps are deferred, and interned when the main thread merges
+ * them, so recipients in different regions still share one message. */
+typedef struct intern_entry {
+    unsigned int hash;
+    message *msg;
+} intern_entry;
+
+static intern_entry *intern_table;
+static unsigned int intern_size, intern_count;
+
+static void intern_clear(void)
+{
+    unsigned int i;
+    for (i = 0; i != intern_size; ++i) {
+        if (intern_table[i].msg) {
+            msg_release(intern_table[i].msg);
+        }
+    }
+    free(intern_table);
+    intern_table = NULL;
+    intern_size = intern_count = 0;
+}
+
+/* strings are compared by their text, other copied arguments like
+ * orders and item lists are private to their message */
+static bool msg_internable(const message *msg)
+{
+    int i;
+    for (i = 0; i != msg->type->nparameters; ++i) {
+        const arg_type *atype = msg->type->types[i];
+        if (atype->copy && !(atype->flags & ARG_STRING)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static unsigned int msg_hash(const message *msg)
+{
+    unsigned int hash = msg->type->key;
+    int i;
+    for (i = 0; i != msg->type->nparameters; ++i) {
+        const arg_type *atype = msg->type->types[i];
+        variant var = msg->parameters[i];
+        unsigned int h;
+        if (atype->flags & ARG_STRING) {
+            h = var.v ? str_hash((const char *)var.v) : 0;
+        }
+        else if (atype->vtype == VAR_VOIDPTR) {
+            uintptr_t p = (uintptr_t)var.v;
+            h = (unsigned int)(p ^ (p >> 16));
+        }
+        else {
+            h = (unsigned int)var.i;
+        }
+        hash = (hash ^ h) * 16777619u;
+    }
+    return hash;
+}
+
+static bool msg_equal(const message *a, const message *b)
+{
+    int i;
+    if (a->type != b->type) {
+        return false;
+    }
+    for (i = 0; i != a->type->nparameters; ++i) {
+        const arg_type *atype = a->type->types[i];
+        variant va = a->parameters[i], vb = b->parameters[i];
+        if (atype->flags & ARG_STRING) {
+            if (va.v != vb.v && (!va.v || !vb.v || strcmp(va.v, vb.v) != 0)) {
+                return false;
+            }
+        }
+        else if (atype->vtype == VAR_VOIDPTR) {
+            if (va.v != vb.v) {
+                return false;
+            }
+        }
+        else if (va.i != vb.i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void intern_grow(void)
+{
+    intern_entry *table = intern_table;
+    unsigned int i, size = intern_size;
+
+    intern_size = size ? size * 2 : 1024;
+    intern_table = calloc(intern_size, sizeof(intern_entry));
+    if (!intern_table) abort();
+    for (i = 0; i != size; ++i) {
+        if (table[i].msg) {
+            unsigned int mask = intern_size - 1, n = table[i].hash & mask;
+            while (intern_table[n].msg) {
+                n = (n + 1) & mask;
+            }
+            intern_table[n] = table[i];
+        }
+    }
+    free(table);
+}
+
+message *msg_intern(message *msg)
+{
+    message *result = msg;
+    unsigned int hash, mask, i;
+
+    if (!msg->in_arena || workers_active() || !msg_internable(msg)) {
+        return msg;
+    }
+    hash = msg_hash(msg);
+    if ((intern_count + 1) * 4 > intern_size * 3) {
+        intern_grow();
+    }
+    mask = intern_size - 1;
+    for (i = hash & mask; intern_table[i].msg; i = (i + 1) & mask) {
+        if (intern_table[i].hash == hash && msg_equal(intern_table[i].msg, msg)) {
+            result = intern_table[i].msg;
+            result->shared = true;
+            break;
+        }
+    }
+    if (result == msg) {
+        intern_table[i].hash = hash;
+        intern_table[i].msg = msg_addref(msg);
+        ++intern_count;
+    }
+    return result;
+}
+
+int msg_arena_id(void)
+{
+    return arena_key;
+}
+
+void msg_arena_open(void)
+{
+    assert(!workers_active());
+    if (arena_key == 0) {
+        arena_key = ++arena_count;
+    }
+}
+
+void msg_arena_close(void)
+{
+    ptrdiff_t i, len = arrlen(arena_blocks);
+
+    assert(!workers_active());
+    intern_clear();
+    for (i = 0; i != len; ++i) {
+        free(arena_blocks[i]);
+    }
+    arrfree(arena_blocks);
+    arena_key = 0;
+}
+
+void *msg_arena_alloc(size_t size)
+{
+    void *result;
+
+    assert(arena_key != 0);
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    assert(size <= MSG_BLOCKMAX);
+    if (arena_block.key != arena_key) {
+        arena_block.data = NULL;
+        arena_block.used = arena_block.size = 0;
+        arena_block.key = arena_key;
+    }
+    if (arena_block.used + size > arena_block.size) {
+        size_t bsize = arena_block.size ? arena_block.size * 2 : MSG_BLOCKMIN;
+        char *data;
+        while (bsize < size) {
+            bsize *= 2;
+        }
+        if (bsize > MSG_BLOCKMAX) {
+            bsize = MSG_BLOCKMAX;
+        }
+        data = malloc(bsize);
+        if (!data) abort();
+        workers_lock();
+        arrput(arena_blocks, data);
+        workers_unlock();
+        arena_block.data = data;
+        arena_block.used = 0;
+        arena_block.size = bsize;
+    }
+    result = arena_block.data + arena_block.used;
+    arena_block.used += size;
+    return result;
+}
+
+static message *msg_init(const struct message_type *mtype, variant args[], bool in_arena)
 {
     message *msg;
 
@@ -218,15 +448,28 @@ message *msg_create(const struct message_type *mtype, variant args[])
         log_error("Trying to create message with type=0x0\n");
         return NULL;
     }
-    msg = (message *)malloc(sizeof(message));
-    if (!msg) abort();
+    if (in_arena) {
+        /* the parameters follow the message in the same allocation */
+        msg = (message *)msg_arena_alloc(sizeof(message) + mtype->nparameters * sizeof(variant));
+    }
+    else {
+        msg = (message *)malloc(sizeof(message));
+        if (!msg) abort();
+    }
     msg->type = mtype;
     msg->refcount = 1;
+    msg->in_arena = in_arena;
+    msg->shared = false;
     msg->parameters = NULL;
     if (mtype->nparameters > 0) {
         int i;
-        msg->parameters = (variant *)(mtype->nparameters ? calloc(mtype->nparameters, sizeof(variant)) : NULL);
-        if (!msg->parameters) abort();
+        if (in_arena) {
+            msg->parameters = (variant *)(msg + 1);
+        }
+        else {
+            msg->parameters = (variant *)calloc(mtype->nparameters, sizeof(variant));
+            if (!msg->parameters) abort();
+        }
         for (i = 0; i != mtype->nparameters; ++i) {
             msg->parameters[i] = copy_arg(mtype->types[i], args[i]);
         }
@@ -236,6 +479,16 @@ message *msg_create(const struct message_type *mtype, variant args[])
     return msg;
 }
 
+message *msg_create(const struct message_type *mtype, variant args[])
+{
+    return msg_init(mtype, args, arena_key != 0);
+}
+
+message *msg_create_heap(const struct message_type *mtype, variant args[])
+{
+    return msg_init(mtype, args, false);
+}
+
 static void mt_free(void *val) {
     message_type *mtype = (message_type *)val;
     int i;
@@ -256,6 +509,7 @@ void mt_clear(void) {
         selist_free(ql);
         messagetypes[i] = 0;
     }
+    ++mt_cache_key;
     for (i = 0; i != MAXSECTIONS && sections[i]; ++i) {
         free(sections[i]);
         sections[i] = NULL;
@@ -284,8 +538,10 @@ void msg_free(message * msg)
     for (i = 0; i != msg->type->nparameters; ++i) {
         free_arg(msg->type->types[i], msg->parameters[i]);
     }
-    free((void *)msg->parameters);
-    free(msg);
+    if (!msg->in_arena) {
+        free((void *)msg->parameters);
+        free(msg);
+    }
 }
 
 void msg_release(struct message *msg)
@@ -304,6 +560,7 @@ struct message *msg_addref(struct message *msg)
 }
 
 void message_done(void) {
+    msg_arena_close();
     arg_type **atp = &argtypes;
     while (*atp) {
         arg_type *at = *atp;
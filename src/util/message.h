@@ -3,6 +3,9 @@
 
 #include "variant.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,12 +14,16 @@ extern "C" {
 #define MT_NEW_END ((const char *)0)
 #define MAXSECTIONS 16
 
+#define ARG_STRING 0x01 /* a string, equal messages have equal text */
+#define ARG_VIEWER 0x02 /* rendered differently for each viewer */
+
     typedef struct arg_type {
         struct arg_type *next;
         variant_type vtype;
         const char *name;
         void(*release) (variant);
         variant(*copy) (variant);
+        unsigned int flags;
     } arg_type;
 
     typedef struct message_type {
@@ -32,6 +39,8 @@ extern "C" {
         const struct message_type *type;
         variant *parameters;
         int refcount;
+        bool in_arena;
+        bool shared; /* interned, and given to more than one recipient */
     } message;
 
     void message_done(void);
@@ -42,6 +51,25 @@ extern "C" {
         variant args[]);
     /* msg_create(&mt_simplesentence, "enno", "eats", "chocolate", &locale_de);
      * parameters must be in the same order as they were for mt_new! */
+    struct message *msg_create_heap(const struct message_type *type,
+        variant args[]);
+    /* like msg_create, but never in the arena, for messages that are kept
+     * after it is closed */
+
+    /* While the message arena is open, msg_create takes messages from it
+     * instead of the heap. Their memory is not returned when the last
+     * reference is released, but all at once by msg_arena_close, which
+     * must only be called when none of them are used any more. */
+    void msg_arena_open(void);
+    void msg_arena_close(void);
+    void *msg_arena_alloc(size_t size);
+    int msg_arena_id(void);
+
+    /* Returns an arena message with the same type and parameters as msg,
+     * or msg itself if it is the first, or cannot be interned. Interned
+     * messages are kept until the arena is closed. Worker threads do not
+     * intern, and get msg back. */
+    struct message *msg_intern(struct message *msg);
     
     extern char *sections[MAXSECTIONS];
     extern void(*msg_log_create) (const struct message * msg);
@@ -58,6 +86,9 @@ extern "C" {
     struct message_type *mt_create_error(int error);
     struct message_type *mt_create_va(struct message_type *, ...);
     const struct message_type *mt_find(const char *);
+    /* changes whenever a message type is registered or the registry is
+     * cleared, for callers that cache the result of mt_find */
+    int mt_version(void);
 
     void register_argtype(const char *name, void(*free_arg) (variant),
         variant(*copy_arg) (variant), variant_type);
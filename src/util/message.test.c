@@ -4,6 +4,8 @@
 #include <tests.h>
 
 #include <stddef.h>   // for NULL
+#include <stdint.h>
+#include <string.h>
 
 static void test_mt_new(CuTest *tc)
 {
@@ -22,9 +24,34 @@ static void test_mt_new(CuTest *tc)
     test_teardown();
 }
 
+static void test_msg_arena_alloc(CuTest *tc)
+{
+    char *small, *large, *next;
+    int i;
+
+    test_setup();
+    msg_arena_open();
+    small = msg_arena_alloc(100);
+    memset(small, 'a', 100);
+    /* larger than the first block, and than the second */
+    large = msg_arena_alloc(100000);
+    memset(large, 'b', 100000);
+    for (i = 0; i != 1000; ++i) {
+        next = msg_arena_alloc(10);
+        CuAssertIntEquals(tc, 0, (int)((uintptr_t)next % sizeof(void *)));
+        memset(next, 'c', 10);
+    }
+    CuAssertIntEquals(tc, 'a', small[99]);
+    CuAssertIntEquals(tc, 'b', large[0]);
+    CuAssertIntEquals(tc, 'b', large[99999]);
+    msg_arena_close();
+    test_teardown();
+}
+
 CuSuite *get_message_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, test_mt_new);
+    SUITE_ADD_TEST(suite, test_msg_arena_alloc);
     return suite;
 }
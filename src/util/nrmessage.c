@@ -4,29 +4,124 @@
 #include "log.h"
 #include "message.h"
 #include "language.h"
+#include "macros.h"
 #include "translation.h"
 #include "strings.h"
+#include "workers.h"
+
+#include <stb_ds.h>
 
 /* libc includes */
 #include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
+/* The template of a message type is compiled once for each locale. A
+ * program is valid while cache_key matches nrt_key() of its locale, so
+ * it is compiled again when a translation of that locale, or of the
+ * default locale it falls back to, is added or replaced. */
 typedef struct nrmessage_type {
     const struct message_type *mtype;
     char *vars;
+    int cache_key[MAXLOCALES];
+    struct tprogram *programs[MAXLOCALES];
     struct nrmessage_type *next;
 } nrmessage_type;
 
 #define NRT_MAXHASH 1021
 static nrmessage_type *nrtypes[NRT_MAXHASH] = { 0 };
 
+/* the nrt_key of each locale when nrt_compile last compiled it */
+static int compiled_key[MAXLOCALES];
+
+/* Rendered text of shared arena messages, by message and locale. Text
+ * that many factions receive is rendered once per locale and thread.
+ * Each thread has its own cache, so lookups take no lock. A cache belongs
+ * to one arena, and is emptied when a new one is opened, since its
+ * messages and their addresses do not outlive it. */
+typedef struct render_key {
+    const struct message *msg;
+    const struct locale *lang;
+} render_key;
+
+typedef struct render_entry {
+    render_key key;
+    char *value;
+} render_entry;
+
+static THREAD_LOCAL render_entry *render_cache;
+static THREAD_LOCAL int render_arena;
+
+static void render_clear(void)
+{
+    ptrdiff_t i, len = hmlen(render_cache);
+    for (i = 0; i != len; ++i) {
+        free(render_cache[i].value);
+    }
+    hmfree(render_cache);
+}
+
+/* The viewer is passed to the template functions, and most of them only
+ * use its locale, which is the lang we render for. A message that only
+ * one faction received is rendered once anyway, and not worth a copy. */
+static bool render_cacheable(const struct message *msg, const void *userdata)
+{
+    int i;
+    if (!msg->in_arena || !msg->shared || !userdata) {
+        return false;
+    }
+    for (i = 0; i != msg->type->nparameters; ++i) {
+        if (msg->type->types[i]->flags & ARG_VIEWER) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const char *render_find(const struct message *msg, const struct locale *lang)
+{
+    const char *result = NULL;
+    render_key key;
+    ptrdiff_t i;
+
+    key.msg = msg;
+    key.lang = lang;
+    if (render_arena != msg_arena_id()) {
+        render_clear();
+        render_arena = msg_arena_id();
+    }
+    i = hmgeti(render_cache, key);
+    if (i >= 0) {
+        result = render_cache[i].value;
+    }
+    return result;
+}
+
+static void render_store(const struct message *msg, const struct locale *lang, const char *text)
+{
+    render_key key;
+
+    key.msg = msg;
+    key.lang = lang;
+    if (render_arena == msg_arena_id() && hmgeti(render_cache, key) < 0) {
+        hmput(render_cache, key, str_strdup(text));
+    }
+}
+
 void free_nrmesssages(void) {
     int i;
+    render_clear();
+    memset(compiled_key, 0, sizeof(compiled_key));
     for (i = 0; i != NRT_MAXHASH; ++i) {
         while (nrtypes[i]) {
             nrmessage_type *nr = nrtypes[i];
+            int l;
             nrtypes[i] = nr->next;
+            for (l = 0; l != MAXLOCALES; ++l) {
+                translate_free(nr->programs[l]);
+            }
             free(nr->vars);
             free(nr);
         }
@@ -81,6 +176,7 @@ nrt_register(const struct message_type *mtype)
         char *c = zNames;
         nrt = calloc(1, sizeof(nrmessage_type));
         if (!nrt) abort();
+        memset(compiled_key, 0, sizeof(compiled_key));
         nrt->mtype = mtype;
         nrt->next = nrtypes[hash];
         nrtypes[hash] = nrt;
@@ -95,6 +191,69 @@ nrt_register(const struct message_type *mtype)
     }
 }
 
+/* Translations do not change while workers run, so every program is
+ * compiled at most once per parallel section, under the lock. Renders
+ * that find it compiled for the current version do not lock. */
+/* locale versions only ever grow, so the larger of the two changes
+ * whenever either of them does */
+static int nrt_key(const struct locale *lang)
+{
+    int key = locale_version(lang);
+    if (default_locale && default_locale != lang) {
+        int fallback = locale_version(default_locale);
+        if (fallback > key) {
+            key = fallback;
+        }
+    }
+    return key;
+}
+
+static const struct tprogram *nrt_program(nrmessage_type *nrt, const struct locale *lang)
+{
+    unsigned int l = locale_index(lang);
+    int key = nrt_key(lang);
+
+    if (WORKERS_LOAD_ACQUIRE(nrt->cache_key + l) != key) {
+        workers_lock();
+        if (nrt->cache_key[l] != key) {
+            translate_free(nrt->programs[l]);
+            nrt->programs[l] = translate_compile(nrt_string(nrt->mtype, lang), nrt->vars);
+            WORKERS_STORE_RELEASE(nrt->cache_key + l, key);
+        }
+        workers_unlock();
+    }
+    return nrt->programs[l];
+}
+
+void nrt_compile(void)
+{
+    int i;
+
+    const struct locale *lang;
+
+    assert(!workers_active());
+    workers_atexit(render_clear);
+    /* only locales that changed since the last call are compiled again */
+    for (lang = locales; lang; lang = nextlocale(lang)) {
+        unsigned int l = locale_index(lang);
+        int key = nrt_key(lang);
+        if (compiled_key[l] == key) {
+            continue;
+        }
+        for (i = 0; i != NRT_MAXHASH; ++i) {
+            nrmessage_type *nrt;
+            for (nrt = nrtypes[i]; nrt; nrt = nrt->next) {
+                /* types without any text are never rendered */
+                if (locale_getstring(lang, nrt->mtype->name)
+                    || locale_getstring(default_locale, nrt->mtype->name)) {
+                    nrt_program(nrt, lang);
+                }
+            }
+        }
+        compiled_key[l] = key;
+    }
+}
+
 size_t
 nr_render(const struct message *msg, const struct locale *lang, char *buffer,
 size_t size, const void *userdata)
@@ -102,9 +261,22 @@ size_t size, const void *userdata)
     struct nrmessage_type *nrt = nrt_find(msg->type);
 
     if (nrt) {
-        const char *m =
-            translate(nrt_string(msg->type, lang), userdata, nrt->vars, msg->parameters);
+        bool cache = render_cacheable(msg, userdata);
+        const struct tprogram *prog;
+        const char *m;
+
+        if (cache) {
+            m = render_find(msg, lang);
+            if (m) {
+                return str_strlcpy((char *)buffer, m, size);
+            }
+        }
+        prog = nrt_program(nrt, lang);
+        m = prog ? translate_run(prog, userdata, msg->parameters) : NULL;
         if (m) {
+            if (cache) {
+                render_store(msg, lang, m);
+            }
             return str_strlcpy((char *)buffer, m, size);
         }
         else {
@@ -19,6 +19,11 @@ extern "C" {
     const char *nrt_string(const struct message_type *mtype,
             const struct locale *lang);
 
+    /* compile the templates of all types for every locale, so that
+     * reports written on the worker pool find them ready, and have the
+     * workers free their render caches when they exit */
+    void nrt_compile(void);
+
     size_t nr_render(const struct message *msg, const struct locale *lang,
         char *buffer, size_t size, const void *userdata);
 
@@ -3,9 +3,13 @@
 #include "unicode.h"
 #include "base36.h"
 #include "log.h"
+#include "macros.h"
+
+#include <stb_ds.h>
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wctype.h>
 #include <memory.h>
 
@@ -15,12 +19,13 @@
 
 typedef struct parse_state {
     const char *current_token;
+    const char *end; /* end of a token_list, or NULL for plain strings */
     struct parse_state *next;
     void *data;
     void(*dtor)(void *);
 } parse_state;
 
-static parse_state *states;
+static THREAD_LOCAL parse_state *states;
 
 void init_tokens_ex(const char *initstr, void *data, void (*dtor)(void *))
 {
@@ -34,6 +39,13 @@ void init_tokens_ex(const char *initstr, void *data, void (*dtor)(void *))
     states->dtor = dtor;
     states->data = data;
     states->current_token = initstr;
+    states->end = NULL;
+}
+
+void init_tokens_list(const token_list *tokens)
+{
+    init_tokens_ex(tokens->begin, NULL, NULL);
+    states->end = tokens->end;
 }
 
 void init_tokens_str(const char *initstr) {
@@ -61,6 +73,9 @@ void parser_popstate(void)
 
 bool parser_end(void)
 {
+    if (states->end) {
+        return states->current_token >= states->end;
+    }
     if (states->current_token) {
         if (NULL != (states->current_token = utf8_ltrim(states->current_token))) {
             return 0 == *states->current_token;
@@ -73,6 +88,12 @@ void skip_token(void)
 {
     char quotechar = 0;
 
+    if (states->end) {
+        if (states->current_token < states->end) {
+            states->current_token += strlen(states->current_token) + 1;
+        }
+        return;
+    }
     if (NULL != (states->current_token = utf8_ltrim(states->current_token)))
     {
         while (*states->current_token)
@@ -208,19 +229,66 @@ char *parse_token(const char **str, char *lbuf, size_t buflen)
     return lbuf;
 }
 
-static char pbuf[MAXTOKENSIZE];       /* STATIC_RESULT: used for return, not across calls */
+static THREAD_LOCAL char pbuf[MAXTOKENSIZE];       /* STATIC_RESULT: used for return, not across calls */
 const char *parse_token_depr(const char **str)
 {
     return parse_token(str, pbuf, MAXTOKENSIZE);
 }
 
+token_list *tokenize(const char *str)
+{
+    char token[MAXTOKENSIZE];
+    char *buffer = NULL;
+    token_list *result;
+    size_t size;
+
+    while (parse_token(&str, token, sizeof(token))) {
+        size_t len = strlen(token) + 1;
+        memcpy(arraddnptr(buffer, len), token, len);
+    }
+    size = arrlen(buffer);
+    result = malloc(sizeof(token_list) + size);
+    if (!result) abort();
+    result->begin = (const char *)(result + 1);
+    result->end = result->begin + size;
+    if (size > 0) {
+        memcpy(result + 1, buffer, size);
+    }
+    arrfree(buffer);
+    return result;
+}
+
+static char *next_token(char *lbuf, size_t bufsize)
+{
+    const char *str = states->current_token;
+    size_t len;
+
+    if (str >= states->end) {
+        if (bufsize > 0) {
+            lbuf[0] = '\0';
+        }
+        return NULL;
+    }
+    len = strlen(str);
+    states->current_token = str + len + 1;
+    if (len >= bufsize) {
+        len = bufsize - 1;
+    }
+    memcpy(lbuf, str, len);
+    lbuf[len] = '\0';
+    return lbuf;
+}
+
 char *getstrtoken(void)
 {
-    return parse_token((const char **)&states->current_token, pbuf, MAXTOKENSIZE);
+    return gettoken(pbuf, MAXTOKENSIZE);
 }
 
 char *gettoken(char *lbuf, size_t bufsize)
 {
+    if (states->end) {
+        return next_token(lbuf, bufsize);
+    }
     return parse_token((const char **)&states->current_token, lbuf, bufsize);
 }
 
@@ -8,6 +8,17 @@
 extern "C" {
 #endif
 
+    /* A string that has been split into tokens ahead of time, with quotes
+     * and escapes already resolved. The tokens are stored back to back as
+     * zero-terminated strings in [begin, end). */
+    typedef struct token_list {
+        const char *begin;
+        const char *end;
+    } token_list;
+
+    token_list *tokenize(const char *str);
+    void init_tokens_list(const token_list *tokens);
+
     void init_tokens_ex(const char *initstr, void *data, void(*dtor)(void *));
     void init_tokens_str(const char *initstr);  /* initialize token parsing */
     void skip_token(void);
@@ -1,6 +1,7 @@
 #include "parser.h"
 
 #include <string.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <CuTest.h>
 
@@ -163,6 +164,36 @@ static void test_getstrtoken(CuTest *tc) {
     CuAssertPtrEquals(tc, NULL, (void *)getstrtoken());
 }
 
+static void test_tokenize(CuTest *tc) {
+    char token[3];
+    token_list *tokens;
+
+    tokens = tokenize("  HELP 'ONE TWO' THREE~FOUR ii 42 ");
+    init_tokens_list(tokens);
+    CuAssertTrue(tc, !parser_end());
+    CuAssertStrEquals(tc, "HELP", getstrtoken());
+    CuAssertStrEquals(tc, "ONE TWO", getstrtoken());
+    CuAssertStrEquals(tc, "TH", gettoken(token, sizeof(token)));
+    CuAssertIntEquals(tc, 666, getid());
+    CuAssertIntEquals(tc, 42, getint());
+    CuAssertTrue(tc, parser_end());
+    CuAssertPtrEquals(tc, NULL, (void *)getstrtoken());
+
+    init_tokens_list(tokens);
+    skip_token();
+    skip_token();
+    CuAssertStrEquals(tc, "THREE FOUR", getstrtoken());
+    init_tokens_str(NULL);
+    free(tokens);
+
+    tokens = tokenize("");
+    init_tokens_list(tokens);
+    CuAssertTrue(tc, parser_end());
+    CuAssertPtrEquals(tc, NULL, (void *)getstrtoken());
+    init_tokens_str(NULL);
+    free(tokens);
+}
+
 CuSuite *get_parser_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
@@ -178,5 +209,6 @@ CuSuite *get_parser_suite(void)
     SUITE_ADD_TEST(suite, test_gettoken_short);
     SUITE_ADD_TEST(suite, test_getintegers);
     SUITE_ADD_TEST(suite, test_getstrtoken);
+    SUITE_ADD_TEST(suite, test_tokenize);
     return suite;
 }
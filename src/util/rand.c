@@ -2,6 +2,7 @@
 #define _USE_MATH_DEFINES
 #endif
 #include "rand.h"
+#include "macros.h"
 #include "mtrand.h"
 #include "rng.h"
 
@@ -20,10 +21,13 @@ int lovar(double xpct_x2)
  * taken from http://c-faq.com/lib/gaussian.html
  */
 
+/* the second number of each pair belongs to the stream that drew it,
+ * so binding a stream starts a new pair */
+static THREAD_LOCAL double U, V;
+static THREAD_LOCAL int phase = 0;
+
 double normalvariate(double mu, double sigma)
 {
-    static double U, V;
-    static int phase = 0;
     double Z;
 
     if (phase == 0) {
@@ -67,18 +71,72 @@ typedef struct random_source {
 
 random_source *r_source = 0;
 
+static unsigned int stream_seed;
+static THREAD_LOCAL rng_stream *stream;
+
+/* splitmix64 finalizer */
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t stream_next(rng_stream *rs) {
+    return mix64(rs->key + 0x9e3779b97f4a7c15ULL * ++rs->counter);
+}
+
+void rng_seed(unsigned int seed) {
+    stream_seed = seed;
+    init_genrand(seed);
+}
+
+void rng_stream_init(rng_stream *rs, int step, int id) {
+    uint64_t key = mix64(stream_seed);
+    key = mix64(key ^ (uint32_t)step);
+    rs->key = mix64(key ^ (uint32_t)id);
+    rs->counter = 0;
+}
+
+void rng_stream_begin(rng_stream *rs) {
+    stream = rs;
+    phase = 0;
+}
+
+void rng_stream_end(void) {
+    stream = NULL;
+    phase = 0;
+}
+
+bool rng_stream_active(void) {
+    return stream != NULL;
+}
+
 double rng_injectable_double(void) {
     if (r_source && r_source->double_source)
         return r_source->double_source();
+    if (stream) {
+        /* 53 random bits in [0,1) */
+        return (double)(stream_next(stream) >> 11) * (1.0 / 9007199254740992.0);
+    }
     return genrand_real2();
 }
 
 int rng_injectable_int(void) {
     if (r_source && r_source->int32_source)
         return r_source->int32_source();
+    if (stream) {
+        return (int)(stream_next(stream) >> 33);
+    }
     return (int)genrand_int31();
 }
 
+unsigned int rng_injectable_uint(void) {
+    if (stream) {
+        return (unsigned int)(stream_next(stream) >> 32);
+    }
+    return (unsigned int)genrand_int32();
+}
+
 static double constant_value_double;
 static int constant_value_int32;
 
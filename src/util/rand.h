@@ -3,6 +3,7 @@
 #define RAND_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +29,23 @@ extern "C" {
     void random_source_inject_constant(double value);
     void random_source_reset(void);
 
+    /* Independent random streams. A stream is keyed by the turn seed
+     * (see rng_seed), a processing step and an object id, usually a
+     * region uid. Its output depends only on that key and the number of
+     * draws made from it, so regions (or battles) can be evaluated in any
+     * order or in parallel, and replayed in isolation.
+     * While a stream is active on a thread, rng_int, rng_uint and
+     * rng_double draw from it instead of the global generator. */
+    typedef struct rng_stream {
+        uint64_t key;
+        uint64_t counter;
+    } rng_stream;
+
+    void rng_stream_init(rng_stream *rs, int step, int id);
+    void rng_stream_begin(rng_stream *rs);
+    void rng_stream_end(void);
+    bool rng_stream_active(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,5 @@
 #include "rand.h"
+#include "rng.h"
 #include "tests.h"
 
 #include <CuTest.h>
@@ -22,9 +23,105 @@ static void test_dice_rand(CuTest* tc)
     CuAssertIntEquals(tc, -6, dice_rand("-3*2"));
 }
 
+static void test_rng_stream(CuTest* tc)
+{
+    rng_stream rs1, rs2;
+    int i, a[8], same = 0;
+
+    test_setup();
+    rng_init(42);
+    rng_stream_init(&rs1, 10, 1234);
+    rng_stream_begin(&rs1);
+    CuAssertTrue(tc, rng_stream_active());
+    for (i = 0; i != 8; ++i) {
+        a[i] = rng_int();
+        CuAssertTrue(tc, a[i] >= 0);
+    }
+    rng_stream_end();
+    CuAssertTrue(tc, !rng_stream_active());
+
+    /* draws from the global generator do not disturb a stream */
+    rng_int();
+    rng_stream_init(&rs2, 10, 1234);
+    rng_stream_begin(&rs2);
+    for (i = 0; i != 8; ++i) {
+        CuAssertIntEquals(tc, a[i], rng_int());
+    }
+    rng_stream_end();
+
+    /* a different id gives a different sequence */
+    rng_stream_init(&rs2, 10, 1235);
+    rng_stream_begin(&rs2);
+    for (i = 0; i != 8; ++i) {
+        if (a[i] == rng_int()) ++same;
+    }
+    rng_stream_end();
+    CuAssertTrue(tc, same < 8);
+
+    /* so does a different turn seed */
+    same = 0;
+    rng_init(43);
+    rng_stream_init(&rs2, 10, 1234);
+    rng_stream_begin(&rs2);
+    for (i = 0; i != 8; ++i) {
+        double d = rng_double();
+        CuAssertTrue(tc, d >= 0.0 && d < 1.0);
+    }
+    rng_stream_end();
+    rng_stream_init(&rs2, 10, 1234);
+    rng_stream_begin(&rs2);
+    for (i = 0; i != 8; ++i) {
+        if (a[i] == rng_int()) ++same;
+    }
+    rng_stream_end();
+    CuAssertTrue(tc, same < 8);
+    test_teardown();
+}
+
+static void test_normalvariate_stream(CuTest* tc)
+{
+    rng_stream rs;
+    double x;
+
+    test_setup();
+    rng_init(42);
+    rng_stream_init(&rs, 10, 1234);
+    rng_stream_begin(&rs);
+    x = normalvariate(100.0, 10.0);
+    rng_stream_end();
+
+    /* a pair left half used by another stream is not carried over */
+    rng_stream_init(&rs, 10, 1235);
+    rng_stream_begin(&rs);
+    normalvariate(100.0, 10.0);
+    rng_stream_end();
+    rng_stream_init(&rs, 10, 1234);
+    rng_stream_begin(&rs);
+    CuAssertDblEquals(tc, x, normalvariate(100.0, 10.0), 0.0);
+    rng_stream_end();
+    test_teardown();
+}
+
+static void test_rng_stream_injected(CuTest* tc)
+{
+    rng_stream rs;
+
+    test_setup();
+    random_source_inject_constants(0.5, 7);
+    rng_stream_init(&rs, 1, 1);
+    rng_stream_begin(&rs);
+    CuAssertIntEquals(tc, 7, rng_int());
+    CuAssertDblEquals(tc, 0.5, rng_double(), 0.0);
+    rng_stream_end();
+    test_teardown();
+}
+
 CuSuite *get_rand_suite(void)
 {
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, test_dice_rand);
+    SUITE_ADD_TEST(suite, test_rng_stream);
+    SUITE_ADD_TEST(suite, test_normalvariate_stream);
+    SUITE_ADD_TEST(suite, test_rng_stream_injected);
     return suite;
 }
@@ -3,12 +3,14 @@
 /* generates a random number on [0,1)-real-interval */
 double rng_injectable_double(void);
 int rng_injectable_int(void);
+unsigned int rng_injectable_uint(void);
+void rng_seed(unsigned int seed);
 
 #ifdef RNG_MT
 # include "mtrand.h"
-# define rng_init(seed) init_genrand(seed)
+# define rng_init(seed) rng_seed(seed)
 # define rng_int rng_injectable_int
-# define rng_uint (unsigned int)genrand_int32
+# define rng_uint rng_injectable_uint
 # define rng_double rng_injectable_double
 # define RNG_RAND_MAX 0x7fffffff
 #else
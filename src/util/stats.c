@@ -3,6 +3,7 @@
 #include "path.h"
 #include "strings.h"
 #include "unicode.h"
+#include "workers.h"
 
 #include <critbit.h>
 
@@ -19,18 +20,22 @@ static critbit_tree stats = CRITBIT_TREE();
 
 int stats_count(const char* stat, int delta) {
     void* match;
+    int result;
+    workers_lock();
     if (cb_find_prefix_str(&stats, stat, &match, 1, 0) == 0) {
         size_t len;
         char data[128];
         len = cb_new_kv(stat, strlen(stat), &delta, sizeof(delta), data);
         cb_insert(&stats, data, len);
-        return delta;
+        result = delta;
     }
     else {
         int* num;
         cb_get_kv_ex(match, (void**)&num);
-        return *num += delta;
+        result = (*num += delta);
     }
+    workers_unlock();
+    return result;
 }
 
 struct walk_data {
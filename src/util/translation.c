@@ -4,8 +4,11 @@
 #include "critbit.h"
 #include "log.h"
 #include "macros.h"
+#include "workers.h"
 #include "assert.h"
 
+#include <stb_ds.h>
+
  /* libc includes */
 #include <ctype.h>
 #include <string.h>
@@ -60,7 +63,7 @@ void opstack_push(opstack ** stackp, variant data)
  **/
 
 #define BBUFSIZE 0x10000
-static struct {
+static THREAD_LOCAL struct {
     char *begin;
     char *handle_end;
     char *last;
@@ -69,9 +72,7 @@ static struct {
 
 char *balloc(size_t size)
 {
-    static int init = 0;
-    if (!init) {
-        init = 1;
+    if (!buffer.begin) {
         buffer.current = buffer.begin = malloc(BBUFSIZE * sizeof(char));
         buffer.handle_end = buffer.begin + BBUFSIZE;
     }
@@ -97,46 +98,7 @@ void brelease(void)
 }
 
 /**
- ** constant values
- **/
-
-typedef struct variable {
-    struct variable *next;
-    const char *symbol;
-    variant value;
-} variable;
-
-static variable *variables;
-
-static void free_variables(void)
-{
-    variables = NULL;
-}
-
-static void add_variable(const char *symbol, variant value)
-{
-    variable *var = (variable *)balloc(sizeof(variable));
-
-    var->value = value;
-    var->symbol = symbol;
-
-    var->next = variables;
-    variables = var;
-}
-
-static variable *find_variable(const char *symbol)
-{
-    variable *var = variables;
-    while (var) {
-        if (!strcmp(var->symbol, symbol))
-            break;
-        var = var->next;
-    }
-    return var;
-}
-
-/**
- ** constant values
+ ** functions
  **/
 
 static struct critbit_tree functions = { 0 };
@@ -168,14 +130,101 @@ static evalfun find_function(const char *symbol)
     return 0;
 }
 
-static const char *parse(opstack **, const char *in, const void *);
-/* static const char * sample = "\"enno and $bool($if($eq($i,0),\"noone else\",\"$i other people\"))\""; */
+/**
+ ** template compiler
+ **
+ ** A template is compiled once into a sequence of stack machine
+ ** instructions. Variables are resolved to argument indices and functions
+ ** to their evalfun, so rendering does not look at the template text.
+ **/
+
+/* sample: "\"enno and $bool($if($eq($i,0),\"noone else\",\"$i other people\"))\"" */
+
+enum {
+    OP_INT,      /* push arg.i */
+    OP_VAR,      /* push args[arg.i] */
+    OP_CALL,     /* call arg.fun, it pops its parameters and pushes a result */
+    OP_STRING,   /* start a new string */
+    OP_TEXT,     /* append len bytes of literal text, starting at text + arg.i */
+    OP_APPEND,   /* pop a string and append it to the current string */
+    OP_END       /* finish the current string and push it */
+};
+
+typedef struct instruction {
+    int op;
+    size_t len;
+    union {
+        int i;
+        evalfun fun;
+    } arg;
+} instruction;
+
+struct tprogram {
+    instruction *code;
+    char *text;
+};
+
+/* strings can be nested this deep, e.g. inside of $if() parameters */
+#define MAXNESTING 16
+#define TOKENSIZE 4096
+
+typedef struct variable {
+    const char *symbol;
+    size_t len;
+} variable;
+
+typedef struct compiler {
+    struct tprogram *prog;
+    variable *variables;
+} compiler;
+
+static void emit(compiler *c, int op, int i)
+{
+    instruction *ins = arraddnptr(c->prog->code, 1);
+    ins->op = op;
+    ins->len = 0;
+    ins->arg.i = i;
+}
+
+static void emit_call(compiler *c, evalfun fun)
+{
+    instruction *ins = arraddnptr(c->prog->code, 1);
+    ins->op = OP_CALL;
+    ins->len = 0;
+    ins->arg.fun = fun;
+}
 
-static const char *parse_symbol(opstack ** stack, const char *in,
-    const void *userdata)
-    /* in is the symbol name and following text, starting after the $
-     * result goes on the stack
-     */
+static void emit_text(compiler *c, char ch)
+{
+    struct tprogram *prog = c->prog;
+    ptrdiff_t ncode = arrlen(prog->code);
+
+    if (ncode == 0 || prog->code[ncode - 1].op != OP_TEXT) {
+        emit(c, OP_TEXT, (int)arrlen(prog->text));
+        ++ncode;
+    }
+    arrput(prog->text, ch);
+    ++prog->code[ncode - 1].len;
+}
+
+static int find_variable(const compiler *c, const char *symbol)
+{
+    /* later declarations hide earlier ones */
+    size_t len = strlen(symbol);
+    ptrdiff_t i = arrlen(c->variables);
+    while (i-- > 0) {
+        const variable *var = c->variables + i;
+        if (var->len == len && strncmp(var->symbol, symbol, len) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static const char *compile(compiler *c, const char *in, int depth);
+
+static const char *compile_symbol(compiler *c, const char *in, int depth)
+    /* in is the symbol name and following text, starting after the $ */
 {
     bool braces = false;
     char symbol[32]; /* Flawfinder: ignore */
@@ -192,11 +241,11 @@ static const char *parse_symbol(opstack ** stack, const char *in,
     *cp = '\0';
     /* symbol will now contain the symbol name */
     if (*in == '(') {
-        /* it's a function we need to parse, start by reading the parameters */
+        /* it's a function, its parameters are evaluated first */
         evalfun foo;
 
         while (*in != ')') {
-            in = parse(stack, ++in, userdata);        /* will push the result on the stack */
+            in = compile(c, ++in, depth);
             if (in == NULL)
                 return NULL;
         }
@@ -206,65 +255,50 @@ static const char *parse_symbol(opstack ** stack, const char *in,
             log_error("parser does not know about \"%s\" function.\n", symbol);
             return NULL;
         }
-        foo(stack, userdata);        /* will pop parameters from stack (reverse order!) and push the result */
+        emit_call(c, foo);
     }
     else {
-        variable *var = find_variable(symbol);
+        int i = find_variable(c, symbol);
         if (braces && *in == '}') {
             ++in;
         }
-        /* it's a constant (variable is a misnomer, but heck, const was taken;)) */
-        if (var == NULL) {
+        if (i < 0) {
             log_error("parser does not know about \"%s\" variable.\n", symbol);
             return NULL;
         }
-        opush(stack, var->value);
+        emit(c, OP_VAR, i);
     }
     return in;
 }
 
-#define TOKENSIZE 4096
-static const char *parse_string(opstack ** stack, const char *in,
-    const void *userdata)
-{                               /* (char*) -> char* */
-    char *c;
-    char *buffer = balloc(TOKENSIZE);
-    size_t size = TOKENSIZE - 1;
+static const char *compile_string(compiler *c, const char *in, int depth)
+{
     const char *ic = in;
-    char *oc = buffer;
     /* mode flags */
     bool f_escape = false;
     bool bDone = false;
-    variant var;
 
+    if (depth >= MAXNESTING) {
+        log_error("strings are nested too deeply: %s", in);
+        return NULL;
+    }
+    emit(c, OP_STRING, 0);
     while (*ic && !bDone) {
         if (f_escape) {
             f_escape = false;
             switch (*ic) {
             case 'n':
-                if (size > 0) {
-                    *oc++ = '\n';
-                    --size;
-                }
+                emit_text(c, '\n');
                 break;
             case 't':
-                if (size > 0) {
-                    *oc++ = '\t';
-                    --size;
-                }
+                emit_text(c, '\t');
                 break;
             default:
-                if (size > 0) {
-                    *oc++ = *ic++;
-                    --size;
-                }
+                emit_text(c, *ic++);
             }
         }
         else {
-            int ch = (unsigned char)(*ic);
-            size_t bytes;
-
-            switch (ch) {
+            switch (*ic) {
             case '\\':
                 f_escape = true;
                 ++ic;
@@ -274,40 +308,25 @@ static const char *parse_string(opstack ** stack, const char *in,
                 ++ic;
                 break;
             case '$':
-                ic = parse_symbol(stack, ++ic, userdata);
+                ic = compile_symbol(c, ++ic, depth + 1);
                 if (ic == NULL)
                     return NULL;
-                c = (char *)opop_v(stack);
-                bytes = (c ? str_strlcpy(oc, c, size) : 0);
-                if (bytes < size)
-                    oc += bytes;
-                else
-                    oc += size;
-                bfree(c);
+                emit(c, OP_APPEND, 0);
                 break;
             default:
-                if (size > 0) {
-                    *oc++ = *ic++;
-                    --size;
-                }
-                else
-                    ++ic;
+                emit_text(c, *ic++);
             }
         }
     }
-    *oc++ = '\0';
-    bfree(oc);
-    var.v = buffer;
-    opush(stack, var);
+    emit(c, OP_END, 0);
     return ic;
 }
 
-static const char *parse_int(opstack ** stack, const char *in)
+static const char *compile_int(compiler *c, const char *in)
 {
     int k = 0;
     int vz = 1;
     bool ok = false;
-    variant var;
     do {
         switch (*in) {
         case '+':
@@ -324,26 +343,24 @@ static const char *parse_int(opstack ** stack, const char *in)
     while (isdigit(*(unsigned char *)in)) {
         k = k * 10 + (*in++) - '0';
     }
-    var.i = k * vz;
-    opush(stack, var);
+    emit(c, OP_INT, k * vz);
     return in;
 }
 
-static const char *parse(opstack ** stack, const char *inn,
-    const void *userdata)
+static const char *compile(compiler *c, const char *inn, int depth)
 {
     const char *b = inn;
     while (*b) {
         switch (*b) {
         case '"':
-            return parse_string(stack, ++b, userdata);
+            return compile_string(c, ++b, depth);
             break;
         case '$':
-            return parse_symbol(stack, ++b, userdata);
+            return compile_symbol(c, ++b, depth);
             break;
         default:
             if (isdigit(*(const unsigned char *)b) || *b == '-' || *b == '+') {
-                return parse_int(stack, b);
+                return compile_int(c, b);
             }
             else
                 ++b;
@@ -353,50 +370,138 @@ static const char *parse(opstack ** stack, const char *inn,
     return NULL;
 }
 
-const char *translate(const char *format, const void *userdata,
-    const char *vars, variant args[])
+struct tprogram *translate_compile(const char *format, const char *vars)
 {
-    unsigned int i = 0;
+    compiler c;
     const char *ic = vars;
-    char symbol[32]; /* Flawfinder: ignore */
-    char *oc = symbol;
-    opstack *stack = NULL;
     const char *rv;
 
-    brelease();
-    free_variables();
-
     assert(format);
     assert(*ic == 0 || isalnum(*ic));
+    c.variables = NULL;
     while (*ic) {
-        *oc++ = *ic++;
-        assert(oc < symbol + sizeof(symbol));
-        if (!isalnum(*ic)) {
-            size_t len;
-            variant x = args[i++];
-            *oc = '\0';
-            len = oc - symbol + 1;
-            str_strlcpy(oc = balloc(len), symbol, len);
-            add_variable(oc, x);
-            oc = symbol;
-            while (*ic && !isalnum(*ic))
-                ++ic;
+        variable *var = arraddnptr(c.variables, 1);
+        var->symbol = ic++;
+        while (isalnum(*ic)) {
+            ++ic;
         }
+        var->len = ic - var->symbol;
+        while (*ic && !isalnum(*ic))
+            ++ic;
     }
 
+    c.prog = calloc(1, sizeof(struct tprogram));
+    if (!c.prog) abort();
     if (format[0] == '"') {
-        rv = parse(&stack, format, userdata);
+        rv = compile(&c, format, 0);
     }
     else {
-        rv = parse_string(&stack, format, userdata);
+        rv = compile_string(&c, format, 0);
+    }
+    arrfree(c.variables);
+    if (rv == NULL) {
+        translate_free(c.prog);
+        return NULL;
+    }
+    if (rv[0]) {
+        log_error("residual data after parsing: %s\n", rv);
+    }
+    return c.prog;
+}
+
+void translate_free(struct tprogram *prog)
+{
+    if (prog) {
+        arrfree(prog->code);
+        arrfree(prog->text);
+        free(prog);
+    }
+}
+
+/**
+ ** template interpreter
+ **/
+
+typedef struct strbuilder {
+    char *begin;
+    char *cursor;
+    size_t avail;
+} strbuilder;
+
+static void sb_append(strbuilder *sb, const char *str, size_t len)
+{
+    if (len > sb->avail) {
+        len = sb->avail;
+    }
+    memcpy(sb->cursor, str, len);
+    sb->cursor += len;
+    sb->avail -= len;
+}
+
+/* the operand stack is reused by every call on the same thread */
+static THREAD_LOCAL opstack *op_stack;
+
+const char *translate_run(const struct tprogram *prog, const void *userdata,
+    variant args[])
+{
+    strbuilder strings[MAXNESTING];
+    strbuilder *sb = NULL;
+    const instruction *ip = prog->code;
+    const instruction *end = ip + arrlen(prog->code);
+    variant var;
+
+    brelease();
+    if (op_stack) {
+        op_stack->top = op_stack->begin;
     }
-    if (rv != NULL) {
-        if (rv[0]) {
-            log_error("residual data after parsing: %s\n", rv);
+    for (; ip != end; ++ip) {
+        switch (ip->op) {
+        case OP_INT:
+            opush_i(&op_stack, ip->arg.i);
+            break;
+        case OP_VAR:
+            opush(&op_stack, args[ip->arg.i]);
+            break;
+        case OP_CALL:
+            ip->arg.fun(&op_stack, userdata);
+            break;
+        case OP_STRING:
+            sb = sb ? sb + 1 : strings;
+            assert(sb < strings + MAXNESTING);
+            sb->cursor = sb->begin = balloc(TOKENSIZE);
+            sb->avail = TOKENSIZE - 1;
+            break;
+        case OP_TEXT:
+            sb_append(sb, prog->text + ip->arg.i, ip->len);
+            break;
+        case OP_APPEND:
+            var = opop(&op_stack);
+            if (var.v) {
+                sb_append(sb, (const char *)var.v, strlen((const char *)var.v));
+            }
+            bfree((char *)var.v);
+            break;
+        case OP_END:
+            *sb->cursor++ = '\0';
+            bfree(sb->cursor);
+            var.v = sb->begin;
+            opush(&op_stack, var);
+            sb = (sb == strings) ? NULL : sb - 1;
+            break;
         }
-        rv = (const char *)opop(&stack).v;
-        free(stack->begin);
-        free(stack);
+    }
+    return (const char *)opop(&op_stack).v;
+}
+
+const char *translate(const char *format, const void *userdata,
+    const char *vars, variant args[])
+{
+    struct tprogram *prog = translate_compile(format, vars);
+    const char *rv = NULL;
+
+    if (prog) {
+        rv = translate_run(prog, userdata, args);
+        translate_free(prog);
     }
     return rv;
 }
@@ -455,8 +560,20 @@ static void eval_int(opstack ** stack, const void *userdata)
     opush(stack, var);
 }
 
+static void translation_free_buffers(void)
+{
+    free(buffer.begin);
+    buffer.begin = buffer.current = buffer.last = buffer.handle_end = NULL;
+    if (op_stack) {
+        free(op_stack->begin);
+        free(op_stack);
+        op_stack = NULL;
+    }
+}
+
 void translation_init(void)
 {
+    workers_atexit(translation_free_buffers);
     add_function("lt", &eval_lt);
     add_function("eq", &eval_eq);
     add_function("int", &eval_int);
@@ -468,5 +585,5 @@ void translation_init(void)
 void translation_done(void)
 {
     free_functions();
-    free(buffer.begin);
+    translation_free_buffers();
 }
@@ -7,6 +7,7 @@
 #include "variant.h"
 
 struct opstack;
+struct tprogram;
 
 /* transient memory blocks */
 extern char *balloc(size_t size);
@@ -27,6 +28,12 @@ void translation_done(void);
 const char *translate(const char *format, const void *userdata,
     const char *vars, variant args[]);
 
+/* compile a template once, then render it many times */
+struct tprogram *translate_compile(const char *format, const char *vars);
+const char *translate_run(const struct tprogram *prog, const void *userdata,
+    variant args[]);
+void translate_free(struct tprogram *prog);
+
 /* eval_x functions */
 typedef void(*evalfun) (struct opstack ** stack, const void *);
 void add_function(const char *symbol, evalfun parse);
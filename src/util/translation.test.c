@@ -0,0 +1,48 @@
+#include "translation.h"
+
+#include <CuTest.h>
+
+#include <stdlib.h>
+
+static void test_translate(CuTest *tc) {
+    variant args[2];
+
+    args[0].v = "Enno";
+    args[1].i = 3;
+    CuAssertStrEquals(tc, "hello world", translate("hello world", NULL, "", args));
+    CuAssertStrEquals(tc, "hello Enno", translate("\"hello $name\"", NULL, "name count", args));
+    CuAssertStrEquals(tc, "Enno has 3", translate("${name} has $int($count)", NULL, "name count", args));
+    CuAssertStrEquals(tc, "4 times", translate("$int($add($count,1)) times", NULL, "name count", args));
+    CuAssertStrEquals(tc, "Enno and 3 others", translate(
+        "\"$name and $if($eq($count,0),\"nobody else\",\"$int($count) others\")\"",
+        NULL, "name count", args));
+    args[1].i = 0;
+    CuAssertStrEquals(tc, "Enno and nobody else", translate(
+        "\"$name and $if($eq($count,0),\"nobody else\",\"$int($count) others\")\"",
+        NULL, "name count", args));
+    CuAssertPtrEquals(tc, NULL, (void *)translate("$unknown", NULL, "name", args));
+    CuAssertPtrEquals(tc, NULL, (void *)translate("$nofunc($name)", NULL, "name", args));
+}
+
+static void test_translate_compiled(CuTest *tc) {
+    struct tprogram *prog;
+    variant args[1];
+
+    prog = translate_compile("\"a$x\\tb\"", "x");
+    CuAssertPtrNotNull(tc, prog);
+    args[0].v = "1";
+    CuAssertStrEquals(tc, "a1\ttb", translate_run(prog, NULL, args));
+    args[0].v = "2";
+    CuAssertStrEquals(tc, "a2\ttb", translate_run(prog, NULL, args));
+    args[0].v = NULL;
+    CuAssertStrEquals(tc, "a\ttb", translate_run(prog, NULL, args));
+    translate_free(prog);
+}
+
+CuSuite *get_translation_suite(void)
+{
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_translate);
+    SUITE_ADD_TEST(suite, test_translate_compiled);
+    return suite;
+}
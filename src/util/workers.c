@@ -0,0 +1,156 @@
+#include "workers.h"
+#include "macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define MAXWORKERS 64
+
+static int num_workers = 1;
+static bool parallel;
+static THREAD_LOCAL bool in_worker;
+static void (**cleanups)(void);
+static int num_cleanups, max_cleanups;
+
+void workers_atexit(void (*cleanup)(void))
+{
+    int i;
+    assert(!parallel);
+    for (i = 0; i != num_cleanups; ++i) {
+        if (cleanups[i] == cleanup) return;
+    }
+    if (num_cleanups == max_cleanups) {
+        void (**grow)(void);
+        max_cleanups = max_cleanups ? max_cleanups * 2 : 8;
+        grow = realloc(cleanups, max_cleanups * sizeof(*cleanups));
+        if (!grow) abort();
+        cleanups = grow;
+    }
+    cleanups[num_cleanups++] = cleanup;
+}
+
+void workers_set_count(int threads)
+{
+    if (threads < 1) threads = 1;
+    if (threads > MAXWORKERS) threads = MAXWORKERS;
+    num_workers = threads;
+}
+
+int workers_count(void)
+{
+    return num_workers;
+}
+
+bool workers_active(void)
+{
+    return in_worker;
+}
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct job_queue {
+    worker_job job;
+    void *udata;
+    int next;
+    int njobs;
+} job_queue;
+
+static void *worker_main(void *arg)
+{
+    job_queue *queue = (job_queue *)arg;
+    int i;
+    in_worker = true;
+    for (;;) {
+        int index;
+        pthread_mutex_lock(&queue_lock);
+        index = queue->next++;
+        pthread_mutex_unlock(&queue_lock);
+        if (index >= queue->njobs) break;
+        queue->job(index, queue->udata);
+    }
+    for (i = 0; i != num_cleanups; ++i) {
+        cleanups[i]();
+    }
+    in_worker = false;
+    return NULL;
+}
+
+void workers_lock(void)
+{
+    if (parallel) {
+        pthread_mutex_lock(&global_lock);
+    }
+}
+
+void workers_unlock(void)
+{
+    if (parallel) {
+        pthread_mutex_unlock(&global_lock);
+    }
+}
+
+void workers_run(int njobs, worker_job job, void *udata)
+{
+    int i, nthreads = num_workers;
+
+    assert(!parallel);
+    if (nthreads > njobs) nthreads = njobs;
+    if (nthreads > 1) {
+        pthread_t threads[MAXWORKERS];
+        job_queue queue;
+        int started = 0;
+
+        queue.job = job;
+        queue.udata = udata;
+        queue.next = 0;
+        queue.njobs = njobs;
+        parallel = true;
+        for (i = 0; i != nthreads; ++i) {
+            if (pthread_create(threads + i, NULL, worker_main, &queue) != 0) {
+                break;
+            }
+            ++started;
+        }
+        if (started == 0) {
+            /* could not create any threads, fall back to serial */
+            parallel = false;
+        }
+        else {
+            for (i = 0; i != started; ++i) {
+                pthread_join(threads[i], NULL);
+            }
+            parallel = false;
+            return;
+        }
+    }
+    for (i = 0; i != njobs; ++i) {
+        job(i, udata);
+    }
+}
+
+#else
+
+void workers_lock(void)
+{
+}
+
+void workers_unlock(void)
+{
+}
+
+void workers_run(int njobs, worker_job job, void *udata)
+{
+    int i;
+    UNUSED_ARG(parallel);
+    for (i = 0; i != njobs; ++i) {
+        job(i, udata);
+    }
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef H_UTIL_WORKERS
+#define H_UTIL_WORKERS
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /* A tiny fork/join pool: workers_run() calls job(index, udata) once
+     * for every index in [0, njobs) and returns when all of them are done.
+     * Jobs are handed out in ascending order, but may complete in any
+     * order. Without thread support, or with a thread count of 1, the
+     * jobs run serially on the calling thread. */
+    typedef void (*worker_job)(int index, void *udata);
+
+    void workers_set_count(int threads);
+    int workers_count(void);
+    void workers_run(int njobs, worker_job job, void *udata);
+
+    /* true while the calling thread is executing a job in parallel mode */
+    bool workers_active(void);
+
+    /* a single global lock for the few places that have to serialize
+     * access to shared state (order database, statistics). It is a no-op
+     * outside of parallel sections. */
+    void workers_lock(void);
+    void workers_unlock(void);
+
+    /* Read and publish a lazily computed int (usually a cache key)
+     * without taking the lock. A thread that reads a key another thread
+     * published with WORKERS_STORE_RELEASE also sees everything that
+     * thread wrote before it. */
+#if defined(_MSC_VER)
+    /* volatile accesses are acquire/release on MSVC (/volatile:ms) */
+#define WORKERS_LOAD_ACQUIRE(p) (*(volatile int *)(p))
+#define WORKERS_STORE_RELEASE(p, v) (*(volatile int *)(p) = (v))
+#else
+#define WORKERS_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define WORKERS_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+    /* register a function that every worker thread calls before it
+     * exits, to release its thread-local buffers. Registering the same
+     * function twice has no effect. Functions are registered on the main
+     * thread, outside of workers_run. */
+    void workers_atexit(void (*cleanup)(void));
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,51 @@
+#include "workers.h"
+
+#include <CuTest.h>
+
+#include <string.h>
+
+#define NJOBS 100
+
+static void square_job(int index, void *udata)
+{
+    int *results = (int *)udata;
+    results[index] = index * index;
+}
+
+static void test_workers_serial(CuTest *tc)
+{
+    int i, results[NJOBS];
+
+    memset(results, 0, sizeof(results));
+    workers_set_count(1);
+    CuAssertIntEquals(tc, 1, workers_count());
+    workers_run(NJOBS, square_job, results);
+    for (i = 0; i != NJOBS; ++i) {
+        CuAssertIntEquals(tc, i * i, results[i]);
+    }
+    CuAssertTrue(tc, !workers_active());
+}
+
+static void test_workers_parallel(CuTest *tc)
+{
+    int i, results[NJOBS];
+
+    memset(results, 0, sizeof(results));
+    workers_set_count(4);
+    CuAssertIntEquals(tc, 4, workers_count());
+    workers_run(NJOBS, square_job, results);
+    for (i = 0; i != NJOBS; ++i) {
+        CuAssertIntEquals(tc, i * i, results[i]);
+    }
+    CuAssertTrue(tc, !workers_active());
+    workers_set_count(0);
+    CuAssertIntEquals(tc, 1, workers_count());
+}
+
+CuSuite *get_workers_suite(void)
+{
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_workers_serial);
+    SUITE_ADD_TEST(suite, test_workers_parallel);
+    return suite;
+}